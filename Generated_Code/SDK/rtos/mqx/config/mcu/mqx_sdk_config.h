@@ -123,6 +123,7 @@
 #endif
 
 /* Additional settings can be defined in the property User Definitions > Definitions of the MQX RTOS component */
+#define MQX_KERNEL_LOGGING             1
   
 
 /* Select MQX configurations according to project settings. */
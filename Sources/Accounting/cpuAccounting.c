@@ -0,0 +1,265 @@
+#include "cpuAccounting.h"
+#include "../Trace/taskTrace.h"
+#include "../Scheduler/templateRegistry.h"
+#include "mqx_inc.h"
+#include <klog.h>
+
+/*=============================================================
+                      PRIVATE TYPES
+ ==============================================================*/
+
+// Defines the running total of one task's CPU time
+typedef struct TaskAccount{
+	_task_id taskId;
+	const char* name;						// Resolved when the account is opened, while the task's template still exists
+	int32_t templateIndex;
+	bool isIdle;
+	uint64_t cycles;						// Cycles charged to the task since it was first dispatched
+	uint64_t reportedCycles;				// The value of cycles at the previous report
+} TaskAccount, * TaskAccountPtr;
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+void __real__klog_context_switch_internal(void);
+void __wrap__klog_context_switch_internal(void);
+void __wrap__klog_isr_start_internal(_mqx_uint vectorNumber);
+void __wrap__klog_isr_end_internal(_mqx_uint vectorNumber);
+static void _chargeElapsedCycles();
+static int32_t _findOrAddAccount(TD_STRUCT_PTR td);
+static const char* _getStaticTemplateName(TASK_TEMPLATE_STRUCT_PTR templatePtr);
+static int32_t _getUserTemplateIndex(TASK_TEMPLATE_STRUCT_PTR templatePtr);
+static bool _isCopyOfTemplate(TASK_TEMPLATE_STRUCT_PTR templatePtr, const TASK_TEMPLATE_STRUCT* original);
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+// Written by the context switch and interrupt hooks. Tasks only touch them with interrupts disabled.
+static TaskAccount g_Accounts[CPU_ACCOUNTING_TASK_MAX];
+static uint32_t g_AccountCount = 0;
+static int32_t g_CurrentAccount = -1;		// The account of the task being run, or -1 if it is untracked
+static uint32_t g_IsrDepth = 0;
+static uint32_t g_LastCycles;				// The cycle clock when time was last charged
+static uint64_t g_TotalCycles = 0;
+static uint64_t g_IsrCycles = 0;
+static uint64_t g_UntrackedCycles = 0;
+
+// Only used by the reporting task
+static uint64_t g_ReportedTotalCycles = 0;
+static uint64_t g_ReportedIsrCycles = 0;
+static uint64_t g_ReportedUntrackedCycles = 0;
+
+static _task_id g_SchedulerTaskId;
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+// Starts charging CPU time to tasks. Jobs created from registered templates are also totalled by template.
+// MQX must be built with MQX_KERNEL_LOGGING and linked with --wrap for the three _klog_*_internal hooks.
+void ca_initializeCpuAccounting(_task_id schedulerTaskId){
+	g_SchedulerTaskId = schedulerTaskId;
+
+	_int_disable();
+	_startCycleClock();
+	g_LastCycles = _readCycleClock();
+	g_CurrentAccount = _findOrAddAccount(_task_get_td(_task_get_id()));
+	_int_enable();
+
+	// The dispatcher only calls the hooks while kernel logging is enabled. No log is created, so nothing
+	// is written to one.
+	_klog_control(KLOG_ENABLED, TRUE);
+}
+
+/*=============================================================
+                       KERNEL HOOKS
+ ==============================================================*/
+
+// Called by the dispatcher, with interrupts disabled, each time it resumes a task
+void __wrap__klog_context_switch_internal(void){
+	KERNEL_DATA_STRUCT_PTR kernel_data;
+	_GET_KERNEL_DATA(kernel_data);
+
+	_chargeElapsedCycles();
+	g_CurrentAccount = _findOrAddAccount(kernel_data->ACTIVE_PTR);
+	tr_traceContextSwitch(kernel_data->ACTIVE_PTR->TASK_ID, g_TotalCycles);
+	__real__klog_context_switch_internal();
+}
+
+// Called by the kernel interrupt dispatcher on entry to each interrupt, including nested ones
+void __wrap__klog_isr_start_internal(_mqx_uint vectorNumber){
+	_chargeElapsedCycles();
+	g_IsrDepth++;
+}
+
+// Called by the kernel interrupt dispatcher on exit from each interrupt
+void __wrap__klog_isr_end_internal(_mqx_uint vectorNumber){
+	_chargeElapsedCycles();
+	if(g_IsrDepth > 0){
+		g_IsrDepth--;
+	}
+}
+
+/*=============================================================
+                    CPU ACCOUNTING INTERFACE
+ ==============================================================*/
+
+// Fills the report with the CPU time used since the previous report. Must only be called from one task.
+void ca_collectCpuUsage(CpuUsageReportPtr report){
+	memset(report, 0, sizeof(CpuUsageReport));
+
+	_int_disable();
+	_chargeElapsedCycles();
+
+	report->TotalCycles = g_TotalCycles - g_ReportedTotalCycles;
+	report->IsrCycles = g_IsrCycles - g_ReportedIsrCycles;
+	report->UntrackedCycles = g_UntrackedCycles - g_ReportedUntrackedCycles;
+	g_ReportedTotalCycles = g_TotalCycles;
+	g_ReportedIsrCycles = g_IsrCycles;
+	g_ReportedUntrackedCycles = g_UntrackedCycles;
+
+	uint32_t i = 0;
+	while(i < g_AccountCount){
+		TaskAccountPtr account = &g_Accounts[i];
+		CpuTaskUsagePtr usage = &report->Tasks[report->TaskCount];
+		usage->TaskId = account->taskId;
+		usage->Name = account->name;
+		usage->TemplateIndex = account->templateIndex;
+		usage->Cycles = account->cycles - account->reportedCycles;
+		report->TaskCount++;
+		if(account->isIdle){
+			report->IdleCycles += usage->Cycles;
+		}
+		account->reportedCycles = account->cycles;
+
+		// Accounts of tasks that have exited are reported one last time, then the last account takes their place
+		if(_task_get_td(account->taskId) == NULL && (int32_t) i != g_CurrentAccount){
+			g_AccountCount--;
+			*account = g_Accounts[g_AccountCount];
+			if(g_CurrentAccount == (int32_t) g_AccountCount){
+				g_CurrentAccount = i;
+			}
+		}
+		else{
+			i++;
+		}
+	}
+	_int_enable();
+
+	for(i = 0; i < report->TaskCount; i++){
+		CpuTaskUsagePtr usage = &report->Tasks[i];
+		if(usage->TaskId == g_SchedulerTaskId){
+			report->SchedulerCycles += usage->Cycles;
+		}
+		if(usage->TemplateIndex >= 0 && usage->TemplateIndex < CPU_ACCOUNTING_TEMPLATE_MAX){
+			report->TemplateCycles[usage->TemplateIndex] += usage->Cycles;
+		}
+	}
+}
+
+// Returns the cycle clock extended to 64 bits, counted from initialization. Interrupts must be disabled.
+uint64_t ca_readCycleTime(){
+	_chargeElapsedCycles();
+	return g_TotalCycles;
+}
+
+// Returns the name of a running task's template, or NULL if the task has exited or its template is not known to be static
+const char* ca_getTaskName(_task_id taskId){
+	TD_STRUCT_PTR td = _task_get_td(taskId);
+	return (td == NULL) ? NULL : _getStaticTemplateName(td->TASK_TEMPLATE_PTR);
+}
+
+// Returns the index of a running task's registered template, or -1 if the task has exited or is not a job
+int32_t ca_getTaskTemplateIndex(_task_id taskId){
+	TD_STRUCT_PTR td = _task_get_td(taskId);
+	return (td == NULL) ? -1 : _getUserTemplateIndex(td->TASK_TEMPLATE_PTR);
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+// Charges the time since the previous charge to the interrupt or task that was running. Interrupts must be disabled.
+static void _chargeElapsedCycles(){
+	uint32_t now = _readCycleClock();
+	uint32_t elapsed = now - g_LastCycles;
+	g_LastCycles = now;
+	g_TotalCycles += elapsed;
+
+	if(g_IsrDepth > 0){
+		g_IsrCycles += elapsed;
+	}
+	else if(g_CurrentAccount >= 0){
+		g_Accounts[g_CurrentAccount].cycles += elapsed;
+	}
+	else{
+		g_UntrackedCycles += elapsed;
+	}
+}
+
+// Returns the task's account, opening one if it has none, or -1 if the table is full. Interrupts must be disabled.
+static int32_t _findOrAddAccount(TD_STRUCT_PTR td){
+	if(td == NULL){
+		return -1;
+	}
+
+	for(uint32_t i = 0; i < g_AccountCount; i++){
+		if(g_Accounts[i].taskId == td->TASK_ID){
+			return i;
+		}
+	}
+
+	if(g_AccountCount == CPU_ACCOUNTING_TASK_MAX){
+		return -1;
+	}
+	KERNEL_DATA_STRUCT_PTR kernel_data;
+	_GET_KERNEL_DATA(kernel_data);
+	TaskAccountPtr account = &g_Accounts[g_AccountCount];
+	account->taskId = td->TASK_ID;
+	account->name = _getStaticTemplateName(td->TASK_TEMPLATE_PTR);
+	account->templateIndex = _getUserTemplateIndex(td->TASK_TEMPLATE_PTR);
+	account->isIdle = _isCopyOfTemplate(td->TASK_TEMPLATE_PTR, &kernel_data->IDLE_TASK_TEMPLATE);
+	account->cycles = 0;
+	account->reportedCycles = 0;
+	return g_AccountCount++;
+}
+
+// Returns the template's name if it is the idle task's, one of the MQX template list's or a registered template.
+// The task using the template must still exist.
+static const char* _getStaticTemplateName(TASK_TEMPLATE_STRUCT_PTR templatePtr){
+	KERNEL_DATA_STRUCT_PTR kernel_data;
+	_GET_KERNEL_DATA(kernel_data);
+
+	if(_isCopyOfTemplate(templatePtr, &kernel_data->IDLE_TASK_TEMPLATE)){
+		return "Idle";
+	}
+	for(TASK_TEMPLATE_STRUCT_PTR listed = kernel_data->INIT.TASK_TEMPLATE_LIST; listed->TASK_TEMPLATE_INDEX != 0; listed++){
+		if(templatePtr == listed){
+			return listed->TASK_NAME;
+		}
+	}
+	int32_t templateIndex = _getUserTemplateIndex(templatePtr);
+	return (templateIndex < 0) ? NULL : dd_get_task_template(templateIndex)->TASK_NAME;
+}
+
+// The task using the template must still exist
+static int32_t _getUserTemplateIndex(TASK_TEMPLATE_STRUCT_PTR templatePtr){
+	uint32_t templateCount = dd_get_template_count();
+	for(uint32_t i = 0; i < templateCount; i++){
+		if(_isCopyOfTemplate(templatePtr, dd_get_task_template(i))){
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Tasks created from a template passed to _task_create, including jobs and the idle task, point at a copy
+// of it kept in their stack block, so templates are matched by content as well as by address. A job's copy
+// carries its own argument as the creation parameter, so only the entry point and name are compared. The
+// template registry keeps names unique.
+static bool _isCopyOfTemplate(TASK_TEMPLATE_STRUCT_PTR templatePtr, const TASK_TEMPLATE_STRUCT* original){
+	return templatePtr == original
+			|| (templatePtr->TASK_ADDRESS == original->TASK_ADDRESS && templatePtr->TASK_NAME == original->TASK_NAME);
+}
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include "cycleClock.h"
+
+#ifndef SOURCES_CPUACCOUNTING_H_
+#define SOURCES_CPUACCOUNTING_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define CPU_ACCOUNTING_TASK_MAX 48			// Tasks beyond this many are charged to UntrackedCycles
+#define CPU_ACCOUNTING_TEMPLATE_MAX 16		// Templates beyond this many are not broken out in reports
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines one task's share of a report
+typedef struct CpuTaskUsage{
+	_task_id TaskId;
+	const char* Name;			// The task's template name, or NULL if its template is not known to be static
+	int32_t TemplateIndex;		// The task's index in the template registry, or -1
+	uint64_t Cycles;
+} CpuTaskUsage, * CpuTaskUsagePtr;
+
+// Defines where the CPU's time went between two reports, in cycle clock counts
+typedef struct CpuUsageReport{
+	uint64_t TotalCycles;		// Everything below adds up to this
+	uint64_t IdleCycles;		// Time in the MQX idle task
+	uint64_t IsrCycles;			// Time in interrupts dispatched by the kernel, including nested interrupts
+	uint64_t SchedulerCycles;	// Time in the scheduler task
+	uint64_t UntrackedCycles;	// Time in tasks that did not fit in the task table
+	uint64_t TemplateCycles[CPU_ACCOUNTING_TEMPLATE_MAX];	// Time in jobs, by registered template
+	uint32_t TaskCount;
+	CpuTaskUsage Tasks[CPU_ACCOUNTING_TASK_MAX];
+} CpuUsageReport, * CpuUsageReportPtr;
+
+/*=============================================================
+                    CPU ACCOUNTING INTERFACE
+ ==============================================================*/
+
+void ca_initializeCpuAccounting(_task_id schedulerTaskId);
+void ca_collectCpuUsage(CpuUsageReportPtr report);
+uint64_t ca_readCycleTime();
+const char* ca_getTaskName(_task_id taskId);
+int32_t ca_getTaskTemplateIndex(_task_id taskId);
+
+#endif
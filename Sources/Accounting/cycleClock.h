@@ -0,0 +1,52 @@
+#include <stdint.h>
+
+#ifndef SOURCES_CYCLECLOCK_H_
+#define SOURCES_CYCLECLOCK_H_
+
+/*=============================================================
+                      CYCLE CLOCK INTERFACE
+ ==============================================================*/
+
+// A free-running 32-bit counter for measuring short intervals. Callers take the difference of two readings,
+// which stays correct across a wrap as long as readings are taken more often than the counter wraps.
+// On the target this is the Cortex-M4 DWT cycle counter, which wraps every 35 s at 120 MHz. Host builds
+// use the monotonic clock in nanoseconds, which wraps every 4.3 s.
+
+#if defined(__arm__) || defined(__ARMCC_VERSION)
+
+#include "fsl_device_registers.h"
+
+static inline void _startCycleClock(){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t _readCycleClock(){
+	return DWT->CYCCNT;
+}
+
+static inline uint32_t _getCycleClockHz(){
+	return SystemCoreClock;
+}
+
+#else
+
+#include <time.h>
+
+static inline void _startCycleClock(){
+}
+
+static inline uint32_t _readCycleClock(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t) now.tv_sec * 1000000000u + now.tv_nsec);
+}
+
+static inline uint32_t _getCycleClockHz(){
+	return 1000000000u;
+}
+
+#endif
+
+#endif
@@ -12,21 +12,21 @@ extern "C" {
 
 void myUART_RxCallback(uint32_t instance, void * uartState)
 {
-	// Allocate an interrupt message
-	InterruptMessagePtr interruptMessage = (InterruptMessagePtr)_msg_alloc(g_InterruptMessagePool);
-	if (interruptMessage == NULL) {
-	 _task_block();
+	// Characters received before the handler has started are discarded
+	HandlerPtr handler = (HandlerPtr) ((uart_state_t*) uartState)->rxCallbackParam;
+	if (handler == NULL) {
+		return;
 	}
 
-	interruptMessage->HEADER.TARGET_QID = _msgq_get_id(0, HANDLER_INTERRUPT_QUEUE_ID);
-	interruptMessage->HEADER.SIZE = sizeof(InterruptMessage);
-	interruptMessage->character = myRxBuff[0];
+	// The driver has stored the character in the handler's own receive buffer
+	_handleUartCharacterReceived(*((uart_state_t*) uartState)->rxBuff, handler);
+}
 
-	// Send the message to the handler
-	bool result = _msgq_send(interruptMessage);
-	if (result != TRUE) {
-		_task_block();
-	}
+void myUART_TxCallback(uint32_t instance, void * uartState)
+{
+	// Advance the driver through the handler's transmit ring
+	uart_state_t* state = (uart_state_t*) uartState;
+	_handleTxRingCharacterSent((TxRingPtr) state->txCallbackParam, state);
 }
 
 #ifdef __cplusplus
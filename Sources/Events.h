@@ -53,6 +53,7 @@ extern "C" {
 
 
 void myUART_RxCallback(uint32_t instance, void * uartState);
+void myUART_TxCallback(uint32_t instance, void * uartState);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,232 @@
+#include "healthMonitor.h"
+#include "../TerminalDriver/handler.h"
+#include "mqx_inc.h"
+#include "message.h"
+#include "msg_prv.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _getMessagePoolUsage(_pool_id pool, MessagePoolUsagePtr usage);
+static void _summarizeWindow(HealthSummaryPtr summary);
+static int32_t _getLatenessPercentile(const uint32_t histogram[], uint32_t count, uint32_t percent);
+static uint32_t _getAllocationLatencyPercentile(const uint32_t histogram[], uint32_t count, uint32_t percent);
+static void _mergePoolPeak(MessagePoolUsagePtr peak, MessagePoolUsagePtr usage);
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+// Only the monitor task writes these, apart from the published summary
+static HealthSample g_Window[HEALTH_WINDOW_SAMPLES];
+static uint32_t g_SampleCount = 0;				// Free-running; the latest sample is at (g_SampleCount - 1) % HEALTH_WINDOW_SAMPLES
+static SchedulerHealthStats g_PreviousStats;
+static HeapAllocatorStats g_PreviousAllocatorStats;
+static uint32_t g_HeapBytes = 0;
+static HealthSummary g_Summary;					// Published with interrupts disabled so readers never see half of it
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void hm_initializeHealthMonitor(){
+	memset(g_Window, 0, sizeof(g_Window));
+	memset(&g_Summary, 0, sizeof(HealthSummary));
+	dd_get_health_stats(&g_PreviousStats);
+	ht_getAllocatorStats(&g_PreviousAllocatorStats);
+}
+
+/*=============================================================
+                    HEALTH MONITOR INTERFACE
+ ==============================================================*/
+
+// Takes one sample and republishes the window's summary. Reads the scheduler's statistics in place and
+// never sends it a message, so a stalled scheduler cannot stall the monitor.
+void hm_sampleHealth(){
+	HealthSamplePtr sample = &g_Window[g_SampleCount % HEALTH_WINDOW_SAMPLES];
+
+	SchedulerHealthStats stats;
+	dd_get_health_stats(&stats);
+	sample->CompletedCount = stats.CompletedCount - g_PreviousStats.CompletedCount;
+	sample->MissedCount = stats.MissedCount - g_PreviousStats.MissedCount;
+	for(int i = 0; i < SCHEDULER_LATENESS_BUCKET_COUNT; i++){
+		sample->LatenessHistogram[i] = stats.LatenessHistogram[i] - g_PreviousStats.LatenessHistogram[i];
+	}
+	sample->ActiveCount = stats.ActiveCount;
+	sample->OverdueCount = stats.OverdueCount;
+	g_PreviousStats = stats;
+
+	SchedulerQueueStats queueStats;
+	dd_get_queue_stats(&queueStats);
+	sample->RequestQueueDepth = queueStats.CurrentDepth;
+
+	_getMessagePoolUsage(_getSchedulerMessagePool(), &sample->SchedulerPool);
+	_getMessagePoolUsage(g_SerialMessagePool, &sample->SerialPool);
+	_getMessagePoolUsage(g_FrameMessagePool, &sample->FramePool);
+
+	HeapUsage heapUsage;
+	ht_getHeapUsage(&heapUsage);
+	sample->HeapFreeBytes = heapUsage.FreeBytes;
+	sample->HeapLargestFreeBytes = heapUsage.LargestFreeBytes;
+	g_HeapBytes = heapUsage.HeapBytes;
+
+	HeapAllocatorStats allocatorStats;
+	ht_getAllocatorStats(&allocatorStats);
+	sample->AllocationCount = allocatorStats.AllocationCount - g_PreviousAllocatorStats.AllocationCount;
+	sample->FailedAllocationCount = allocatorStats.FailedCount - g_PreviousAllocatorStats.FailedCount;
+	for(int i = 0; i < HEAP_LATENCY_BUCKET_COUNT; i++){
+		sample->AllocationLatencyHistogram[i] = allocatorStats.AllocationLatency.Histogram[i]
+				- g_PreviousAllocatorStats.AllocationLatency.Histogram[i];
+	}
+	g_PreviousAllocatorStats = allocatorStats;
+	g_SampleCount++;
+
+	HealthSummary summary;
+	_summarizeWindow(&summary);
+	_int_disable();
+	g_Summary = summary;
+	_int_enable();
+}
+
+// Copies the summary of the most recent window. May be called from any task.
+void hm_getHealthSummary(HealthSummaryPtr summary){
+	_int_disable();
+	*summary = g_Summary;
+	_int_enable();
+}
+
+void hm_printHealthSummary(HealthSummaryPtr summary){
+	printf("[Monitor] %u s: jobs %u done, %u missed (%u.%u %%), lateness p50/p90/p99 %d/%d/%d us\n",
+			summary->SampleCount * HEALTH_SAMPLE_PERIOD_MS / 1000,
+			summary->CompletedCount, summary->MissedCount, summary->MissPermille / 10, summary->MissPermille % 10,
+			summary->LatenessP50Us, summary->LatenessP90Us, summary->LatenessP99Us);
+	printf(" Peak active: %u, overdue: %u, request queue: %u; pools sched %u/%u serial %u/%u frame %u/%u\n",
+			summary->MaxActiveCount, summary->MaxOverdueCount, summary->MaxRequestQueueDepth,
+			summary->SchedulerPool.InUse, summary->SchedulerPool.Size, summary->SerialPool.InUse, summary->SerialPool.Size,
+			summary->FramePool.InUse, summary->FramePool.Size);
+	printf(" Heap min free: %u of %u bytes, min largest block: %u bytes, fragmentation: %u.%u %%\n",
+			summary->MinHeapFreeBytes, summary->HeapBytes, summary->MinHeapLargestFreeBytes,
+			summary->FragmentationPermille / 10, summary->FragmentationPermille % 10);
+	printf(" Allocations: %u, failed: %u, latency p99: %u ns\n",
+			summary->AllocationCount, summary->FailedAllocationCount, summary->AllocationLatencyP99Ns);
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+static void _getMessagePoolUsage(_pool_id pool, MessagePoolUsagePtr usage){
+	MSGPOOL_STRUCT_PTR msgpool = (MSGPOOL_STRUCT_PTR) pool;
+	if(msgpool == NULL){
+		usage->InUse = 0;
+		usage->Size = 0;
+		return;
+	}
+
+	_int_disable();
+	usage->Size = msgpool->MAX;
+	usage->InUse = msgpool->MAX - msgpool->SIZE;
+	_int_enable();
+}
+
+static void _summarizeWindow(HealthSummaryPtr summary){
+	memset(summary, 0, sizeof(HealthSummary));
+	summary->SampleCount = (g_SampleCount < HEALTH_WINDOW_SAMPLES) ? g_SampleCount : HEALTH_WINDOW_SAMPLES;
+	summary->HeapBytes = g_HeapBytes;
+	summary->MinHeapFreeBytes = UINT32_MAX;
+	summary->MinHeapLargestFreeBytes = UINT32_MAX;
+
+	uint32_t histogram[SCHEDULER_LATENESS_BUCKET_COUNT] = {0};
+	uint32_t allocationHistogram[HEAP_LATENCY_BUCKET_COUNT] = {0};
+	for(uint32_t i = 0; i < summary->SampleCount; i++){
+		HealthSamplePtr sample = &g_Window[i];
+		summary->CompletedCount += sample->CompletedCount;
+		summary->MissedCount += sample->MissedCount;
+		for(int j = 0; j < SCHEDULER_LATENESS_BUCKET_COUNT; j++){
+			histogram[j] += sample->LatenessHistogram[j];
+		}
+		summary->AllocationCount += sample->AllocationCount;
+		summary->FailedAllocationCount += sample->FailedAllocationCount;
+		for(int j = 0; j < HEAP_LATENCY_BUCKET_COUNT; j++){
+			allocationHistogram[j] += sample->AllocationLatencyHistogram[j];
+		}
+
+		if(sample->ActiveCount > summary->MaxActiveCount){
+			summary->MaxActiveCount = sample->ActiveCount;
+		}
+		if(sample->OverdueCount > summary->MaxOverdueCount){
+			summary->MaxOverdueCount = sample->OverdueCount;
+		}
+		if(sample->RequestQueueDepth > summary->MaxRequestQueueDepth){
+			summary->MaxRequestQueueDepth = sample->RequestQueueDepth;
+		}
+		_mergePoolPeak(&summary->SchedulerPool, &sample->SchedulerPool);
+		_mergePoolPeak(&summary->SerialPool, &sample->SerialPool);
+		_mergePoolPeak(&summary->FramePool, &sample->FramePool);
+		if(sample->HeapFreeBytes < summary->MinHeapFreeBytes){
+			summary->MinHeapFreeBytes = sample->HeapFreeBytes;
+		}
+		if(sample->HeapLargestFreeBytes < summary->MinHeapLargestFreeBytes){
+			summary->MinHeapLargestFreeBytes = sample->HeapLargestFreeBytes;
+		}
+	}
+
+	uint32_t outcomes = summary->CompletedCount + summary->MissedCount;
+	summary->MissPermille = (outcomes == 0) ? 0 : (summary->MissedCount * 1000) / outcomes;
+	summary->LatenessP50Us = _getLatenessPercentile(histogram, summary->CompletedCount, 50);
+	summary->LatenessP90Us = _getLatenessPercentile(histogram, summary->CompletedCount, 90);
+	summary->LatenessP99Us = _getLatenessPercentile(histogram, summary->CompletedCount, 99);
+	summary->AllocationLatencyP99Ns = _getAllocationLatencyPercentile(allocationHistogram,
+			summary->AllocationCount + summary->FailedAllocationCount, 99);
+
+	HealthSamplePtr latest = &g_Window[(g_SampleCount - 1) % HEALTH_WINDOW_SAMPLES];
+	HeapUsage latestUsage = { g_HeapBytes, latest->HeapFreeBytes, latest->HeapLargestFreeBytes, 0 };
+	summary->FragmentationPermille = ht_getFragmentationPermille(&latestUsage);
+}
+
+// Returns the upper edge of the bucket the percentile falls in, or the last edge if it falls in the last bucket
+static int32_t _getLatenessPercentile(const uint32_t histogram[], uint32_t count, uint32_t percent){
+	if(count == 0){
+		return 0;
+	}
+
+	uint32_t rank = (count * percent + 99) / 100;
+	uint32_t seen = 0;
+	for(int i = 0; i < SCHEDULER_LATENESS_BUCKET_COUNT - 1; i++){
+		seen += histogram[i];
+		if(seen >= rank){
+			return SCHEDULER_LATENESS_EDGES_US[i];
+		}
+	}
+	return SCHEDULER_LATENESS_EDGES_US[SCHEDULER_LATENESS_BUCKET_COUNT - 2];
+}
+
+// Returns the upper edge of the bucket the percentile falls in, in nanoseconds, or the last edge if it falls in
+// the last bucket
+static uint32_t _getAllocationLatencyPercentile(const uint32_t histogram[], uint32_t count, uint32_t percent){
+	if(count == 0){
+		return 0;
+	}
+
+	uint32_t rank = (count * percent + 99) / 100;
+	uint32_t seen = 0;
+	int bucket = 0;
+	while(bucket < HEAP_LATENCY_BUCKET_COUNT - 2){
+		seen += histogram[bucket];
+		if(seen >= rank){
+			break;
+		}
+		bucket++;
+	}
+	return ht_convertCyclesToNanoseconds((uint64_t) HEAP_LATENCY_FIRST_BUCKET_CYCLES << bucket);
+}
+
+static void _mergePoolPeak(MessagePoolUsagePtr peak, MessagePoolUsagePtr usage){
+	if(usage->InUse > peak->InUse){
+		peak->InUse = usage->InUse;
+	}
+	if(usage->Size > peak->Size){
+		peak->Size = usage->Size;
+	}
+}
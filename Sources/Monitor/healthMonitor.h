@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include "../Scheduler/scheduler.h"
+#include "heapTelemetry.h"
+
+#ifndef SOURCES_HEALTHMONITOR_H_
+#define SOURCES_HEALTHMONITOR_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define HEALTH_SAMPLE_PERIOD_MS 1000	// Milliseconds between samples
+#define HEALTH_WINDOW_SAMPLES 10		// Summaries cover this many of the most recent samples
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a message pool's usage. Size grows with the pool, up to its limit.
+typedef struct MessagePoolUsage{
+	uint32_t InUse;
+	uint32_t Size;
+} MessagePoolUsage, * MessagePoolUsagePtr;
+
+// Defines the system's health over one sample period. Counts cover the period; depths and sizes are taken
+// at the end of it.
+typedef struct HealthSample{
+	uint32_t CompletedCount;
+	uint32_t MissedCount;
+	uint32_t LatenessHistogram[SCHEDULER_LATENESS_BUCKET_COUNT];
+	uint32_t ActiveCount;
+	uint32_t OverdueCount;
+	uint32_t RequestQueueDepth;
+	MessagePoolUsage SchedulerPool;
+	MessagePoolUsage SerialPool;
+	MessagePoolUsage FramePool;
+	uint32_t HeapFreeBytes;
+	uint32_t HeapLargestFreeBytes;
+	uint32_t AllocationCount;
+	uint32_t FailedAllocationCount;
+	uint32_t AllocationLatencyHistogram[HEAP_LATENCY_BUCKET_COUNT];
+} HealthSample, * HealthSamplePtr;
+
+// Defines the system's health over the rolling window. Depths and pool usage are the window's peaks and heap
+// figures are its low points.
+typedef struct HealthSummary{
+	uint32_t SampleCount;					// The number of samples in the window
+	uint32_t CompletedCount;
+	uint32_t MissedCount;
+	uint32_t MissPermille;					// Missed jobs per thousand jobs that completed or missed
+	int32_t LatenessP50Us;					// Percentiles are the upper edge of the bucket they fall in
+	int32_t LatenessP90Us;
+	int32_t LatenessP99Us;
+	uint32_t MaxActiveCount;
+	uint32_t MaxOverdueCount;
+	uint32_t MaxRequestQueueDepth;
+	MessagePoolUsage SchedulerPool;
+	MessagePoolUsage SerialPool;
+	MessagePoolUsage FramePool;
+	uint32_t HeapBytes;
+	uint32_t MinHeapFreeBytes;
+	uint32_t MinHeapLargestFreeBytes;
+	uint32_t FragmentationPermille;			// How much of the free heap is outside the largest free block, latest sample
+	uint32_t AllocationCount;
+	uint32_t FailedAllocationCount;
+	uint32_t AllocationLatencyP99Ns;		// The upper edge of the latency bucket the percentile falls in
+} HealthSummary, * HealthSummaryPtr;
+
+/*=============================================================
+                    HEALTH MONITOR INTERFACE
+ ==============================================================*/
+
+void hm_initializeHealthMonitor();
+void hm_sampleHealth();
+void hm_getHealthSummary(HealthSummaryPtr summary);
+void hm_printHealthSummary(HealthSummaryPtr summary);
+
+#endif
@@ -0,0 +1,193 @@
+#include "heapTelemetry.h"
+#include "../Accounting/cycleClock.h"
+#include "mqx_inc.h"
+#include "lwmem.h"
+#include "lwmem_prv.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void __real_free(void* pointer);
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void __wrap_free(void* pointer);
+static void _recordAllocation(size_t size, void* pointer, uint32_t elapsedCycles);
+static void _recordLatency(HeapLatencyStatsPtr latency, uint32_t elapsedCycles);
+static uint32_t _getSizeClass(size_t size);
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+// Written by whichever task calls the allocator, with interrupts disabled
+static HeapAllocatorStats g_Stats;
+
+/*=============================================================
+                       ALLOCATOR HOOKS
+ ==============================================================*/
+
+// The firmware is linked with --wrap for malloc, calloc and free, so every call the firmware makes passes
+// through these on its way to the MQX heap. The C library allocates through the reentrant _malloc_r and
+// _free_r instead, which the wrap does not reach, so its own allocations are not recorded. Latencies read
+// zero until CPU accounting starts the cycle clock.
+void* __wrap_malloc(size_t size){
+	uint32_t start = _readCycleClock();
+	void* pointer = __real_malloc(size);
+	_recordAllocation(size, pointer, _readCycleClock() - start);
+	return pointer;
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+	uint32_t start = _readCycleClock();
+	void* pointer = __real_calloc(count, size);
+	_recordAllocation(count * size, pointer, _readCycleClock() - start);
+	return pointer;
+}
+
+void __wrap_free(void* pointer){
+	if(pointer == NULL){
+		__real_free(pointer);
+		return;
+	}
+
+	uint32_t blockBytes = _lwmem_get_size(pointer);
+	uint32_t start = _readCycleClock();
+	__real_free(pointer);
+	uint32_t elapsedCycles = _readCycleClock() - start;
+
+	_int_disable();
+	g_Stats.FreeCount++;
+	g_Stats.LiveBytes = (blockBytes > g_Stats.LiveBytes) ? 0 : g_Stats.LiveBytes - blockBytes;
+	_recordLatency(&g_Stats.FreeLatency, elapsedCycles);
+	_int_enable();
+}
+
+/*=============================================================
+                    HEAP TELEMETRY INTERFACE
+ ==============================================================*/
+
+void ht_getAllocatorStats(HeapAllocatorStatsPtr stats){
+	_int_disable();
+	*stats = g_Stats;
+	_int_enable();
+}
+
+// Walks the default heap's free list the way _lwmem_get_free does: interrupts are enabled between blocks, and
+// the walk restarts if an allocation or free moved the pool's allocation pointer in the meantime
+void ht_getHeapUsage(HeapUsagePtr usage){
+	LWMEM_POOL_STRUCT_PTR pool = (LWMEM_POOL_STRUCT_PTR) _lwmem_get_system_pool_id();
+	usage->HeapBytes = (uint8_t*) pool->POOL_ALLOC_END_PTR - (uint8_t*) pool->POOL_ALLOC_START_PTR;
+
+	_int_disable();
+	LWMEM_BLOCK_STRUCT_PTR block = (LWMEM_BLOCK_STRUCT_PTR) pool->POOL_FREE_LIST_PTR;
+	usage->FreeBytes = 0;
+	usage->LargestFreeBytes = 0;
+	usage->FreeBlockCount = 0;
+	while(block != NULL){
+		pool->POOL_ALLOC_PTR = block;
+		_int_enable();
+		_int_disable();
+		if(block != pool->POOL_ALLOC_PTR){
+			block = (LWMEM_BLOCK_STRUCT_PTR) pool->POOL_FREE_LIST_PTR;
+			usage->FreeBytes = 0;
+			usage->LargestFreeBytes = 0;
+			usage->FreeBlockCount = 0;
+			continue;
+		}
+
+		usage->FreeBytes += block->BLOCKSIZE;
+		usage->FreeBlockCount++;
+		if(block->BLOCKSIZE > usage->LargestFreeBytes){
+			usage->LargestFreeBytes = block->BLOCKSIZE;
+		}
+		block = (LWMEM_BLOCK_STRUCT_PTR) block->U.NEXTBLOCK;
+	}
+	_int_enable();
+}
+
+// Returns how much of the free heap lies outside the largest free block, per thousand
+uint32_t ht_getFragmentationPermille(HeapUsagePtr usage){
+	return (usage->FreeBytes == 0) ? 0 : 1000 - (uint32_t)(((uint64_t) usage->LargestFreeBytes * 1000) / usage->FreeBytes);
+}
+
+uint32_t ht_convertCyclesToNanoseconds(uint64_t cycles){
+	return (uint32_t)((cycles * 1000000000u) / _getCycleClockHz());
+}
+
+void ht_printHeapReport(HeapAllocatorStatsPtr stats, HeapUsagePtr usage){
+	uint32_t fragmentation = ht_getFragmentationPermille(usage);
+	printf("[Heap] Free: %u of %u bytes in %u blocks, largest block: %u bytes, fragmentation: %u.%u %%\n",
+			usage->FreeBytes, usage->HeapBytes, usage->FreeBlockCount, usage->LargestFreeBytes,
+			fragmentation / 10, fragmentation % 10);
+	printf(" Allocations: %u, failed: %u, frees: %u, live: %u bytes, peak live: %u bytes\n",
+			stats->AllocationCount, stats->FailedCount, stats->FreeCount, stats->LiveBytes, stats->PeakLiveBytes);
+
+	printf(" Requests by size:\n");
+	for(int i = 0; i < HEAP_SIZE_CLASS_COUNT; i++){
+		if(i < HEAP_SIZE_CLASS_COUNT - 1){
+			printf("  <= %5u bytes: %u\n", HEAP_SIZE_CLASS_FIRST_BYTES << i, stats->SizeClassCounts[i]);
+		} else {
+			printf("  >  %5u bytes: %u\n", HEAP_SIZE_CLASS_FIRST_BYTES << (i - 1), stats->SizeClassCounts[i]);
+		}
+	}
+
+	uint32_t allocationCalls = stats->AllocationCount + stats->FailedCount;
+	uint64_t averageAllocation = (allocationCalls == 0) ? 0 : stats->AllocationLatency.TotalCycles / allocationCalls;
+	uint64_t averageFree = (stats->FreeCount == 0) ? 0 : stats->FreeLatency.TotalCycles / stats->FreeCount;
+	printf(" Allocation latency: avg %u ns, max %u ns; free latency: avg %u ns, max %u ns\n",
+			ht_convertCyclesToNanoseconds(averageAllocation), ht_convertCyclesToNanoseconds(stats->AllocationLatency.MaxCycles),
+			ht_convertCyclesToNanoseconds(averageFree), ht_convertCyclesToNanoseconds(stats->FreeLatency.MaxCycles));
+	printf(" %16s %12s %12s\n", "Latency", "Allocations", "Frees");
+	for(int i = 0; i < HEAP_LATENCY_BUCKET_COUNT; i++){
+		uint32_t edge = ht_convertCyclesToNanoseconds(HEAP_LATENCY_FIRST_BUCKET_CYCLES << ((i < HEAP_LATENCY_BUCKET_COUNT - 1) ? i : i - 1));
+		printf("  %s %8u ns %12u %12u\n", (i < HEAP_LATENCY_BUCKET_COUNT - 1) ? "< " : ">=", edge,
+				stats->AllocationLatency.Histogram[i], stats->FreeLatency.Histogram[i]);
+	}
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+static void _recordAllocation(size_t size, void* pointer, uint32_t elapsedCycles){
+	uint32_t blockBytes = (pointer == NULL) ? 0 : _lwmem_get_size(pointer);
+
+	_int_disable();
+	if(pointer == NULL){
+		g_Stats.FailedCount++;
+	}
+	else{
+		g_Stats.AllocationCount++;
+		g_Stats.SizeClassCounts[_getSizeClass(size)]++;
+		g_Stats.LiveBytes += blockBytes;
+		if(g_Stats.LiveBytes > g_Stats.PeakLiveBytes){
+			g_Stats.PeakLiveBytes = g_Stats.LiveBytes;
+		}
+	}
+	_recordLatency(&g_Stats.AllocationLatency, elapsedCycles);
+	_int_enable();
+}
+
+// Interrupts must be disabled
+static void _recordLatency(HeapLatencyStatsPtr latency, uint32_t elapsedCycles){
+	uint32_t bucket = 0;
+	while(bucket < HEAP_LATENCY_BUCKET_COUNT - 1 && elapsedCycles >= ((uint32_t) HEAP_LATENCY_FIRST_BUCKET_CYCLES << bucket)){
+		bucket++;
+	}
+	latency->Histogram[bucket]++;
+	latency->TotalCycles += elapsedCycles;
+	if(elapsedCycles > latency->MaxCycles){
+		latency->MaxCycles = elapsedCycles;
+	}
+}
+
+static uint32_t _getSizeClass(size_t size){
+	uint32_t sizeClass = 0;
+	while(sizeClass < HEAP_SIZE_CLASS_COUNT - 1 && size > ((size_t) HEAP_SIZE_CLASS_FIRST_BYTES << sizeClass)){
+		sizeClass++;
+	}
+	return sizeClass;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_HEAPTELEMETRY_H_
+#define SOURCES_HEAPTELEMETRY_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+// Size class 0 counts requests of up to 16 bytes and each later class doubles the bound, so the last class
+// counts every request over 2 KB
+#define HEAP_SIZE_CLASS_COUNT 9
+#define HEAP_SIZE_CLASS_FIRST_BYTES 16
+
+// Latency bucket 0 counts calls under 64 cycles and each later bucket doubles the bound, so the last bucket
+// counts every call of 64K cycles or more
+#define HEAP_LATENCY_BUCKET_COUNT 12
+#define HEAP_LATENCY_FIRST_BUCKET_CYCLES 64
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines the time taken by one kind of heap call, in cycle clock counts
+typedef struct HeapLatencyStats{
+	uint32_t Histogram[HEAP_LATENCY_BUCKET_COUNT];
+	uint64_t TotalCycles;
+	uint32_t MaxCycles;
+} HeapLatencyStats, * HeapLatencyStatsPtr;
+
+// Defines the malloc, calloc and free calls made since startup
+typedef struct HeapAllocatorStats{
+	uint32_t AllocationCount;							// Successful malloc and calloc calls
+	uint32_t FailedCount;								// Calls that returned NULL
+	uint32_t FreeCount;
+	uint32_t SizeClassCounts[HEAP_SIZE_CLASS_COUNT];	// Successful allocations by requested size
+	uint32_t LiveBytes;									// Bytes in blocks allocated and not yet freed
+	uint32_t PeakLiveBytes;
+	HeapLatencyStats AllocationLatency;
+	HeapLatencyStats FreeLatency;
+} HeapAllocatorStats, * HeapAllocatorStatsPtr;
+
+// Defines the state of the default heap, which also holds task stacks and message pools
+typedef struct HeapUsage{
+	uint32_t HeapBytes;
+	uint32_t FreeBytes;
+	uint32_t LargestFreeBytes;
+	uint32_t FreeBlockCount;
+} HeapUsage, * HeapUsagePtr;
+
+/*=============================================================
+                    HEAP TELEMETRY INTERFACE
+ ==============================================================*/
+
+void ht_getAllocatorStats(HeapAllocatorStatsPtr stats);
+void ht_getHeapUsage(HeapUsagePtr usage);
+uint32_t ht_getFragmentationPermille(HeapUsagePtr usage);
+uint32_t ht_convertCyclesToNanoseconds(uint64_t cycles);
+void ht_printHeapReport(HeapAllocatorStatsPtr stats, HeapUsagePtr usage);
+
+#endif
@@ -0,0 +1,197 @@
+#include "stackMonitor.h"
+#include "../Accounting/cpuAccounting.h"
+#include "../Scheduler/templateRegistry.h"
+#include "mqx_inc.h"
+#include <string.h>
+
+// Stacks are painted with MQX_STACK_MONITOR_VALUE by the kernel when each task is created, and the
+// kernel logging component provides the scans
+#if !MQX_MONITOR_STACK || !MQX_KERNEL_LOGGING
+#error The stack monitor needs MQX_MONITOR_STACK and MQX_KERNEL_LOGGING
+#endif
+
+/*=============================================================
+                      PRIVATE TYPES
+ ==============================================================*/
+
+// Defines the stacks measured for one job template as its jobs finished
+typedef struct TemplateStackHistory{
+	uint32_t sampleCount;
+	uint32_t maxUsedBytes;
+} TemplateStackHistory, * TemplateStackHistoryPtr;
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _addRunningTask(StackUsageReportPtr report, TD_STRUCT_PTR td, uint32_t templateCount);
+static StackUsageEntryPtr _findOrAddNamedEntry(StackUsageReportPtr report, const char* name, uint32_t templateCount);
+static uint32_t _getRecommendedStackSize(uint32_t usedBytes);
+static uint32_t _getTemplateCount();
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+// Written by the scheduler as jobs are deleted and read by reports, both with interrupts disabled
+static TemplateStackHistory g_History[STACK_MONITOR_TEMPLATE_MAX];
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void sm_initializeStackMonitor(){
+	memset(g_History, 0, sizeof(g_History));
+}
+
+/*=============================================================
+                    STACK MONITOR INTERFACE
+ ==============================================================*/
+
+// Scans a job's stack for its high-water mark and adds it to its template's history. Called by the scheduler
+// just before the job is destroyed.
+void sm_recordJobStackUsage(_task_id jobId){
+	int32_t templateIndex = ca_getTaskTemplateIndex(jobId);
+	_mem_size stackBytes;
+	_mem_size usedBytes;
+	if(templateIndex < 0 || templateIndex >= (int32_t) _getTemplateCount()
+			|| _klog_get_task_stack_usage(jobId, &stackBytes, &usedBytes) != MQX_OK){
+		return;
+	}
+
+	TemplateStackHistoryPtr history = &g_History[templateIndex];
+	_int_disable();
+	history->sampleCount++;
+	if(usedBytes > history->maxUsedBytes){
+		history->maxUsedBytes = usedBytes;
+	}
+	_int_enable();
+}
+
+// Reports each job template's history together with its running jobs, then every other running task grouped
+// by name, and recommends a stack size for each
+void sm_collectStackUsage(StackUsageReportPtr report){
+	memset(report, 0, sizeof(StackUsageReport));
+
+	_mem_size stackBytes;
+	_mem_size usedBytes;
+	if(_klog_get_interrupt_stack_usage(&stackBytes, &usedBytes) == MQX_OK){
+		report->InterruptStackBytes = stackBytes;
+		report->InterruptUsedBytes = usedBytes;
+	}
+
+	uint32_t templateCount = _getTemplateCount();
+	_int_disable();
+	for(uint32_t i = 0; i < templateCount; i++){
+		const TaskTemplateInfo* info = dd_get_template_info(i);
+		StackUsageEntryPtr entry = &report->Entries[report->EntryCount++];
+		entry->Name = info->Name;
+		entry->TemplateIndex = i;
+		entry->StackBytes = info->StackSize;
+		entry->SampleCount = g_History[i].sampleCount;
+		entry->MaxUsedBytes = g_History[i].maxUsedBytes;
+	}
+	_int_enable();
+
+	// Holding the task creation semaphore keeps tasks, and the template copies in their stack blocks, from
+	// being destroyed during the walk
+	KERNEL_DATA_STRUCT_PTR kernel_data;
+	_GET_KERNEL_DATA(kernel_data);
+	_lwsem_wait((LWSEM_STRUCT_PTR) &kernel_data->TASK_CREATE_LWSEM);
+	TD_STRUCT_PTR td = (TD_STRUCT_PTR)((unsigned char*) kernel_data->TD_LIST.NEXT - FIELD_OFFSET(TD_STRUCT, TD_LIST_INFO));
+	for(_mqx_uint remaining = _QUEUE_GET_SIZE(&kernel_data->TD_LIST); remaining > 0 && td != NULL; remaining--){
+		_addRunningTask(report, td, templateCount);
+		td = (TD_STRUCT_PTR)((unsigned char*) td->TD_LIST_INFO.NEXT - FIELD_OFFSET(TD_STRUCT, TD_LIST_INFO));
+	}
+	_lwsem_post((LWSEM_STRUCT_PTR) &kernel_data->TASK_CREATE_LWSEM);
+
+	for(uint32_t i = 0; i < report->EntryCount; i++){
+		StackUsageEntryPtr entry = &report->Entries[i];
+		entry->RecommendedBytes = (entry->SampleCount == 0) ? 0 : _getRecommendedStackSize(entry->MaxUsedBytes);
+	}
+}
+
+void sm_printStackUsageReport(StackUsageReportPtr report){
+	printf("[Stack Monitor] Interrupt stack: %u of %u bytes used\n", report->InterruptUsedBytes, report->InterruptStackBytes);
+	printf(" %-20s %6s %6s %8s %9s %12s %8s\n", "Task", "Size", "Tasks", "Samples", "Max used", "Recommended", "Saving");
+	for(uint32_t i = 0; i < report->EntryCount; i++){
+		StackUsageEntryPtr entry = &report->Entries[i];
+		if(entry->SampleCount == 0){
+			printf(" %-20s %6u %6u %8u %9s %12s %8s\n", entry->Name, entry->StackBytes, entry->TaskCount, 0, "-", "-", "-");
+			continue;
+		}
+		printf(" %-20s %6u %6u %8u %9u %12u %8d\n", entry->Name, entry->StackBytes, entry->TaskCount, entry->SampleCount,
+				entry->MaxUsedBytes, entry->RecommendedBytes, (int32_t) entry->StackBytes - (int32_t) entry->RecommendedBytes);
+	}
+	printf(" Recommended sizes add %u %% (at least %u bytes) to the deepest use seen. Savings are per task.\n",
+			STACK_MONITOR_MARGIN_PERCENT, STACK_MONITOR_MARGIN_MIN_BYTES);
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+// The task creation semaphore must be held
+static void _addRunningTask(StackUsageReportPtr report, TD_STRUCT_PTR td, uint32_t templateCount){
+	_mem_size stackBytes;
+	_mem_size usedBytes;
+	if(_klog_get_task_stack_usage_internal(td, &stackBytes, &usedBytes) != MQX_OK){
+		return;
+	}
+
+	int32_t templateIndex = ca_getTaskTemplateIndex(td->TASK_ID);
+	StackUsageEntryPtr entry;
+	if(templateIndex >= 0 && templateIndex < (int32_t) templateCount){
+		entry = &report->Entries[templateIndex];
+	}
+	else{
+		const char* name = td->TASK_TEMPLATE_PTR->TASK_NAME;
+		entry = _findOrAddNamedEntry(report, (name == NULL) ? "Unnamed" : name, templateCount);
+		if(entry == NULL){
+			return;
+		}
+		if(td->TASK_TEMPLATE_PTR->TASK_STACKSIZE > entry->StackBytes){
+			entry->StackBytes = td->TASK_TEMPLATE_PTR->TASK_STACKSIZE;
+		}
+	}
+
+	entry->TaskCount++;
+	entry->SampleCount++;
+	if(usedBytes > entry->MaxUsedBytes){
+		entry->MaxUsedBytes = usedBytes;
+	}
+}
+
+// Returns NULL if the report is full
+static StackUsageEntryPtr _findOrAddNamedEntry(StackUsageReportPtr report, const char* name, uint32_t templateCount){
+	for(uint32_t i = templateCount; i < report->EntryCount; i++){
+		if(strcmp(report->Entries[i].Name, name) == 0){
+			return &report->Entries[i];
+		}
+	}
+
+	if(report->EntryCount == STACK_MONITOR_ENTRY_MAX){
+		return NULL;
+	}
+	StackUsageEntryPtr entry = &report->Entries[report->EntryCount++];
+	entry->Name = name;
+	entry->TemplateIndex = -1;
+	return entry;
+}
+
+// The margin covers paths the measured tasks never took, such as an exception frame pushed at their deepest point
+static uint32_t _getRecommendedStackSize(uint32_t usedBytes){
+	uint32_t margin = usedBytes * STACK_MONITOR_MARGIN_PERCENT / 100;
+	if(margin < STACK_MONITOR_MARGIN_MIN_BYTES){
+		margin = STACK_MONITOR_MARGIN_MIN_BYTES;
+	}
+
+	uint32_t recommended = (usedBytes + margin + STACK_MONITOR_ALIGNMENT - 1) & ~(STACK_MONITOR_ALIGNMENT - 1);
+	return (recommended < PSP_MINSTACKSIZE) ? PSP_MINSTACKSIZE : recommended;
+}
+
+// Templates registered beyond STACK_MONITOR_TEMPLATE_MAX are reported with the other tasks
+static uint32_t _getTemplateCount(){
+	uint32_t templateCount = dd_get_template_count();
+	return (templateCount < STACK_MONITOR_TEMPLATE_MAX) ? templateCount : STACK_MONITOR_TEMPLATE_MAX;
+}
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_STACKMONITOR_H_
+#define SOURCES_STACKMONITOR_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define STACK_MONITOR_TEMPLATE_MAX 16			// Job templates beyond this many are reported with the other tasks
+#define STACK_MONITOR_ENTRY_MAX 32				// Tasks with names beyond this many are left out of reports
+#define STACK_MONITOR_MARGIN_PERCENT 25			// Recommended sizes add this much to the deepest use seen...
+#define STACK_MONITOR_MARGIN_MIN_BYTES 64		// ...or this many bytes, whichever is larger
+#define STACK_MONITOR_ALIGNMENT 8				// Recommended sizes are rounded up to a multiple of this
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines the stack usage of a job template, or of every running task with the same name
+typedef struct StackUsageEntry{
+	const char* Name;
+	int32_t TemplateIndex;			// The registered template, or -1 for other tasks
+	uint32_t StackBytes;			// The stack size the template asks for
+	uint32_t TaskCount;				// The number of these tasks running when the report was made
+	uint32_t SampleCount;			// The number of stacks measured: finished jobs and running tasks
+	uint32_t MaxUsedBytes;			// The deepest any of them reached
+	uint32_t RecommendedBytes;		// The deepest use plus the safety margin, or 0 if nothing was measured
+} StackUsageEntry, * StackUsageEntryPtr;
+
+typedef struct StackUsageReport{
+	uint32_t InterruptStackBytes;
+	uint32_t InterruptUsedBytes;
+	uint32_t EntryCount;
+	StackUsageEntry Entries[STACK_MONITOR_ENTRY_MAX];
+} StackUsageReport, * StackUsageReportPtr;
+
+/*=============================================================
+                    STACK MONITOR INTERFACE
+ ==============================================================*/
+
+void sm_initializeStackMonitor();
+void sm_recordJobStackUsage(_task_id jobId);
+void sm_collectStackUsage(StackUsageReportPtr report);
+void sm_printStackUsageReport(StackUsageReportPtr report);
+
+#endif
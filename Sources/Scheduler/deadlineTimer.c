@@ -0,0 +1,164 @@
+#include "deadlineTimer.h"
+
+/*=============================================================
+                     LOCAL GLOBAL VARIABLES
+ ==============================================================*/
+
+static _queue_id g_RequestQueue;					// The scheduler's request queue, notified when a deadline expires
+static _pool_id g_MessagePool;						// The pool expiry notifications are allocated from
+static LWTIMER_PERIOD_STRUCT g_TimerPeriod;			// The lightweight timer queue driving the one-shot deadline timer
+static LWTIMER_STRUCT g_Timer;						// The one-shot deadline timer
+static bool g_TimerQueueExists;						// Whether g_TimerPeriod is currently registered with the kernel
+static volatile _task_id g_ArmedTaskId;				// The job the timer is armed for, or MQX_NULL_TASK_ID
+static MQX_TICK_STRUCT g_ArmedDeadline;				// The deadline the timer is armed for
+static DeadlineTimerStats g_Stats;					// Enforcement statistics
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _handleDeadlineTimerExpired(void* parameter);
+static void _notifyScheduler(_task_id taskId);
+static void _recordEnforcementLatency();
+static uint64_t _getWholeTicks(const MQX_TICK_STRUCT* ticks);
+
+/*=============================================================
+                   DEADLINE TIMER INTERFACE
+ ==============================================================*/
+
+void initializeDeadlineTimer(_queue_id requestQueue, _pool_id messagePool){
+	g_RequestQueue = requestQueue;
+	g_MessagePool = messagePool;
+	g_TimerQueueExists = false;
+	g_ArmedTaskId = MQX_NULL_TASK_ID;
+	memset(&g_Stats, 0, sizeof(DeadlineTimerStats));
+}
+
+// Arms the timer to fire in the tick ISR at the given job's deadline, replacing any previously armed deadline
+void armDeadlineTimer(SchedulerTaskPtr task){
+	disarmDeadlineTimer();
+	if(task == NULL){
+		return;
+	}
+
+	// Work out which tick interrupt is the first at or after the deadline. A deadline part way through a tick
+	// is enforced at the start of the next tick; deadlines already passed expire on the next tick. Only whole
+	// ticks are counted: the tick ISR fires on tick boundaries, so how far the current tick has progressed does
+	// not matter, and a difference that borrowed from it would fire a tick-aligned deadline one tick early.
+	MQX_TICK_STRUCT now;
+	_time_get_ticks(&now);
+	int64_t ticksToDeadline = (int64_t)(_getWholeTicks(&task->Deadline) - _getWholeTicks(&now));
+	if(task->Deadline.HW_TICKS > 0){
+		ticksToDeadline++;
+	}
+	_mqx_uint waitTicks;
+	if(ticksToDeadline <= 1){
+		waitTicks = 0;
+	}
+	else if(ticksToDeadline > DEADLINE_TIMER_ONE_SHOT_PERIOD){
+		waitTicks = DEADLINE_TIMER_ONE_SHOT_PERIOD - 1;
+	}
+	else{
+		waitTicks = (_mqx_uint)(ticksToDeadline - 1);
+	}
+
+	g_ArmedDeadline = task->Deadline;
+	g_ArmedTaskId = task->TaskId;
+
+	// The timer sits at offset 0 of a queue that waits until the deadline tick and then never wraps
+	if(_lwtimer_create_periodic_queue(&g_TimerPeriod, DEADLINE_TIMER_ONE_SHOT_PERIOD, waitTicks) != MQX_OK){
+		printf("[Scheduler] Unable to create the deadline timer queue.\n");
+		_task_block();
+	}
+	g_TimerQueueExists = true;
+
+	if(_lwtimer_add_timer_to_queue(&g_TimerPeriod, &g_Timer, 0, _handleDeadlineTimerExpired, NULL) != MQX_OK){
+		printf("[Scheduler] Unable to arm the deadline timer.\n");
+		_task_block();
+	}
+}
+
+void disarmDeadlineTimer(){
+	g_ArmedTaskId = MQX_NULL_TASK_ID;
+	if(g_TimerQueueExists){
+		_lwtimer_cancel_period(&g_TimerPeriod);
+		g_TimerQueueExists = false;
+	}
+}
+
+void getDeadlineTimerStats(DeadlineTimerStatsPtr stats){
+	_int_disable();
+	*stats = g_Stats;
+	_int_enable();
+}
+
+/*=============================================================
+                         TIMER ISR
+ ==============================================================*/
+
+// Runs in the kernel tick ISR. The overrunning job is demoted below every other job at once, so the CPU
+// is released without waiting for the scheduler task, and the scheduler is then told to retire the job.
+static void _handleDeadlineTimerExpired(void* parameter){
+	_task_id taskId = g_ArmedTaskId;
+	if(taskId == MQX_NULL_TASK_ID){
+		return;
+	}
+	g_ArmedTaskId = MQX_NULL_TASK_ID;
+
+	uint32_t oldPriority;
+	_task_set_priority(taskId, EXPIRED_TASK_PRIORITY, &oldPriority);
+
+	_recordEnforcementLatency();
+	_notifyScheduler(taskId);
+}
+
+static void _notifyScheduler(_task_id taskId){
+	DeadlineExpiredMessagePtr message = (DeadlineExpiredMessagePtr) _msg_alloc(g_MessagePool);
+	if(message == NULL){
+		// The scheduler's timeout backstop will retire the job instead
+		g_Stats.DroppedNotifications++;
+		return;
+	}
+
+	memset(message, 0, sizeof(SchedulerMessage));
+	message->HEADER.TARGET_QID = g_RequestQueue;
+	message->HEADER.SOURCE_QID = MSGQ_NULL_QUEUE_ID;
+	message->MessageType = DEADLINE_EXPIRED;
+	message->TaskId = taskId;
+	_time_get_ticks(&message->SentAt);
+
+	if(_msgq_send_urgent(message) != TRUE){
+		g_Stats.DroppedNotifications++;
+	}
+}
+
+static void _recordEnforcementLatency(){
+	MQX_TICK_STRUCT now;
+	bool overflow;
+	_time_get_ticks(&now);
+	int32_t latencyUs = _time_diff_microseconds(&now, &g_ArmedDeadline, &overflow);
+	if(overflow){
+		latencyUs = (latencyUs < 0) ? INT32_MIN : INT32_MAX;
+	}
+
+	// Negative latencies are kept: a timer that fires before the deadline is a bug, and must show up
+	if(g_Stats.Expirations == 0 || latencyUs < g_Stats.MinLatencyUs){
+		g_Stats.MinLatencyUs = latencyUs;
+	}
+	if(g_Stats.Expirations == 0 || latencyUs > g_Stats.MaxLatencyUs){
+		g_Stats.MaxLatencyUs = latencyUs;
+	}
+	if(latencyUs < 0){
+		g_Stats.EarlyCount++;
+	}
+	g_Stats.Expirations++;
+	g_Stats.TotalLatencyUs += latencyUs;
+}
+
+/*=============================================================
+                      HELPER FUNCTIONS
+ ==============================================================*/
+
+static uint64_t _getWholeTicks(const MQX_TICK_STRUCT* ticks){
+	return ((uint64_t) ticks->TICKS[1] << 32) | ticks->TICKS[0];
+}
@@ -0,0 +1,41 @@
+#ifndef SOURCES_SCHEDULER_DEADLINETIMER_H_
+#define SOURCES_SCHEDULER_DEADLINETIMER_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include <lwtimer.h>
+
+#include "scheduler.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+// A period long enough that an armed timer never fires a second time before it is re-armed
+#define DEADLINE_TIMER_ONE_SHOT_PERIOD ((_mqx_uint) 0xFFFFFFFF)
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines deadline enforcement statistics, measured inside the timer ISR
+typedef struct DeadlineTimerStats{
+	uint32_t Expirations;				// The number of jobs demoted by the timer
+	int64_t TotalLatencyUs;				// The total time between deadlines and their enforcement
+	int32_t MinLatencyUs;				// The shortest time between a deadline and its enforcement, negative if early
+	int32_t MaxLatencyUs;				// The longest time between a deadline and its enforcement
+	uint32_t EarlyCount;				// Expirations enforced before their deadline
+	uint32_t DroppedNotifications;		// Expirations the scheduler could not be notified of
+} DeadlineTimerStats, *DeadlineTimerStatsPtr;
+
+/*=============================================================
+                   DEADLINE TIMER INTERFACE
+ ==============================================================*/
+
+void initializeDeadlineTimer(_queue_id requestQueue, _pool_id messagePool);
+void armDeadlineTimer(SchedulerTaskPtr task);
+void disarmDeadlineTimer();
+void getDeadlineTimerStats(DeadlineTimerStatsPtr stats);
+
+#endif
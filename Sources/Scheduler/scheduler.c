@@ -1,5 +1,7 @@
 #include "scheduler.h"
 #include "taskManagement.h"
+#include "deadlineTimer.h"
+#include "../TerminalDriver/logSink.h"
 
 /*=============================================================
                     LOCAL GLOBAL VARIABLES
@@ -8,26 +10,43 @@
 static _queue_id g_RequestQueue;			// The queue on which request messages will be sent the the scheduler
 static _pool_id g_SchedulerMessagePool;		// The scheduler's private message pool
 static MUTEX_STRUCT g_QueueNumMutex;		// A mutex to ensure concurrent scheduler requests get assigned different response queue numbers
+static SchedulerQueueStats g_QueueStats;	// Request queue depth and wait time statistics, updated by the scheduler task
+
+// A 1-2-5 series either side of the deadline, from a second early to a second late
+const int32_t SCHEDULER_LATENESS_EDGES_US[SCHEDULER_LATENESS_BUCKET_COUNT - 1] = {
+		-1000000, -500000, -200000, -100000, -50000, -20000, -10000, -5000, -2000, -1000, -500, -200, -100,
+		0, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000 };
 
 /*=============================================================
                       FUNCTION PROTOTYPES
  ==============================================================*/
 
+// User task helpers
+static uint32_t _getDefaultDeadline(uint32_t templateIndex);
+static uint32_t _getDefaultArgument(uint32_t templateIndex);
+static _task_id _requestTaskCreation(TaskCreateMessagePtr createMessage, _mqx_uint priority, _queue_id responseQueue);
+
 // Request handlers
 static void _handleCreateTaskMessage(TaskCreateMessagePtr message);
 static void _handleDeleteTaskMessage(TaskDeleteMessagePtr message);
 static void _handleRequestActiveTasksMessage(SchedulerRequestMessagePtr message);
 static void _handleRequestOverdueTasksMessage(SchedulerRequestMessagePtr message);
+static void _handleDeadlineExpiredMessage(DeadlineExpiredMessagePtr message);
 
 // Scheduler initialization
 static void _initializeSchedulerMessagePool();
 static _queue_id _initializeQueue(int queueNum);
 static void _initializeQueueNumMutex();
 
+// Request queue ordering and statistics
+static _mqx_uint _getCreateRequestPriority(uint32_t ticksToDeadline);
+static bool _sendSchedulerRequest(SchedulerRequestMessagePtr message, _mqx_uint priority);
+static void _recordRequestStatistics(SchedulerRequestMessagePtr message);
+
 // Message initialization
 static uint32_t _getResponseQueueId();
 static SchedulerMessagePtr _initializeSchedulerMessage();
-static TaskCreateMessagePtr _initializeTaskCreateMessage(uint32_t templateIndex, uint32_t deadline, _queue_id responseQueue);
+static TaskCreateMessagePtr _initializeTaskCreateMessage(uint32_t templateIndex, uint32_t deadline, uint32_t argument, _queue_id responseQueue);
 static TaskDeleteMessagePtr _initializeTaskDeleteMessage(_task_id taskId, _queue_id responseQueue);
 static SchedulerRequestMessagePtr _initializeSchedulerRequestMessage(_queue_id responseQueue);
 static SchedulerRequestMessagePtr _initializeRequestActiveMessage(_queue_id responseQueue);
@@ -40,36 +59,44 @@ static TaskListResponseMessagePtr _initializeTaskListResponseMessage(_queue_id r
                       USER TASK INTERFACE
  ==============================================================*/
 
+// A deadline of 0 takes the template's default deadline. The job is passed the template's parameter.
 _task_id dd_tcreate(uint32_t templateIndex, uint32_t deadline){
+	return dd_tcreate_arg(templateIndex, deadline, _getDefaultArgument(templateIndex));
+}
 
-	// Initialize response queue and create message
-	_queue_id responseQueue = _initializeQueue(_getResponseQueueId());
-	TaskCreateMessagePtr createMessage = _initializeTaskCreateMessage(templateIndex, deadline, responseQueue);
+// A deadline of 0 takes the template's default deadline, in ticks. The job is passed the template's parameter.
+_task_id dd_tcreate_us(uint32_t templateIndex, uint32_t deadlineUs){
+	return dd_tcreate_us_arg(templateIndex, deadlineUs, _getDefaultArgument(templateIndex));
+}
 
-	// Put create message on scheduler's request queue
-	if(_msgq_send(createMessage) != TRUE){
-		printf("[User] Unable to send create task message.\n");
-		_task_block();
+// Like dd_tcreate, but the job is passed the given argument instead of the template's parameter, so one
+// template can serve jobs that each need different input
+_task_id dd_tcreate_arg(uint32_t templateIndex, uint32_t deadline, uint32_t argument){
+	if(deadline == 0){
+		deadline = _getDefaultDeadline(templateIndex);
 	}
 
-	// Wait for response from scheduler
-	TaskCreateResponseMessagePtr response = (TaskCreateResponseMessagePtr) _msgq_receive(responseQueue, 0);
-	if(response == NULL){
-		printf("[User] Failed to receive a create task response from the scheduler.\n");
-		_task_block();
-	}
+	// Initialize response queue and create message
+	_queue_id responseQueue = _initializeQueue(_getResponseQueueId());
+	TaskCreateMessagePtr createMessage = _initializeTaskCreateMessage(templateIndex, deadline, argument, responseQueue);
 
-	// Get the ID of the new task
-	_task_id newTaskId = response->TaskId;
+	return _requestTaskCreation(createMessage, _getCreateRequestPriority(deadline), responseQueue);
+}
 
-	// Free the response message and destroy the queue
-	_msg_free(response);
-	if(_msgq_close(responseQueue) != TRUE){
-		printf("[User] Unable to close response queue.\n");
-		_task_block();
+// Like dd_tcreate_us, but the job is passed the given argument instead of the template's parameter
+_task_id dd_tcreate_us_arg(uint32_t templateIndex, uint32_t deadlineUs, uint32_t argument){
+	if(deadlineUs == 0){
+		return dd_tcreate_arg(templateIndex, 0, argument);
 	}
 
-	return newTaskId;
+	// Initialize response queue and create message
+	_queue_id responseQueue = _initializeQueue(_getResponseQueueId());
+	TaskCreateMessagePtr createMessage = _initializeTaskCreateMessage(templateIndex, 0, argument, responseQueue);
+	createMessage->MicrosecondsToDeadline = deadlineUs;
+
+	// Rank the request by the number of whole ticks it has before its deadline
+	uint32_t microsecondsPerTick = 1000000 / _time_get_ticks_per_sec();
+	return _requestTaskCreation(createMessage, _getCreateRequestPriority(deadlineUs / microsecondsPerTick), responseQueue);
 }
 
 bool dd_delete(_task_id taskId){
@@ -87,7 +114,7 @@ bool dd_delete(_task_id taskId){
 	}
 
 	// Put delete message on scheduler's request queue
-	if(_msgq_send(deleteMessage) != TRUE){
+	if(!_sendSchedulerRequest((SchedulerRequestMessagePtr) deleteMessage, DELETE_REQUEST_PRIORITY)){
 		printf("[User] Unable to send delete task message.\n");
 		_task_block();
 	}
@@ -123,7 +150,7 @@ bool dd_return_active_list(TaskList* taskList){
 	SchedulerRequestMessagePtr requestActiveMessage = _initializeRequestActiveMessage(responseQueue);
 
 	// Put create message on scheduler's request queue
-	if(_msgq_send(requestActiveMessage) != TRUE){
+	if(!_sendSchedulerRequest(requestActiveMessage, DIAGNOSTIC_REQUEST_PRIORITY)){
 		printf("[User] Unable to send request active tasks message.\n");
 		_task_block();
 	}
@@ -155,7 +182,7 @@ bool dd_return_overdue_list(TaskList* taskList){
 	SchedulerRequestMessagePtr requestOverdueMessage = _initializeRequestOverdueMessage(responseQueue);
 
 	// Put create message on scheduler's request queue
-	if(_msgq_send(requestOverdueMessage) != TRUE){
+	if(!_sendSchedulerRequest(requestOverdueMessage, DIAGNOSTIC_REQUEST_PRIORITY)){
 		printf("[User] Unable to send request active tasks message.\n");
 		_task_block();
 	}
@@ -180,19 +207,94 @@ bool dd_return_overdue_list(TaskList* taskList){
 	return true;
 }
 
+bool dd_get_queue_stats(SchedulerQueueStatsPtr stats){
+	if(stats == NULL){
+		return false;
+	}
+
+	// Take a consistent snapshot without sending a request through the queue being measured
+	_int_disable();
+	*stats = g_QueueStats;
+	_int_enable();
+
+	stats->CurrentDepth = _msgq_get_count(g_RequestQueue);
+	return true;
+}
+
+bool dd_get_health_stats(SchedulerHealthStatsPtr stats){
+	if(stats == NULL){
+		return false;
+	}
+
+	// The task manager's counters are only written by the scheduler task, which cannot run while interrupts are disabled
+	_int_disable();
+	getTaskHealthStats(stats);
+	_int_enable();
+	return true;
+}
+
+
+/*=============================================================
+                     USER TASK HELPERS
+ ==============================================================*/
+
+// Returns 0, a deadline that expires at once, if the template is not registered
+static uint32_t _getDefaultDeadline(uint32_t templateIndex){
+	const TaskTemplateInfo* info = dd_get_template_info(templateIndex);
+	return (info == NULL) ? 0 : info->DefaultDeadline;
+}
+
+// Returns 0 if the template is not registered, in which case the create request fails anyway
+static uint32_t _getDefaultArgument(uint32_t templateIndex){
+	const TaskTemplateInfo* info = dd_get_template_info(templateIndex);
+	return (info == NULL) ? 0 : info->Parameter;
+}
+
+static _task_id _requestTaskCreation(TaskCreateMessagePtr createMessage, _mqx_uint priority, _queue_id responseQueue){
+
+	// Put create message on scheduler's request queue
+	if(!_sendSchedulerRequest((SchedulerRequestMessagePtr) createMessage, priority)){
+		printf("[User] Unable to send create task message.\n");
+		_task_block();
+	}
+
+	// Wait for response from scheduler
+	TaskCreateResponseMessagePtr response = (TaskCreateResponseMessagePtr) _msgq_receive(responseQueue, 0);
+	if(response == NULL){
+		printf("[User] Failed to receive a create task response from the scheduler.\n");
+		_task_block();
+	}
+
+	// Get the ID of the new task
+	_task_id newTaskId = response->TaskId;
+
+	// Free the response message and destroy the queue
+	_msg_free(response);
+	if(_msgq_close(responseQueue) != TRUE){
+		printf("[User] Unable to close response queue.\n");
+		_task_block();
+	}
+
+	return newTaskId;
+}
+
 
 /*=============================================================
                     SCHEDULER TASK INTERFACE
  ==============================================================*/
 
-void _initializeScheduler(_queue_id requestQueue, const TASK_TEMPLATE_STRUCT taskTemplates[], uint32_t taskTemplateCount){
+void _initializeScheduler(_queue_id requestQueue){
 	g_RequestQueue = requestQueue;
-	initializeTaskManager(taskTemplates, taskTemplateCount);
+	initializeTaskManager();
 	_initializeSchedulerMessagePool();
+	initializeDeadlineTimer(g_RequestQueue, g_SchedulerMessagePool);
 	_initializeQueueNumMutex();
+	memset(&g_QueueStats, 0, sizeof(SchedulerQueueStats));
 }
 
 void _handleSchedulerRequest(SchedulerRequestMessagePtr requestMessage){
+	_recordRequestStatistics(requestMessage);
+
 	switch(requestMessage->MessageType){
 		case CREATE:
 			_handleCreateTaskMessage((TaskCreateMessagePtr) requestMessage);
@@ -206,19 +308,34 @@ void _handleSchedulerRequest(SchedulerRequestMessagePtr requestMessage){
 		case REQUEST_OVERDUE:
 			_handleRequestOverdueTasksMessage(requestMessage);
 			break;
+		case DEADLINE_EXPIRED:
+			_handleDeadlineExpiredMessage((DeadlineExpiredMessagePtr) requestMessage);
+			break;
 		default:
 			printf("[Scheduler] Encountered an invalid request type.\n");
 			_task_block();
 	}
 }
 
+// Only reached if the deadline timer failed to notify the scheduler of an expired job
 void _handleDeadlineReached(){
 	_task_id overdueTask = setCurrentTaskAsOverdue();
-	printf("[Scheduler] Task %u has overrun its deadline and has been destroyed.\n", overdueTask);
+	Log("[Scheduler] Task %u has overrun its deadline and has been destroyed.\n", overdueTask);
+}
+
+bool _getDeadlineBackstop(MQX_TICK_STRUCT_PTR backstop){
+	if(!getNextTaskDeadline(backstop)){
+		return false;
+	}
+	uint64_t backstopTicks = (((uint64_t) backstop->TICKS[1] << 32) | backstop->TICKS[0]) + DEADLINE_BACKSTOP_GRACE_TICKS;
+	backstop->TICKS[0] = (_mqx_uint) backstopTicks;
+	backstop->TICKS[1] = (_mqx_uint)(backstopTicks >> 32);
+	return true;
 }
 
-bool _getNextDeadline(MQX_TICK_STRUCT_PTR deadline){
-	return getNextTaskDeadline(deadline);
+// Lets monitors read the pool's usage without sending it a message
+_pool_id _getSchedulerMessagePool(){
+	return g_SchedulerMessagePool;
 }
 
 
@@ -227,11 +344,19 @@ bool _getNextDeadline(MQX_TICK_STRUCT_PTR deadline){
  ==============================================================*/
 
 static void _handleCreateTaskMessage(TaskCreateMessagePtr message){
-	printf("[Scheduler] Received a create request for a task at index %u with deadline %u.\n",
-		message->TemplateIndex, message->TicksToDeadline);
+	_task_id newTaskId;
 
 	// Create a new task
-	_task_id newTaskId = createTask(message->TemplateIndex, message->TicksToDeadline);
+	if(message->MicrosecondsToDeadline != 0){
+		Log("[Scheduler] Received a create request for a task at index %u with deadline %u us and argument %u.\n",
+			message->TemplateIndex, message->MicrosecondsToDeadline, message->Argument);
+		newTaskId = createTaskWithMicrosecondDeadline(message->TemplateIndex, message->MicrosecondsToDeadline, message->Argument);
+	}
+	else{
+		Log("[Scheduler] Received a create request for a task at index %u with deadline %u and argument %u.\n",
+			message->TemplateIndex, message->TicksToDeadline, message->Argument);
+		newTaskId = createTask(message->TemplateIndex, message->TicksToDeadline, message->Argument);
+	}
 
 	// Allocate response message
 	TaskCreateResponseMessagePtr response = _initializeTaskCreateResponseMessage(message->HEADER.SOURCE_QID, newTaskId);
@@ -244,7 +369,7 @@ static void _handleCreateTaskMessage(TaskCreateMessagePtr message){
 }
 
 static void _handleDeleteTaskMessage(TaskDeleteMessagePtr message){
-	printf("[Scheduler] Received a delete request for task %u.\n", message->TaskId);
+	Log("[Scheduler] Received a delete request for task %u.\n", message->TaskId);
 
 	// Delete the task
 	bool result = deleteTask(message->TaskId);
@@ -265,7 +390,7 @@ static void _handleDeleteTaskMessage(TaskDeleteMessagePtr message){
 }
 
 static void _handleRequestActiveTasksMessage(SchedulerRequestMessagePtr message){
-	printf("[Scheduler] Received a request for active tasks.\n");
+	Log("[Scheduler] Received a request for active tasks.\n");
 
 	// Get active tasks
 	TaskList activeTasks = getCopyOfActiveTasks();
@@ -281,7 +406,7 @@ static void _handleRequestActiveTasksMessage(SchedulerRequestMessagePtr message)
 }
 
 static void _handleRequestOverdueTasksMessage(SchedulerRequestMessagePtr message){
-	printf("[Scheduler] Received a request for overdue tasks.\n");
+	Log("[Scheduler] Received a request for overdue tasks.\n");
 
 	// Get overdue tasks
 	TaskList overdueTasks = getCopyOfOverdueTasks();
@@ -296,6 +421,65 @@ static void _handleRequestOverdueTasksMessage(SchedulerRequestMessagePtr message
 	}
 }
 
+static void _handleDeadlineExpiredMessage(DeadlineExpiredMessagePtr message){
+	// The job may already have completed or been deleted before this notification was served
+	_task_id overdueTask = setTaskAsOverdue(message->TaskId);
+	if(overdueTask != MQX_NULL_TASK_ID){
+		Log("[Scheduler] Task %u has overrun its deadline and has been destroyed.\n", overdueTask);
+	}
+}
+
+
+/*=============================================================
+                 REQUEST ORDERING AND STATISTICS
+ ==============================================================*/
+
+// Maps a create request's relative deadline onto a message priority. Each priority level covers a doubling
+// of the deadline, so a job due in 1 tick gets CREATE_REQUEST_MAX_PRIORITY and very long deadlines bottom out
+// at CREATE_REQUEST_MIN_PRIORITY, always above diagnostic requests and below deletes.
+static _mqx_uint _getCreateRequestPriority(uint32_t ticksToDeadline){
+	_mqx_uint priority = CREATE_REQUEST_MAX_PRIORITY;
+	while(ticksToDeadline > 1 && priority > CREATE_REQUEST_MIN_PRIORITY){
+		ticksToDeadline >>= 1;
+		priority--;
+	}
+	return priority;
+}
+
+static bool _sendSchedulerRequest(SchedulerRequestMessagePtr message, _mqx_uint priority){
+	_time_get_ticks(&message->SentAt);
+	return _msgq_send_priority(message, priority);
+}
+
+static void _recordRequestStatistics(SchedulerRequestMessagePtr message){
+	MessageType type = message->MessageType;
+	if(type >= SCHEDULER_MESSAGE_TYPE_COUNT){
+		return;
+	}
+
+	// Measure how long the request waited on the queue
+	MQX_TICK_STRUCT now;
+	bool overflow;
+	_time_get_ticks(&now);
+	int32_t waitTicks = _time_diff_ticks_int32(&now, &message->SentAt, &overflow);
+	if(overflow || waitTicks < 0){
+		waitTicks = 0;
+	}
+
+	// The queue depth includes the request currently being served
+	uint32_t depth = _msgq_get_count(g_RequestQueue) + 1;
+
+	_int_disable();
+	g_QueueStats.RequestCount[type]++;
+	g_QueueStats.TotalWaitTicks[type] += waitTicks;
+	if((uint32_t) waitTicks > g_QueueStats.MaxWaitTicks[type]){
+		g_QueueStats.MaxWaitTicks[type] = (uint32_t) waitTicks;
+	}
+	if(depth > g_QueueStats.MaxDepth){
+		g_QueueStats.MaxDepth = depth;
+	}
+	_int_enable();
+}
 
 /*=============================================================
                       INITIALIZATION
@@ -375,7 +559,7 @@ static SchedulerMessagePtr _initializeSchedulerMessage(){
 	return message;
 }
 
-static TaskCreateMessagePtr _initializeTaskCreateMessage(uint32_t templateIndex, uint32_t deadline, _queue_id responseQueue){
+static TaskCreateMessagePtr _initializeTaskCreateMessage(uint32_t templateIndex, uint32_t deadline, uint32_t argument, _queue_id responseQueue){
 	// Allocate message
 	TaskCreateMessagePtr message = (TaskCreateMessagePtr) _initializeSchedulerMessage();
 
@@ -385,6 +569,7 @@ static TaskCreateMessagePtr _initializeTaskCreateMessage(uint32_t templateIndex,
 	message->MessageType = CREATE;
 	message->TemplateIndex = templateIndex;
 	message->TicksToDeadline = deadline;
+	message->Argument = argument;
 
 	return message;
 }
@@ -3,6 +3,7 @@
 #include <mqx.h>
 #include <mutex.h>
 #include <message.h>
+#include "templateRegistry.h"
 
 #ifndef SOURCES_SCHEDULER_H_
 #define SOURCES_SCHEDULER_H_
@@ -21,6 +22,24 @@
 #define OVERDUE_TASK_PRIORITY 20
 #define DEFAULT_TASK_PRIORITY 20
 #define RUNNING_TASK_PRIORITY 19
+#define EXPIRED_TASK_PRIORITY MQXCFG_LOWEST_TASK_PRIORITY
+
+// Deadlines are enforced by the deadline timer; the scheduler's own receive timeout only acts as a backstop this many ticks later
+#define DEADLINE_BACKSTOP_GRACE_TICKS 2
+
+#define SCHEDULER_MESSAGE_TYPE_COUNT 5
+
+// Completed jobs are counted by lateness (completion time minus deadline) in buckets bounded by
+// SCHEDULER_LATENESS_EDGES_US. Bucket 0 counts everything before the first edge and the last bucket everything
+// from the last edge on.
+#define SCHEDULER_LATENESS_BUCKET_COUNT 28
+
+// Request queue message priorities (MQX serves higher priorities first). Deletes free the CPU and are served
+// first, creates are ranked by how soon their deadline falls, and diagnostic list requests are served last.
+#define DELETE_REQUEST_PRIORITY MSG_MAX_PRIORITY
+#define CREATE_REQUEST_MAX_PRIORITY (MSG_MAX_PRIORITY - 1)
+#define CREATE_REQUEST_MIN_PRIORITY 1
+#define DIAGNOSTIC_REQUEST_PRIORITY 0
 
 /*=============================================================
                       EXPORTED TYPES
@@ -29,8 +48,9 @@
 typedef struct SchedulerTask{
 	uint32_t TaskId;
 	MQX_TICK_STRUCT Deadline;
-	uint32_t TaskType;
+	uint32_t TaskType;				// The job's template index
 	MQX_TICK_STRUCT CreatedAt;
+	bool IsDemoted;					// An overdue job still running under MISS_POLICY_DEMOTE
 } SchedulerTask, *SchedulerTaskPtr;
 
 typedef struct TaskListNode{
@@ -45,27 +65,40 @@ typedef enum MessageType{
 	CREATE,
 	DELETE,
 	REQUEST_ACTIVE,
-	REQUEST_OVERDUE
+	REQUEST_OVERDUE,
+	DEADLINE_EXPIRED
 } MessageType;
 
 typedef struct SchedulerRequestMessage{
 	MESSAGE_HEADER_STRUCT HEADER;
 	MessageType MessageType;
+	MQX_TICK_STRUCT SentAt;
 } SchedulerRequestMessage, * SchedulerRequestMessagePtr;
 
 typedef struct TaskCreateMessage{
 	MESSAGE_HEADER_STRUCT HEADER;
 	MessageType MessageType;
+	MQX_TICK_STRUCT SentAt;
 	uint32_t TemplateIndex;
 	uint32_t TicksToDeadline;
+	uint32_t MicrosecondsToDeadline;	// Used instead of TicksToDeadline when non-zero
+	uint32_t Argument;					// Passed to the job's entry point
 } TaskCreateMessage, * TaskCreateMessagePtr;
 
 typedef struct TaskDeleteMessage{
 	MESSAGE_HEADER_STRUCT HEADER;
 	MessageType MessageType;
+	MQX_TICK_STRUCT SentAt;
 	_task_id TaskId;
 } TaskDeleteMessage, * TaskDeleteMessagePtr;
 
+typedef struct DeadlineExpiredMessage{
+	MESSAGE_HEADER_STRUCT HEADER;
+	MessageType MessageType;
+	MQX_TICK_STRUCT SentAt;
+	_task_id TaskId;
+} DeadlineExpiredMessage, * DeadlineExpiredMessagePtr;
+
 typedef struct TaskCreateResponseMessage{
 	MESSAGE_HEADER_STRUCT HEADER;
 	_task_id TaskId;
@@ -81,10 +114,31 @@ typedef struct TaskListResponseMessage{
 	TaskList Tasks;
 } TaskListResponseMessage, * TaskListResponseMessagePtr;
 
+// Defines the scheduler's request queue statistics
+typedef struct SchedulerQueueStats{
+	uint32_t CurrentDepth;										// The number of requests waiting on the queue
+	uint32_t MaxDepth;											// The largest queue depth seen when a request was served
+	uint32_t RequestCount[SCHEDULER_MESSAGE_TYPE_COUNT];		// The number of requests served, by MessageType
+	uint64_t TotalWaitTicks[SCHEDULER_MESSAGE_TYPE_COUNT];		// The total ticks requests spent queued, by MessageType
+	uint32_t MaxWaitTicks[SCHEDULER_MESSAGE_TYPE_COUNT];		// The longest time a request spent queued, by MessageType
+} SchedulerQueueStats, *SchedulerQueueStatsPtr;
+
+// Defines the scheduler's job outcome statistics. Counts only ever grow, so samples can be differenced.
+typedef struct SchedulerHealthStats{
+	uint32_t ActiveCount;										// The number of jobs in the active list
+	uint32_t OverdueCount;										// The number of jobs in the overdue list
+	uint32_t CompletedCount;									// The number of jobs deleted before their deadline
+	uint32_t MissedCount;										// The number of jobs that reached their deadline
+	uint32_t LatenessHistogram[SCHEDULER_LATENESS_BUCKET_COUNT];	// Completed jobs by lateness
+} SchedulerHealthStats, *SchedulerHealthStatsPtr;
+
+extern const int32_t SCHEDULER_LATENESS_EDGES_US[SCHEDULER_LATENESS_BUCKET_COUNT - 1];
+
 typedef union SchedulerMessage{
 	SchedulerRequestMessage RequestMessage;
 	TaskCreateMessage CreateMessage;
 	TaskDeleteMessage DeleteMessage;
+	DeadlineExpiredMessage DeadlineExpired;
 	TaskCreateResponseMessage CreateResponse;
 	TaskDeleteResponseMessage DeleteResponse;
 	TaskListResponseMessage TaskListResponse;
@@ -95,17 +149,23 @@ typedef union SchedulerMessage{
  ==============================================================*/
 
 _task_id dd_tcreate(uint32_t templateIndex, uint32_t deadline);
+_task_id dd_tcreate_us(uint32_t templateIndex, uint32_t deadlineUs);
+_task_id dd_tcreate_arg(uint32_t templateIndex, uint32_t deadline, uint32_t argument);
+_task_id dd_tcreate_us_arg(uint32_t templateIndex, uint32_t deadlineUs, uint32_t argument);
 bool dd_delete(_task_id task);
 bool dd_return_active_list(TaskList* taskList);
 bool dd_return_overdue_list(TaskList* taskList);
+bool dd_get_queue_stats(SchedulerQueueStatsPtr stats);
+bool dd_get_health_stats(SchedulerHealthStatsPtr stats);
 
 /*=============================================================
                       INTERNAL INTERFACE
  ==============================================================*/
 
-void _initializeScheduler(_queue_id requestQueue, const TASK_TEMPLATE_STRUCT taskTemplates[], uint32_t taskTemplateCount);
+void _initializeScheduler(_queue_id requestQueue);
 void _handleSchedulerRequest(SchedulerRequestMessagePtr requestMessage);
 void _handleDeadlineReached();
-bool _getNextDeadline(MQX_TICK_STRUCT_PTR deadline);
+bool _getDeadlineBackstop(MQX_TICK_STRUCT_PTR backstop);
+_pool_id _getSchedulerMessagePool();
 
 #endif /* SOURCES_SCHEDULER_H_ */
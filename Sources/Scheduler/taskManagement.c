@@ -1,14 +1,16 @@
 #include "taskManagement.h"
+#include "deadlineTimer.h"
+#include "../Trace/taskTrace.h"
+#include "../Monitor/stackMonitor.h"
 
 /*=============================================================
                      LOCAL GLOBAL VARIABLES
  ==============================================================*/
 
-static const TASK_TEMPLATE_STRUCT* g_TaskTemplates;	// Pointer to the list of task templates
-static uint32_t g_TaskTemplateCount;				// The number of templates in the task template list
 static SchedulerTaskPtr g_CurrentTask;				// The currently executing task (task with closest deadline)
 static TaskList g_ActiveTasks;						// The scheduler's list of active tasks
 static TaskList g_OverdueTasks;						// The scheduler's list of overdue tasks
+static SchedulerHealthStats g_HealthStats;			// Job outcome statistics, read by monitors with interrupts disabled
 
 /*=============================================================
                       FUNCTION PROTOTYPES
@@ -17,7 +19,8 @@ static TaskList g_OverdueTasks;						// The scheduler's list of overdue tasks
 // Task Creation
 static SchedulerTaskPtr _initializeSchedulerTask();
 static SchedulerTaskPtr _copySchedulerTask(SchedulerTaskPtr original);
-static void _scheduleNewTask(_task_id taskId, uint32_t ticksToDeadline);
+static _task_id _createAndScheduleTask(uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t microsecondsToDeadline, uint32_t argument);
+static void _scheduleNewTask(_task_id taskId, uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t microsecondsToDeadline);
 
 // Task Deletion
 static bool _deleteOverdueTask(_task_id taskId);
@@ -32,37 +35,29 @@ static TaskListNodePtr _initializeTaskListNode();
 static TaskList _copyTaskList(TaskList original);
 static void _addTaskToSequentialList(SchedulerTaskPtr task, TaskList* list);
 static uint32_t _addTaskToDeadlinePrioritizedList(SchedulerTaskPtr newTask, TaskList* list);
+static bool _isDeadlineBefore(MQX_TICK_STRUCT_PTR deadline, MQX_TICK_STRUCT_PTR otherDeadline);
 static SchedulerTaskPtr _removeTaskWithIdFromTaskList(_task_id taskId, TaskList* list);
 
+// Statistics
+static void _recordCompletion(SchedulerTaskPtr task);
+
 /*=============================================================
                       PUBLIC INTERFACE
  ==============================================================*/
 
-void initializeTaskManager(const TASK_TEMPLATE_STRUCT taskTemplates[], uint32_t taskTemplateCount){
-	g_TaskTemplates = taskTemplates;
-	g_TaskTemplateCount = taskTemplateCount;
+void initializeTaskManager(){
 	g_ActiveTasks = NULL;
 	g_OverdueTasks = NULL;
 	g_CurrentTask = NULL;
+	memset(&g_HealthStats, 0, sizeof(SchedulerHealthStats));
 }
 
-_task_id createTask(uint32_t templateIndex, uint32_t ticksToDeadline){
-	// Ensure template index is valid
-	if(templateIndex >= g_TaskTemplateCount){
-		return MQX_NULL_TASK_ID;
-	}
-
-	// Create a new MQX task and ensure it was created successfully
-	_task_id newTaskId = _task_create(0, 0, (uint32_t) &g_TaskTemplates[templateIndex]);
-	if (newTaskId == MQX_NULL_TASK_ID){
-		printf("Unable to create task.\n");
-		_task_block();
-	}
-
-	// Add the newly created task to the scheduler
-	_scheduleNewTask(newTaskId, ticksToDeadline);
+_task_id createTask(uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t argument){
+	return _createAndScheduleTask(templateIndex, ticksToDeadline, 0, argument);
+}
 
-	return newTaskId;
+_task_id createTaskWithMicrosecondDeadline(uint32_t templateIndex, uint32_t microsecondsToDeadline, uint32_t argument){
+	return _createAndScheduleTask(templateIndex, 0, microsecondsToDeadline, argument);
 }
 
 _task_id setCurrentTaskAsOverdue(){
@@ -75,16 +70,37 @@ _task_id setCurrentTaskAsOverdue(){
 	SchedulerTaskPtr overdueTask = g_CurrentTask;
 	_removeTaskWithIdFromTaskList(overdueTask->TaskId, &g_ActiveTasks);
 	_addTaskToSequentialList(overdueTask, &g_OverdueTasks);
+	g_HealthStats.ActiveCount--;
+	g_HealthStats.OverdueCount++;
+	g_HealthStats.MissedCount++;
 
 	// Update the new current task
 	_setCurrentlyRunningTask((g_ActiveTasks == NULL) ? NULL : g_ActiveTasks->task);
+	tr_traceEvent(TRACE_EVENT_EXPIRE, overdueTask->TaskId, 0);
+
+	// Let a job whose template allows it finish below every other job. It is destroyed when it is deleted.
+	const TaskTemplateInfo* info = dd_get_template_info(overdueTask->TaskType);
+	if(info != NULL && info->MissPolicy == MISS_POLICY_DEMOTE){
+		overdueTask->IsDemoted = true;
+		_setTaskPriorityTo(EXPIRED_TASK_PRIORITY, overdueTask->TaskId);
+		return overdueTask->TaskId;
+	}
 
-	// Destroy the overdue task
+	// Otherwise destroy the overdue task
+	sm_recordJobStackUsage(overdueTask->TaskId);
 	_task_destroy(overdueTask->TaskId);
 
 	return overdueTask->TaskId;
 }
 
+_task_id setTaskAsOverdue(_task_id taskId){
+	// Only the currently running task can overrun its deadline
+	if(g_CurrentTask == NULL || g_CurrentTask->TaskId != taskId){
+		return MQX_NULL_TASK_ID;
+	}
+	return setCurrentTaskAsOverdue();
+}
+
 bool deleteTask(_task_id taskId){
 	return _deleteActiveTask(taskId) || _deleteOverdueTask(taskId);
 }
@@ -97,6 +113,10 @@ TaskList getCopyOfOverdueTasks(){
 	return _copyTaskList(g_OverdueTasks);
 }
 
+void getTaskHealthStats(SchedulerHealthStatsPtr stats){
+	*stats = g_HealthStats;
+}
+
 bool getNextTaskDeadline(MQX_TICK_STRUCT_PTR deadline){
 	if (g_CurrentTask == NULL){
 		return false;
@@ -129,20 +149,61 @@ static SchedulerTaskPtr _copySchedulerTask(SchedulerTaskPtr original){
 	copy->Deadline = original->Deadline;
 	copy->TaskId = original->TaskId;
 	copy->TaskType = original->TaskType;
+	copy->IsDemoted = original->IsDemoted;
 	return copy;
 }
 
-static void _scheduleNewTask(_task_id taskId, uint32_t ticksToDeadline){
+static _task_id _createAndScheduleTask(uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t microsecondsToDeadline, uint32_t argument){
+	// Ensure template index is valid
+	const TASK_TEMPLATE_STRUCT* registeredTemplate = dd_get_task_template(templateIndex);
+	if(registeredTemplate == NULL){
+		return MQX_NULL_TASK_ID;
+	}
+
+	// MQX copies the template into the new task's stack block, so the argument can be set on a copy here
+	TASK_TEMPLATE_STRUCT taskTemplate = *registeredTemplate;
+	taskTemplate.CREATION_PARAMETER = argument;
+
+	// Create a new MQX task and ensure it was created successfully
+	_task_id newTaskId = _task_create(0, 0, (uint32_t) &taskTemplate);
+	if (newTaskId == MQX_NULL_TASK_ID){
+		printf("Unable to create task.\n");
+		_task_block();
+	}
+
+	// Add the newly created task to the scheduler
+	tr_traceEvent(TRACE_EVENT_CREATE, newTaskId, templateIndex);
+	_scheduleNewTask(newTaskId, templateIndex, ticksToDeadline, microsecondsToDeadline);
+
+	return newTaskId;
+}
+
+static void _scheduleNewTask(_task_id taskId, uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t microsecondsToDeadline){
 
 	// Initialize task struct
 	SchedulerTaskPtr newTask = _initializeSchedulerTask();
 	newTask->TaskId = taskId;
+	newTask->TaskType = templateIndex;
 	_time_get_ticks(&newTask->CreatedAt);
 	newTask->Deadline = newTask->CreatedAt;
-	newTask->Deadline.TICKS[0] += ticksToDeadline;
+
+	// Microsecond deadlines keep the hardware tick offset; tick deadlines fall on a tick boundary
+	if(microsecondsToDeadline != 0){
+		_time_add_usec_to_ticks(&newTask->Deadline, microsecondsToDeadline);
+	}
+	else{
+		// Carry into the high word, or a deadline past a TICKS[0] wrap would sort before every other job
+		uint64_t deadlineTicks = (((uint64_t) newTask->Deadline.TICKS[1] << 32) | newTask->Deadline.TICKS[0]) + ticksToDeadline;
+		newTask->Deadline.HW_TICKS = 0;
+		newTask->Deadline.TICKS[0] = (_mqx_uint) deadlineTicks;
+		newTask->Deadline.TICKS[1] = (_mqx_uint)(deadlineTicks >> 32);
+	}
+	bool overflow;
+	tr_traceEvent(TRACE_EVENT_DEADLINE, taskId, _time_diff_microseconds(&newTask->Deadline, &newTask->CreatedAt, &overflow));
 
 	// Add the new task to the list of active tasks
 	uint32_t taskIndex = _addTaskToDeadlinePrioritizedList(newTask, &g_ActiveTasks);
+	g_HealthStats.ActiveCount++;
 
 	// If the new task has the highest priority, set it to running
 	if(taskIndex == 0){
@@ -166,6 +227,14 @@ static bool _deleteOverdueTask(_task_id taskId){
 		return false;
 	}
 
+	g_HealthStats.OverdueCount--;
+
+	// A demoted job has run on to completion, or is being deleted by another task
+	if(removedTask->IsDemoted){
+		tr_traceEvent(TRACE_EVENT_FINISH, taskId, 0);
+		sm_recordJobStackUsage(taskId);
+		_task_destroy(taskId);
+	}
 	free(removedTask);
 	return true;
 }
@@ -177,6 +246,7 @@ static bool _deleteActiveTask(_task_id taskId){
 		// If the task does not exist, return false
 		return false;
 	}
+	_recordCompletion(removedTask);
 
 	// If the deleted task is the currently running task...
 	if(g_CurrentTask->TaskId == taskId){
@@ -185,12 +255,37 @@ static bool _deleteActiveTask(_task_id taskId){
 	}
 
 	// Destroy deleted task and clear its memory
+	tr_traceEvent(TRACE_EVENT_FINISH, taskId, 0);
+	sm_recordJobStackUsage(taskId);
 	_task_destroy(taskId);
 	free(removedTask);
 
 	return true;
 }
 
+/*=============================================================
+                          STATISTICS
+ ==============================================================*/
+
+static void _recordCompletion(SchedulerTaskPtr task){
+	MQX_TICK_STRUCT now;
+	bool overflow;
+	_time_get_ticks(&now);
+	int32_t latenessUs = _time_diff_microseconds(&now, &task->Deadline, &overflow);
+	if(overflow){
+		latenessUs = _isDeadlineBefore(&now, &task->Deadline) ? INT32_MIN : INT32_MAX;
+	}
+
+	uint32_t bucket = 0;
+	while(bucket < SCHEDULER_LATENESS_BUCKET_COUNT - 1 && latenessUs >= SCHEDULER_LATENESS_EDGES_US[bucket]){
+		bucket++;
+	}
+
+	g_HealthStats.ActiveCount--;
+	g_HealthStats.CompletedCount++;
+	g_HealthStats.LatenessHistogram[bucket]++;
+}
+
 /*=============================================================
                     RUNNING TASK MANAGEMENT
  ==============================================================*/
@@ -205,6 +300,9 @@ static void _setCurrentlyRunningTask(SchedulerTaskPtr task){
 	if(task != NULL){
 		_setTaskPriorityTo(RUNNING_TASK_PRIORITY, task->TaskId);
 	}
+
+	// Enforce the new running task's deadline from the tick ISR
+	armDeadlineTimer(task);
 }
 
 static void _setTaskPriorityTo(uint32_t priority, _task_id taskId){
@@ -213,6 +311,7 @@ static void _setTaskPriorityTo(uint32_t priority, _task_id taskId){
 		printf("[Scheduler] Could not change priority of task %u.\n", taskId);
 		_task_block();
 	}
+	tr_traceEvent(TRACE_EVENT_PRIORITY, taskId, priority);
 }
 
 /*=============================================================
@@ -289,7 +388,7 @@ static uint32_t _addTaskToDeadlinePrioritizedList(SchedulerTaskPtr newTask, Task
 		TaskListNodePtr currentNode = *list;
 		for(;;){
 			// If the new task preempts the current task, place the new task before the current task in the list
-			if(newTask->Deadline.TICKS[0] < currentNode->task->Deadline.TICKS[0]){
+			if(_isDeadlineBefore(&newTask->Deadline, &currentNode->task->Deadline)){
 				node->nextNode = currentNode;
 				node->prevNode = currentNode->prevNode;
 				if(currentNode->prevNode != NULL){
@@ -311,6 +410,17 @@ static uint32_t _addTaskToDeadlinePrioritizedList(SchedulerTaskPtr newTask, Task
 	return newTaskIndex;
 }
 
+// Compares two deadlines including their hardware tick offsets within the tick
+static bool _isDeadlineBefore(MQX_TICK_STRUCT_PTR deadline, MQX_TICK_STRUCT_PTR otherDeadline){
+	if(deadline->TICKS[1] != otherDeadline->TICKS[1]){
+		return deadline->TICKS[1] < otherDeadline->TICKS[1];
+	}
+	if(deadline->TICKS[0] != otherDeadline->TICKS[0]){
+		return deadline->TICKS[0] < otherDeadline->TICKS[0];
+	}
+	return deadline->HW_TICKS < otherDeadline->HW_TICKS;
+}
+
 static SchedulerTaskPtr _removeTaskWithIdFromTaskList(_task_id taskId, TaskList* list){
 
 	// If the list is empty, return null
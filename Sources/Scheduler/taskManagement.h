@@ -11,12 +11,15 @@
                     TASK MANAGER INTERFACE
  ==============================================================*/
 
-void initializeTaskManager(const TASK_TEMPLATE_STRUCT taskTemplates[], uint32_t taskTemplateCount);
-_task_id createTask(uint32_t templateIndex, uint32_t msToDeadline);
+void initializeTaskManager();
+_task_id createTask(uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t argument);
+_task_id createTaskWithMicrosecondDeadline(uint32_t templateIndex, uint32_t microsecondsToDeadline, uint32_t argument);
 _task_id setCurrentTaskAsOverdue();
+_task_id setTaskAsOverdue(_task_id taskId);
 bool deleteTask(_task_id taskId);
 TaskList getCopyOfActiveTasks();
 TaskList getCopyOfOverdueTasks();
 bool getNextTaskDeadline(MQX_TICK_STRUCT_PTR deadline);
+void getTaskHealthStats(SchedulerHealthStatsPtr stats);
 
 #endif
@@ -0,0 +1,73 @@
+#include "templateRegistry.h"
+#include "scheduler.h"
+#include <string.h>
+
+/*=============================================================
+                    LOCAL GLOBAL VARIABLES
+ ==============================================================*/
+
+// Entries are written once, before the count is raised past them, so readers never need a lock
+static TaskTemplateInfo g_Infos[TASK_TEMPLATE_MAX];
+static TASK_TEMPLATE_STRUCT g_Templates[TASK_TEMPLATE_MAX];	// The MQX template each job is created from
+static volatile uint32_t g_TemplateCount = 0;
+
+/*=============================================================
+                  TEMPLATE REGISTRY INTERFACE
+ ==============================================================*/
+
+// Adds a job template that can be created from any task. Returns its template index, or -1 if the registry is
+// full, the template is incomplete or its name is taken. Jobs are matched back to their template by its name
+// and entry point, so names must differ.
+int32_t dd_register_template(const TaskTemplateInfo* info){
+	if(info == NULL || info->Name == NULL || info->EntryPoint == NULL || info->StackSize < PSP_MINSTACKSIZE){
+		return -1;
+	}
+
+	_int_disable();
+	uint32_t templateIndex = g_TemplateCount;
+	bool isNameTaken = false;
+	for(uint32_t i = 0; i < templateIndex && !isNameTaken; i++){
+		isNameTaken = (strcmp(g_Infos[i].Name, info->Name) == 0);
+	}
+	if(isNameTaken || templateIndex == TASK_TEMPLATE_MAX){
+		_int_enable();
+		return -1;
+	}
+
+	g_Infos[templateIndex] = *info;
+	TASK_TEMPLATE_STRUCT_PTR mqxTemplate = &g_Templates[templateIndex];
+	memset(mqxTemplate, 0, sizeof(TASK_TEMPLATE_STRUCT));
+	mqxTemplate->TASK_ADDRESS = info->EntryPoint;
+	mqxTemplate->TASK_STACKSIZE = info->StackSize;
+	mqxTemplate->TASK_PRIORITY = DEFAULT_TASK_PRIORITY;
+	mqxTemplate->TASK_NAME = (char*) info->Name;
+	mqxTemplate->CREATION_PARAMETER = info->Parameter;
+	g_TemplateCount = templateIndex + 1;
+	_int_enable();
+
+	return templateIndex;
+}
+
+uint32_t dd_get_template_count(){
+	return g_TemplateCount;
+}
+
+// Returns NULL if no template is registered at the index
+const TaskTemplateInfo* dd_get_template_info(uint32_t templateIndex){
+	return (templateIndex < g_TemplateCount) ? &g_Infos[templateIndex] : NULL;
+}
+
+// Returns NULL if no template is registered at the index
+const TASK_TEMPLATE_STRUCT* dd_get_task_template(uint32_t templateIndex){
+	return (templateIndex < g_TemplateCount) ? &g_Templates[templateIndex] : NULL;
+}
+
+// Returns the template's WCET rounded up to whole ticks, or 1 if the template is not registered
+uint32_t dd_get_template_wcet_ticks(uint32_t templateIndex){
+	const TaskTemplateInfo* info = dd_get_template_info(templateIndex);
+	if(info == NULL){
+		return 1;
+	}
+	uint32_t microsecondsPerTick = 1000000 / _time_get_ticks_per_sec();
+	return (info->WcetMicroseconds + microsecondsPerTick - 1) / microsecondsPerTick;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_SCHEDULER_TEMPLATEREGISTRY_H_
+#define SOURCES_SCHEDULER_TEMPLATEREGISTRY_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define TASK_TEMPLATE_MAX 16					// The number of job templates that can be registered
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines what happens to a job that reaches its deadline before it finishes
+typedef enum DeadlineMissPolicy{
+	MISS_POLICY_ABORT,			// The job is destroyed
+	MISS_POLICY_DEMOTE			// The job runs on below every other job, and is deleted when it finishes
+} DeadlineMissPolicy;
+
+// Defines a job template and how the scheduler treats its jobs
+typedef struct TaskTemplateInfo{
+	const char* Name;					// Must stay valid, and be unique among registered templates
+	TASK_FPTR EntryPoint;
+	uint32_t StackSize;					// In bytes
+	uint32_t Parameter;					// Passed to the entry point of jobs created without an argument of their own
+	uint32_t WcetMicroseconds;			// The longest a job is expected to run for, in CPU time
+	uint32_t DefaultDeadline;			// In ticks, used for create requests with a deadline of 0
+	uint32_t DefaultPeriod;				// In ticks, used for streams started with a period of 0
+	DeadlineMissPolicy MissPolicy;
+} TaskTemplateInfo, * TaskTemplateInfoPtr;
+
+/*=============================================================
+                  TEMPLATE REGISTRY INTERFACE
+ ==============================================================*/
+
+int32_t dd_register_template(const TaskTemplateInfo* info);
+uint32_t dd_get_template_count();
+const TaskTemplateInfo* dd_get_template_info(uint32_t templateIndex);
+const TASK_TEMPLATE_STRUCT* dd_get_task_template(uint32_t templateIndex);
+uint32_t dd_get_template_wcet_ticks(uint32_t templateIndex);
+
+#endif
@@ -0,0 +1,123 @@
+#include "indexMap.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static IndexMapEntryPtr* _allocateBuckets(uint32_t bucketCount);
+static uint32_t _getBucketIndex(uint32_t key, uint32_t bucketCount);
+static void _growIndexMap(IndexMapPtr map);
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void _initializeIndexMap(IndexMapPtr map){
+	map->buckets = _allocateBuckets(INDEX_MAP_INITIAL_BUCKETS);
+	map->bucketCount = INDEX_MAP_INITIAL_BUCKETS;
+	map->count = 0;
+}
+
+/*=============================================================
+                      INDEX MAP INTERFACE
+ ==============================================================*/
+
+// Binds the key to the value. The key must not already be in the map.
+void _insertIndexMapEntry(IndexMapPtr map, uint32_t key, void* value){
+	if(map->count >= map->bucketCount){
+		_growIndexMap(map);
+	}
+
+	IndexMapEntryPtr entry;
+	if(!(entry = (IndexMapEntryPtr) malloc(sizeof(IndexMapEntry)))){
+		printf("Unable to allocate memory for an index map entry.\n");
+		_task_block();
+	}
+
+	uint32_t bucket = _getBucketIndex(key, map->bucketCount);
+	entry->key = key;
+	entry->value = value;
+	entry->next = map->buckets[bucket];
+	map->buckets[bucket] = entry;
+	map->count++;
+}
+
+// Returns the value bound to the key, or NULL if the key is not in the map
+void* _findIndexMapEntry(IndexMapPtr map, uint32_t key){
+	IndexMapEntryPtr entry = map->buckets[_getBucketIndex(key, map->bucketCount)];
+	while(entry != NULL){
+		if(entry->key == key){
+			return entry->value;
+		}
+		entry = entry->next;
+	}
+	return NULL;
+}
+
+// Unbinds the key and returns the value it was bound to, or NULL if the key is not in the map
+void* _removeIndexMapEntry(IndexMapPtr map, uint32_t key){
+	IndexMapEntryPtr* link = &map->buckets[_getBucketIndex(key, map->bucketCount)];
+	while(*link != NULL){
+		IndexMapEntryPtr entry = *link;
+		if(entry->key == key){
+			void* value = entry->value;
+			*link = entry->next;
+			free(entry);
+			map->count--;
+			return value;
+		}
+		link = &entry->next;
+	}
+	return NULL;
+}
+
+// Copies every value in the map into an array with room for map->count entries and returns the number copied
+uint32_t _copyIndexMapValues(IndexMapPtr map, void** values){
+	uint32_t copied = 0;
+	for(uint32_t i=0; i<map->bucketCount; i++){
+		for(IndexMapEntryPtr entry = map->buckets[i]; entry != NULL; entry = entry->next){
+			values[copied++] = entry->value;
+		}
+	}
+	return copied;
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+static IndexMapEntryPtr* _allocateBuckets(uint32_t bucketCount){
+	IndexMapEntryPtr* buckets;
+	if(!(buckets = (IndexMapEntryPtr*) malloc(sizeof(IndexMapEntryPtr) * bucketCount))){
+		printf("Unable to allocate memory for index map buckets.\n");
+		_task_block();
+	}
+	memset(buckets, 0, sizeof(IndexMapEntryPtr) * bucketCount);
+	return buckets;
+}
+
+// Task IDs differ mostly in their low bits, so a multiplicative hash spreads them across the buckets
+static uint32_t _getBucketIndex(uint32_t key, uint32_t bucketCount){
+	return (key * 2654435761u) >> 16 & (bucketCount - 1);
+}
+
+static void _growIndexMap(IndexMapPtr map){
+	uint32_t newBucketCount = map->bucketCount * 2;
+	IndexMapEntryPtr* newBuckets = _allocateBuckets(newBucketCount);
+
+	// Move every entry into its bucket in the larger array
+	for(uint32_t i=0; i<map->bucketCount; i++){
+		IndexMapEntryPtr entry = map->buckets[i];
+		while(entry != NULL){
+			IndexMapEntryPtr next = entry->next;
+			uint32_t bucket = _getBucketIndex(entry->key, newBucketCount);
+			entry->next = newBuckets[bucket];
+			newBuckets[bucket] = entry;
+			entry = next;
+		}
+	}
+
+	free(map->buckets);
+	map->buckets = newBuckets;
+	map->bucketCount = newBucketCount;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mqx.h>
+
+#ifndef SOURCES_INDEXMAP_H_
+#define SOURCES_INDEXMAP_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define INDEX_MAP_INITIAL_BUCKETS 16		// Must be a power of two
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a single key/value binding in an index map
+typedef struct IndexMapEntry{
+	uint32_t key;
+	void* value;
+	struct IndexMapEntry* next;
+} IndexMapEntry, * IndexMapEntryPtr;
+
+// Defines a hash map from 32-bit keys to pointers. The bucket array doubles whenever the map holds more
+// entries than buckets, so lookups stay O(1) however many entries are added.
+typedef struct IndexMap{
+	IndexMapEntryPtr* buckets;
+	uint32_t bucketCount;
+	uint32_t count;
+} IndexMap, * IndexMapPtr;
+
+/*=============================================================
+                      INDEX MAP INTERFACE
+ ==============================================================*/
+
+void _initializeIndexMap(IndexMapPtr map);
+void _insertIndexMapEntry(IndexMapPtr map, uint32_t key, void* value);
+void* _findIndexMapEntry(IndexMapPtr map, uint32_t key);
+void* _removeIndexMapEntry(IndexMapPtr map, uint32_t key);
+uint32_t _copyIndexMapValues(IndexMapPtr map, void** values);
+
+#endif
@@ -0,0 +1,524 @@
+#include "streamRegistry.h"
+#include "../Scheduler/scheduler.h"
+#include "../TerminalDriver/logSink.h"
+#include "mqx_ksdk.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+void runPeriodicGenerator(os_task_param_t task_init_data);
+static PeriodicStreamPtr _initializePeriodicStream(uint32_t templateIndex, uint32_t deadline, bool deadlineInMicroseconds, uint32_t period);
+static uint32_t _getJobCapacity(PeriodicStreamPtr stream);
+static void _resizeJobHistory(PeriodicStreamPtr stream, uint32_t capacity);
+static void _recordStreamJob(PeriodicStreamPtr stream, _task_id jobId);
+static void _forgetOldestStreamJob(PeriodicStreamPtr stream);
+static void _destroyPeriodicStream(PeriodicStreamPtr stream);
+static bool _waitForRelease(PeriodicStreamPtr stream);
+static void _recordReleaseJitter(PeriodicStreamPtr stream);
+static uint64_t _getWholeTicks(const MQX_TICK_STRUCT* ticks);
+static void _addWholeTicks(MQX_TICK_STRUCT* ticks, uint64_t count);
+static void _scheduleFirstRelease(PeriodicStreamPtr stream, uint32_t phase);
+static uint32_t _chooseSpreadPhase(uint32_t period, uint32_t jobTicks);
+static uint32_t _getTemplateTicks(uint32_t templateIndex);
+static void _lockRegistry();
+static void _unlockRegistry();
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+// Both indices and every stream's job history are guarded by the registry mutex
+static IndexMap g_StreamsById;
+static IndexMap g_StreamsByJob;
+static MUTEX_STRUCT g_RegistryMutex;
+static uint32_t g_NextStreamId = 1;
+static bool g_IsPhaseSpreadingEnabled = false;
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void sr_initializeStreamRegistry(){
+	_initializeIndexMap(&g_StreamsById);
+	_initializeIndexMap(&g_StreamsByJob);
+
+	MUTEX_ATTR_STRUCT registryMutexAttributes;
+	if(_mutatr_init(&registryMutexAttributes) != MQX_OK){
+		printf("[Stream Registry] Mutex attribute initialization failed.\n");
+		_task_block();
+	}
+
+	if(_mutex_init(&g_RegistryMutex, &registryMutexAttributes) != MQX_OK){
+		printf("[Stream Registry] Mutex initialization failed.\n");
+		_task_block();
+	}
+}
+
+/*=============================================================
+                      PERIODIC GENERATOR TASK
+ ==============================================================*/
+
+// Releases a job every period until the stream is stopped, then frees the stream. Each release is scheduled
+// a whole period after the previous nominal release rather than after the generator finished its work, so the
+// time spent creating the job never accumulates into drift.
+void runPeriodicGenerator(os_task_param_t streamPtr){
+	PeriodicStreamPtr stream = (PeriodicStreamPtr) streamPtr;
+	Log("[Generator] Stream %u started, phase %u\n", stream->StreamId, stream->Phase);
+
+	while(_waitForRelease(stream)){
+		_lockRegistry();
+		_recordReleaseJitter(stream);
+		_unlockRegistry();
+
+		_task_id jobId = stream->DeadlineInMicroseconds ?
+				dd_tcreate_us_arg(stream->TemplateIndex, stream->Deadline, stream->Argument) :
+				dd_tcreate_arg(stream->TemplateIndex, stream->Deadline, stream->Argument);
+
+		_lockRegistry();
+		if(jobId != 0){
+			_recordStreamJob(stream, jobId);
+		}
+		_addWholeTicks(&stream->nextRelease, stream->Period);
+		_unlockRegistry();
+
+		if(jobId == 0){
+			Log("[Generator] Stream %u could not create a job\n", stream->StreamId);
+		}
+		else{
+			Log("[Generator] Stream %u released job %u\n", stream->StreamId, jobId);
+		}
+	}
+
+	Log("[Generator] Stream %u stopped\n", stream->StreamId);
+	_lockRegistry();
+	_destroyPeriodicStream(stream);
+	_unlockRegistry();
+}
+
+/*=============================================================
+                    STREAM REGISTRY INTERFACE
+ ==============================================================*/
+
+// Starts a generator for the stream. The stream releases whenever the tick count is phase modulo the period, or
+// straight away for STREAM_PHASE_NONE, or at a phase chosen to spread out releases for STREAM_PHASE_AUTO. A
+// deadline or period of 0 takes the template's default, as does a NULL argument. Returns the new stream's ID, or 0
+// if the template has no period to use or the generator could not be created.
+uint32_t sr_createStream(uint32_t templateIndex, uint32_t deadline, bool deadlineInMicroseconds, uint32_t period, uint32_t phase,
+		const uint32_t* argument){
+	const TaskTemplateInfo* info = dd_get_template_info(templateIndex);
+	if(info != NULL && deadline == 0){
+		deadline = info->DefaultDeadline;
+		deadlineInMicroseconds = false;
+	}
+	if(info != NULL && period == 0){
+		period = info->DefaultPeriod;
+	}
+	if(period == 0){
+		return 0;
+	}
+
+	PeriodicStreamPtr stream = _initializePeriodicStream(templateIndex, deadline, deadlineInMicroseconds, period);
+	stream->Argument = (argument != NULL) ? *argument : (info != NULL) ? info->Parameter : 0;
+
+	// Register the stream before its generator runs so the generator can record jobs straight away
+	_lockRegistry();
+	if(phase == STREAM_PHASE_AUTO || (phase == STREAM_PHASE_NONE && g_IsPhaseSpreadingEnabled)){
+		phase = _chooseSpreadPhase(period, _getTemplateTicks(templateIndex));
+	}
+	_scheduleFirstRelease(stream, phase);
+	stream->StreamId = g_NextStreamId++;
+	_insertIndexMapEntry(&g_StreamsById, stream->StreamId, stream);
+	_unlockRegistry();
+
+	TASK_TEMPLATE_STRUCT generatorTaskTemplate = { 0, runPeriodicGenerator, PERIODIC_TASK_STACK_SIZE, PERIODIC_GENERATOR_TASK_PRIORITY, "Periodic Task", 0, (uint32_t) stream, 0};
+	_task_id generatorId = _task_create(0, 0, (uint32_t) &generatorTaskTemplate);
+
+	_lockRegistry();
+	if(generatorId == MQX_NULL_TASK_ID){
+		_removeIndexMapEntry(&g_StreamsById, stream->StreamId);
+		_destroyPeriodicStream(stream);
+		_unlockRegistry();
+		return 0;
+	}
+	stream->GeneratorId = generatorId;
+	uint32_t streamId = stream->StreamId;
+	_unlockRegistry();
+	return streamId;
+}
+
+// Stops the stream's generator before its next release. Jobs already released keep running.
+bool sr_stopStream(uint32_t streamId){
+	_lockRegistry();
+	PeriodicStreamPtr stream = (PeriodicStreamPtr) _removeIndexMapEntry(&g_StreamsById, streamId);
+	if(stream == NULL){
+		_unlockRegistry();
+		return false;
+	}
+	stream->IsStopping = true;
+	_lwevent_set(&stream->events, STREAM_EVENT_STOP);
+	_unlockRegistry();
+	return true;
+}
+
+// Changes the stream's period. The release already scheduled keeps its time; the new period applies after it.
+bool sr_setStreamPeriod(uint32_t streamId, uint32_t period){
+	if(period == 0){
+		return false;
+	}
+
+	_lockRegistry();
+	PeriodicStreamPtr stream = (PeriodicStreamPtr) _findIndexMapEntry(&g_StreamsById, streamId);
+	if(stream == NULL){
+		_unlockRegistry();
+		return false;
+	}
+	stream->Period = period;
+	stream->Phase = _getWholeTicks(&stream->nextRelease) % period;
+	_resizeJobHistory(stream, _getJobCapacity(stream));
+	_unlockRegistry();
+	return true;
+}
+
+// When enabled, streams created without a phase are given one that spreads out releases
+void sr_setPhaseSpreading(bool isEnabled){
+	g_IsPhaseSpreadingEnabled = isEnabled;
+}
+
+// Returns the ID of the stream that released the job, or 0 if the job does not belong to a running stream
+uint32_t sr_getStreamOfJob(_task_id jobId){
+	_lockRegistry();
+	PeriodicStreamPtr stream = (PeriodicStreamPtr) _findIndexMapEntry(&g_StreamsByJob, jobId);
+	uint32_t streamId = (stream == NULL || stream->IsStopping) ? 0 : stream->StreamId;
+	_unlockRegistry();
+	return streamId;
+}
+
+// Returns a snapshot of every running stream that the caller must free, or NULL if there are none
+PeriodicStreamInfoPtr sr_getStreamList(uint32_t* count){
+	_lockRegistry();
+	*count = g_StreamsById.count;
+	if(*count == 0){
+		_unlockRegistry();
+		return NULL;
+	}
+
+	PeriodicStreamPtr* streams;
+	PeriodicStreamInfoPtr infos;
+	if(!(streams = (PeriodicStreamPtr*) malloc(sizeof(PeriodicStreamPtr) * *count))
+			|| !(infos = (PeriodicStreamInfoPtr) malloc(sizeof(PeriodicStreamInfo) * *count))){
+		printf("[Stream Registry] Unable to allocate memory for the stream list.\n");
+		_task_block();
+	}
+	_copyIndexMapValues(&g_StreamsById, (void**) streams);
+
+	for(uint32_t i=0; i<*count; i++){
+		PeriodicStreamPtr stream = streams[i];
+		infos[i].StreamId = stream->StreamId;
+		infos[i].GeneratorId = stream->GeneratorId;
+		infos[i].TemplateIndex = stream->TemplateIndex;
+		infos[i].Deadline = stream->Deadline;
+		infos[i].DeadlineInMicroseconds = stream->DeadlineInMicroseconds;
+		infos[i].Argument = stream->Argument;
+		infos[i].Period = stream->Period;
+		infos[i].Phase = stream->Phase;
+		infos[i].ReleaseCount = stream->ReleaseCount;
+		infos[i].LatestJobId = (stream->jobCount == 0) ? 0 :
+				stream->jobs[(stream->nextJobSlot + stream->jobCapacity - 1) % stream->jobCapacity];
+	}
+	_unlockRegistry();
+
+	free(streams);
+	return infos;
+}
+
+// Copies the stream's release jitter statistics. Returns false if there is no such stream.
+bool sr_getStreamJitter(uint32_t streamId, StreamJitterStatsPtr stats){
+	_lockRegistry();
+	PeriodicStreamPtr stream = (PeriodicStreamPtr) _findIndexMapEntry(&g_StreamsById, streamId);
+	if(stream != NULL){
+		*stats = stream->jitter;
+	}
+	_unlockRegistry();
+	return stream != NULL;
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+static PeriodicStreamPtr _initializePeriodicStream(uint32_t templateIndex, uint32_t deadline, bool deadlineInMicroseconds, uint32_t period){
+	PeriodicStreamPtr stream;
+	if(!(stream = (PeriodicStreamPtr) malloc(sizeof(PeriodicStream)))){
+		printf("[Stream Registry] Unable to allocate memory for a periodic stream.\n");
+		_task_block();
+	}
+	memset(stream, 0, sizeof(PeriodicStream));
+
+	if(_lwevent_create(&stream->events, LWEVENT_AUTO_CLEAR) != MQX_OK){
+		printf("[Stream Registry] Stream event initialization failed.\n");
+		_task_block();
+	}
+
+	stream->TemplateIndex = templateIndex;
+	stream->Deadline = deadline;
+	stream->DeadlineInMicroseconds = deadlineInMicroseconds;
+	stream->Period = period;
+	_resizeJobHistory(stream, _getJobCapacity(stream));
+	return stream;
+}
+
+// A job is deleted once its deadline passes, so at most deadline / period + 1 of a stream's jobs can be
+// running at once. Only those need to stay in the job index.
+static uint32_t _getJobCapacity(PeriodicStreamPtr stream){
+	uint32_t deadlineTicks = stream->Deadline;
+	if(stream->DeadlineInMicroseconds){
+		uint32_t microsecondsPerTick = 1000000 / _time_get_ticks_per_sec();
+		deadlineTicks = stream->Deadline / microsecondsPerTick + 1;
+	}
+	return deadlineTicks / stream->Period + 2;
+}
+
+// Moves the most recent jobs into a history of the given capacity, dropping any older jobs from the index
+static void _resizeJobHistory(PeriodicStreamPtr stream, uint32_t capacity){
+	if(capacity == stream->jobCapacity){
+		return;
+	}
+
+	while(stream->jobCount > capacity){
+		_forgetOldestStreamJob(stream);
+	}
+
+	_task_id* jobs;
+	if(!(jobs = (_task_id*) malloc(sizeof(_task_id) * capacity))){
+		printf("[Stream Registry] Unable to allocate memory for a stream's job history.\n");
+		_task_block();
+	}
+
+	// Copy the remaining jobs oldest first so the ring starts at slot 0
+	uint32_t oldestSlot = (stream->jobCount == 0) ? 0 : (stream->nextJobSlot + stream->jobCapacity - stream->jobCount) % stream->jobCapacity;
+	for(uint32_t i=0; i<stream->jobCount; i++){
+		jobs[i] = stream->jobs[(oldestSlot + i) % stream->jobCapacity];
+	}
+
+	free(stream->jobs);
+	stream->jobs = jobs;
+	stream->jobCapacity = capacity;
+	stream->nextJobSlot = stream->jobCount % capacity;
+}
+
+static void _recordStreamJob(PeriodicStreamPtr stream, _task_id jobId){
+	if(stream->jobCount == stream->jobCapacity){
+		_forgetOldestStreamJob(stream);
+	}
+
+	stream->jobs[stream->nextJobSlot] = jobId;
+	stream->nextJobSlot = (stream->nextJobSlot + 1) % stream->jobCapacity;
+	stream->jobCount++;
+	stream->ReleaseCount++;
+
+	// MQX can reuse the ID of a job that has already finished, so a stale binding may still be present
+	_removeIndexMapEntry(&g_StreamsByJob, jobId);
+	_insertIndexMapEntry(&g_StreamsByJob, jobId, stream);
+}
+
+static void _forgetOldestStreamJob(PeriodicStreamPtr stream){
+	uint32_t oldestSlot = (stream->nextJobSlot + stream->jobCapacity - stream->jobCount) % stream->jobCapacity;
+	_task_id jobId = stream->jobs[oldestSlot];
+	stream->jobCount--;
+
+	// Leave the binding alone if the ID has since been reused by another stream's job
+	if(_findIndexMapEntry(&g_StreamsByJob, jobId) == stream){
+		_removeIndexMapEntry(&g_StreamsByJob, jobId);
+	}
+}
+
+// Must be called with the registry mutex held, once the stream is no longer in the stream index
+static void _destroyPeriodicStream(PeriodicStreamPtr stream){
+	while(stream->jobCount > 0){
+		_forgetOldestStreamJob(stream);
+	}
+	_lwevent_destroy(&stream->events);
+	free(stream->jobs);
+	free(stream);
+}
+
+// Waits until the stream's next release is due. Returns false if the stream was stopped instead.
+static bool _waitForRelease(PeriodicStreamPtr stream){
+	MQX_TICK_STRUCT now;
+	_time_get_ticks(&now);
+
+	// A release that is already due is made at once, so a late stream catches up instead of losing releases.
+	// Releases fall on tick boundaries, so whole ticks are compared: a difference that borrowed from the current
+	// tick's hardware offset would make a release due one tick early. Stopping the stream sets the event, so
+	// the generator does not sleep out the rest of the period.
+	if(!stream->IsStopping && _getWholeTicks(&stream->nextRelease) > _getWholeTicks(&now)){
+		_lwevent_wait_until(&stream->events, STREAM_EVENT_STOP, FALSE, &stream->nextRelease);
+	}
+	return !stream->IsStopping;
+}
+
+// Must be called with the registry mutex held, as the generator wakes for a release
+static void _recordReleaseJitter(PeriodicStreamPtr stream){
+	MQX_TICK_STRUCT now;
+	bool overflow;
+	_time_get_ticks(&now);
+	int32_t jitterUs = _time_diff_microseconds(&now, &stream->nextRelease, &overflow);
+	if(overflow){
+		jitterUs = (jitterUs < 0) ? INT32_MIN : INT32_MAX;
+	}
+
+	// Early releases are kept in the statistics rather than clamped, and fall in the first bucket
+	uint32_t bucket = 0;
+	while(bucket < STREAM_JITTER_BUCKET_COUNT - 1 && jitterUs >= 0 && (uint32_t) jitterUs >= (STREAM_JITTER_FIRST_BUCKET_US << bucket)){
+		bucket++;
+	}
+
+	StreamJitterStatsPtr jitter = &stream->jitter;
+	if(jitter->ReleaseCount == 0 || jitterUs < jitter->MinJitterUs){
+		jitter->MinJitterUs = jitterUs;
+	}
+	if(jitter->ReleaseCount == 0 || jitterUs > jitter->MaxJitterUs){
+		jitter->MaxJitterUs = jitterUs;
+	}
+	if(jitterUs < 0){
+		jitter->EarlyCount++;
+	}
+	jitter->ReleaseCount++;
+	jitter->Histogram[bucket]++;
+	jitter->TotalJitterUs += jitterUs;
+	if(jitterUs >= 0 && (uint32_t) jitterUs >= stream->Period * (1000000 / _time_get_ticks_per_sec())){
+		jitter->OverrunCount++;
+	}
+}
+
+static uint64_t _getWholeTicks(const MQX_TICK_STRUCT* ticks){
+	return ((uint64_t) ticks->TICKS[1] << 32) | ticks->TICKS[0];
+}
+
+// Carries into the high tick word, so releases stay in order when the low word wraps
+static void _addWholeTicks(MQX_TICK_STRUCT* ticks, uint64_t count){
+	uint64_t wholeTicks = _getWholeTicks(ticks) + count;
+	ticks->TICKS[0] = (_mqx_uint) wholeTicks;
+	ticks->TICKS[1] = (_mqx_uint)(wholeTicks >> 32);
+}
+
+// Must be called with the registry mutex held, before the stream's generator is created
+static void _scheduleFirstRelease(PeriodicStreamPtr stream, uint32_t phase){
+	_time_get_ticks(&stream->nextRelease);
+	stream->nextRelease.HW_TICKS = 0;
+
+	uint64_t now = _getWholeTicks(&stream->nextRelease);
+	if(phase != STREAM_PHASE_NONE){
+		_addWholeTicks(&stream->nextRelease, (phase % stream->Period + stream->Period - now % stream->Period) % stream->Period);
+	}
+	stream->Phase = _getWholeTicks(&stream->nextRelease) % stream->Period;
+}
+
+// Picks the phase for a new stream that minimizes the peak number of jobs whose run windows overlap, counting
+// the running streams' releases over their hyperperiod. Time is divided into at most STREAM_PHASE_SLOT_COUNT
+// slots, and a hyperperiod longer than STREAM_PHASE_HORIZON_LIMIT ticks is cut short, so the search stays cheap
+// on any task set. Must be called with the registry mutex held.
+static uint32_t _chooseSpreadPhase(uint32_t period, uint32_t jobTicks){
+	uint32_t streamCount = g_StreamsById.count;
+	if(streamCount == 0){
+		return 0;
+	}
+
+	PeriodicStreamPtr* streams;
+	if(!(streams = (PeriodicStreamPtr*) malloc(sizeof(PeriodicStreamPtr) * streamCount))){
+		printf("[Stream Registry] Unable to allocate memory for phase assignment.\n");
+		_task_block();
+	}
+	_copyIndexMapValues(&g_StreamsById, (void**) streams);
+
+	// The horizon is the hyperperiod of the new stream and every running stream
+	uint64_t horizon = period;
+	for(uint32_t i=0; i<streamCount && horizon <= STREAM_PHASE_HORIZON_LIMIT; i++){
+		uint64_t a = horizon, b = streams[i]->Period;
+		while(b != 0){
+			uint64_t remainder = a % b;
+			a = b;
+			b = remainder;
+		}
+		horizon = horizon / a * streams[i]->Period;
+	}
+	if(horizon > STREAM_PHASE_HORIZON_LIMIT){
+		horizon = (period > STREAM_PHASE_HORIZON_LIMIT) ? period : STREAM_PHASE_HORIZON_LIMIT / period * period;
+	}
+
+	uint32_t slotTicks = (horizon + STREAM_PHASE_SLOT_COUNT - 1) / STREAM_PHASE_SLOT_COUNT;
+	uint32_t slotCount = (horizon + slotTicks - 1) / slotTicks;
+	int32_t* demand;
+	if(!(demand = (int32_t*) calloc(slotCount + 1, sizeof(int32_t)))){
+		printf("[Stream Registry] Unable to allocate memory for phase assignment.\n");
+		_task_block();
+	}
+
+	// Count, for each slot, the running streams' jobs that would be running in it if each ran on release.
+	// Each window is first marked by its ends and the counts are then summed across the slots.
+	for(uint32_t i=0; i<streamCount; i++){
+		uint32_t windowSlots = _getTemplateTicks(streams[i]->TemplateIndex) / slotTicks + 1;
+		for(uint64_t release = streams[i]->Phase; release < horizon; release += streams[i]->Period){
+			uint32_t start = release / slotTicks;
+			uint32_t end = start + windowSlots;
+			if(windowSlots >= slotCount){
+				demand[0]++;
+				demand[slotCount]--;
+			}
+			else if(end <= slotCount){
+				demand[start]++;
+				demand[end]--;
+			}
+			else{// The window wraps around the end of the horizon
+				demand[start]++;
+				demand[slotCount]--;
+				demand[0]++;
+				demand[end - slotCount]--;
+			}
+		}
+	}
+	for(uint32_t i=1; i<slotCount; i++){
+		demand[i] += demand[i - 1];
+	}
+
+	// Try each slot-aligned phase and keep the one whose busiest window is least busy
+	uint32_t windowSlots = jobTicks / slotTicks + 1;
+	uint32_t bestPhase = 0;
+	uint32_t bestPeak = UINT32_MAX;
+	for(uint32_t phase=0; phase<period; phase+=slotTicks){
+		uint32_t peak = 0;
+		for(uint64_t release = phase; release < horizon && peak < bestPeak; release += period){
+			for(uint32_t j=0; j<windowSlots && j<slotCount; j++){
+				uint32_t slotDemand = (uint32_t) demand[(release / slotTicks + j) % slotCount];
+				if(slotDemand > peak){
+					peak = slotDemand;
+				}
+			}
+		}
+		if(peak < bestPeak){
+			bestPeak = peak;
+			bestPhase = phase;
+		}
+	}
+
+	free(demand);
+	free(streams);
+	return bestPhase;
+}
+
+// Returns how long a job from the template runs for, taken from the template's WCET
+static uint32_t _getTemplateTicks(uint32_t templateIndex){
+	return dd_get_template_wcet_ticks(templateIndex);
+}
+
+static void _lockRegistry(){
+	if(_mutex_lock(&g_RegistryMutex) != MQX_OK){
+		printf("[Stream Registry] Mutex lock failed.\n");
+		_task_block();
+	}
+}
+
+static void _unlockRegistry(){
+	_mutex_unlock(&g_RegistryMutex);
+}
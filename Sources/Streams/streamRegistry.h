@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include <mutex.h>
+#include <lwevent.h>
+#include "indexMap.h"
+
+#ifndef SOURCES_STREAMREGISTRY_H_
+#define SOURCES_STREAMREGISTRY_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define PERIODIC_TASK_STACK_SIZE 700
+#define PERIODIC_GENERATOR_TASK_PRIORITY 5
+
+#define STREAM_EVENT_STOP 0x01
+
+#define STREAM_PHASE_NONE 0xFFFFFFFF		// Release the stream's first job straight away
+#define STREAM_PHASE_AUTO 0xFFFFFFFE		// Choose a phase that spreads out the running streams' releases
+#define STREAM_PHASE_SLOT_COUNT 1024		// The resolution of the phase search
+#define STREAM_PHASE_HORIZON_LIMIT 60000	// The longest hyperperiod, in ticks, the phase search considers
+
+// Jitter bucket 0 counts releases under 16 us late, including early ones, and each later bucket doubles the
+// bound, so the last bucket counts every release 16 ms late or more
+#define STREAM_JITTER_BUCKET_COUNT 12
+#define STREAM_JITTER_FIRST_BUCKET_US 16u
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a stream's release jitter, the time between a release's nominal time and the generator waking for it
+typedef struct StreamJitterStats{
+	uint32_t ReleaseCount;									// The number of releases measured
+	uint32_t Histogram[STREAM_JITTER_BUCKET_COUNT];			// Releases by lateness
+	int64_t TotalJitterUs;
+	int32_t MinJitterUs;									// Negative if a release was made early
+	int32_t MaxJitterUs;
+	uint32_t EarlyCount;									// Releases made before their nominal time
+	uint32_t OverrunCount;									// Releases more than a whole period late
+} StreamJitterStats, * StreamJitterStatsPtr;
+
+// Defines a periodic stream: a generator task that releases a job from the same template every period
+typedef struct PeriodicStream{
+	uint32_t StreamId;
+	_task_id GeneratorId;
+	uint32_t TemplateIndex;
+	uint32_t Deadline;
+	bool DeadlineInMicroseconds;
+	uint32_t Argument;				// Passed to every job the stream releases
+	volatile uint32_t Period;		// In ticks. May be changed while the stream runs.
+	uint32_t Phase;					// The stream releases whenever the tick count is Phase modulo Period
+	volatile bool IsStopping;		// Set when the stream is stopped. The generator frees the stream before exiting.
+	uint32_t ReleaseCount;			// The number of jobs the stream has released
+	MQX_TICK_STRUCT nextRelease;	// The nominal time of the next release, guarded by the registry mutex
+	StreamJitterStats jitter;
+	_task_id* jobs;					// Ring of the jobs that may still be running, indexed by the registry
+	uint32_t jobCapacity;
+	uint32_t jobCount;
+	uint32_t nextJobSlot;
+	LWEVENT_STRUCT events;			// Wakes the generator early when the stream is stopped
+} PeriodicStream, * PeriodicStreamPtr;
+
+// A snapshot of a stream's state, safe to use after the registry lock is released
+typedef struct PeriodicStreamInfo{
+	uint32_t StreamId;
+	_task_id GeneratorId;
+	uint32_t TemplateIndex;
+	uint32_t Deadline;
+	bool DeadlineInMicroseconds;
+	uint32_t Argument;
+	uint32_t Period;
+	uint32_t Phase;
+	uint32_t ReleaseCount;
+	_task_id LatestJobId;
+} PeriodicStreamInfo, * PeriodicStreamInfoPtr;
+
+/*=============================================================
+                    STREAM REGISTRY INTERFACE
+ ==============================================================*/
+
+void sr_initializeStreamRegistry();
+uint32_t sr_createStream(uint32_t templateIndex, uint32_t deadline, bool deadlineInMicroseconds, uint32_t period, uint32_t phase,
+		const uint32_t* argument);
+bool sr_stopStream(uint32_t streamId);
+bool sr_setStreamPeriod(uint32_t streamId, uint32_t period);
+uint32_t sr_getStreamOfJob(_task_id jobId);
+PeriodicStreamInfoPtr sr_getStreamList(uint32_t* count);
+void sr_setPhaseSpreading(bool isEnabled);
+bool sr_getStreamJitter(uint32_t streamId, StreamJitterStatsPtr stats);
+
+#endif
@@ -0,0 +1,123 @@
+#include <string.h>
+
+#include "frame.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define FRAME_CRC_INITIAL 0xFFFF
+#define FRAME_CRC_POLYNOMIAL 0x1021
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void _initializeFrameDecoder(FrameDecoderPtr decoder){
+	memset(decoder, 0, sizeof(FrameDecoder));
+	decoder->state = FRAME_STATE_IDLE;
+}
+
+/*=============================================================
+                      FRAME INTERFACE
+ ==============================================================*/
+
+bool _isFrameInProgress(FrameDecoderPtr decoder){
+	return decoder->state != FRAME_STATE_IDLE;
+}
+
+// Feeds one received byte to the decoder. A frame only begins at a sync byte, so while the decoder is idle
+// every other byte is left to the line editor. Once FRAME_DECODE_COMPLETE is returned the frame can be copied
+// out with _copyDecodedFrame until the next sync byte is fed in.
+FrameDecodeResult _decodeFrameCharacter(FrameDecoderPtr decoder, uint8_t character){
+	switch(decoder->state){
+		case FRAME_STATE_IDLE:
+			if(character == FRAME_SYNC_BYTE){
+				decoder->state = FRAME_STATE_LENGTH;
+			}
+			return FRAME_DECODE_IN_PROGRESS;
+
+		case FRAME_STATE_LENGTH:
+			if(character < FRAME_HEADER_SIZE || character > FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD){
+				decoder->state = FRAME_STATE_IDLE;
+				decoder->errorCount++;
+				return FRAME_DECODE_ERROR;
+			}
+			decoder->bodyLength = character;
+			decoder->received = 0;
+			decoder->crc = _updateFrameCrc(FRAME_CRC_INITIAL, character);
+			decoder->state = FRAME_STATE_BODY;
+			return FRAME_DECODE_IN_PROGRESS;
+
+		case FRAME_STATE_BODY:
+			decoder->body[decoder->received++] = character;
+			decoder->crc = _updateFrameCrc(decoder->crc, character);
+			if(decoder->received == decoder->bodyLength){
+				decoder->received = 0;
+				decoder->state = FRAME_STATE_CRC;
+			}
+			return FRAME_DECODE_IN_PROGRESS;
+
+		case FRAME_STATE_CRC:
+			if(decoder->received++ == 0){
+				decoder->receivedCrc = character;
+				return FRAME_DECODE_IN_PROGRESS;
+			}
+			decoder->receivedCrc |= (uint16_t) character << 8;
+			decoder->state = FRAME_STATE_IDLE;
+
+			if(decoder->receivedCrc != decoder->crc){
+				decoder->errorCount++;
+				return FRAME_DECODE_ERROR;
+			}
+
+			decoder->frameCount++;
+			return FRAME_DECODE_COMPLETE;
+	}
+
+	decoder->state = FRAME_STATE_IDLE;
+	return FRAME_DECODE_ERROR;
+}
+
+void _copyDecodedFrame(FrameDecoderPtr decoder, FramePtr frame){
+	frame->requestId = decoder->body[0] | ((uint16_t) decoder->body[1] << 8);
+	frame->opcode = decoder->body[2];
+	frame->length = decoder->bodyLength - FRAME_HEADER_SIZE;
+	memcpy(frame->payload, &decoder->body[FRAME_HEADER_SIZE], frame->length);
+}
+
+// Discards a frame in progress, so the decoder waits for the next sync byte
+void _abandonFrame(FrameDecoderPtr decoder){
+	if(decoder->state != FRAME_STATE_IDLE){
+		decoder->state = FRAME_STATE_IDLE;
+		decoder->errorCount++;
+	}
+}
+
+// Writes the frame to buffer, which must hold FRAME_MAX_ENCODED_SIZE bytes, and returns the encoded size
+int _encodeFrame(const FramePtr frame, uint8_t* buffer){
+	int size = 0;
+	buffer[size++] = FRAME_SYNC_BYTE;
+	buffer[size++] = FRAME_HEADER_SIZE + frame->length;
+	buffer[size++] = frame->requestId & 0xFF;
+	buffer[size++] = frame->requestId >> 8;
+	buffer[size++] = frame->opcode;
+	memcpy(&buffer[size], frame->payload, frame->length);
+	size += frame->length;
+
+	uint16_t crc = FRAME_CRC_INITIAL;
+	for(int i=1; i<size; i++){
+		crc = _updateFrameCrc(crc, buffer[i]);
+	}
+	buffer[size++] = crc & 0xFF;
+	buffer[size++] = crc >> 8;
+	return size;
+}
+
+uint16_t _updateFrameCrc(uint16_t crc, uint8_t character){
+	crc ^= (uint16_t) character << 8;
+	for(int i=0; i<8; i++){
+		crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ FRAME_CRC_POLYNOMIAL) : (uint16_t)(crc << 1);
+	}
+	return crc;
+}
@@ -0,0 +1,96 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SOURCES_FRAME_H_
+#define SOURCES_FRAME_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+// A frame on the wire is laid out as follows, with multi-byte fields little-endian:
+//   SYNC (1) | LENGTH (1) | REQUEST ID (2) | OPCODE (1) | PAYLOAD (LENGTH - 3) | CRC (2)
+// LENGTH counts the request ID, opcode and payload. The CRC is CRC-16/CCITT-FALSE over LENGTH through PAYLOAD.
+// Frame bytes may equal XON (0x11) or XOFF (0x13), so the host must turn software flow control (IXON) off while
+// it exchanges frames. The board only sends its own XON and XOFF between frames, and a host decoder skips them
+// while it looks for the next sync byte.
+#define FRAME_SYNC_BYTE 0xA5			// Not printable, so it can never begin a line typed at the terminal
+#define FRAME_HEADER_SIZE 3				// Request ID and opcode
+#define FRAME_MAX_PAYLOAD 240
+#define FRAME_MAX_ENCODED_SIZE (2 + FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + 2)
+
+#define FRAME_RESPONSE_FLAG 0x80		// Set in the opcode of every response
+
+// Request opcodes
+#define FRAME_OPCODE_CREATE 0x01		// Payload: template (1), flags (1), deadline (4), then argument (4) if flagged
+#define FRAME_OPCODE_DELETE 0x02		// Payload: task ID (4)
+#define FRAME_OPCODE_QUERY 0x03			// Payload: query (1)
+#define FRAME_OPCODE_BATCH 0x04			// Payload: count (1), followed by count create payloads
+
+#define FRAME_CREATE_FLAG_MICROSECONDS 0x01	// The create deadline is in microseconds rather than ticks
+#define FRAME_CREATE_FLAG_ARGUMENT 0x02		// The job is passed the argument that follows, not the template's parameter
+
+#define FRAME_QUERY_ACTIVE 0x00
+#define FRAME_QUERY_OVERDUE 0x01
+
+// Every response payload starts with a status byte and the board's time when it was served, in microseconds
+// since boot (8). Query responses follow it with a count (1) and that many task entries.
+#define FRAME_RESPONSE_HEADER_SIZE 9
+#define FRAME_TASK_ENTRY_SIZE 20		// Task ID (4), then its deadline (8) and creation time (8) in microseconds since boot
+
+// Response status codes, the first payload byte of every response
+#define FRAME_STATUS_OK 0x00
+#define FRAME_STATUS_FAILED 0x01
+#define FRAME_STATUS_BAD_REQUEST 0x02
+#define FRAME_STATUS_TRUNCATED 0x03		// The response did not fit in one frame
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a decoded frame
+typedef struct Frame{
+	uint16_t requestId;
+	uint8_t opcode;
+	uint8_t length;						// The number of payload bytes
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+} Frame, * FramePtr;
+
+typedef enum FrameDecoderState{
+	FRAME_STATE_IDLE,
+	FRAME_STATE_LENGTH,
+	FRAME_STATE_BODY,
+	FRAME_STATE_CRC
+} FrameDecoderState;
+
+typedef enum FrameDecodeResult{
+	FRAME_DECODE_IN_PROGRESS,
+	FRAME_DECODE_COMPLETE,
+	FRAME_DECODE_ERROR
+} FrameDecodeResult;
+
+// Defines the state of a byte-at-a-time frame decoder
+typedef struct FrameDecoder{
+	FrameDecoderState state;
+	uint8_t body[FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD];
+	uint8_t bodyLength;
+	uint8_t received;
+	uint16_t crc;
+	uint16_t receivedCrc;
+	uint32_t frameCount;				// The number of frames decoded successfully
+	uint32_t errorCount;				// The number of frames discarded for a bad length or CRC, or abandoned part way through
+} FrameDecoder, * FrameDecoderPtr;
+
+/*=============================================================
+                      FRAME INTERFACE
+ ==============================================================*/
+
+void _initializeFrameDecoder(FrameDecoderPtr decoder);
+bool _isFrameInProgress(FrameDecoderPtr decoder);
+FrameDecodeResult _decodeFrameCharacter(FrameDecoderPtr decoder, uint8_t character);
+void _copyDecodedFrame(FrameDecoderPtr decoder, FramePtr frame);
+void _abandonFrame(FrameDecoderPtr decoder);
+int _encodeFrame(const FramePtr frame, uint8_t* buffer);
+uint16_t _updateFrameCrc(uint16_t crc, uint8_t character);
+
+#endif
@@ -17,28 +17,40 @@ void _initializeHandlerBuffer(HandlerBufferPtr handlerBuffer){
 	handlerBuffer->characters = charBuffer;
 }
 
-void _initializeHandlerReaderList(HandlerReaderListPtr readerList){
-	HandlerReaderPtr* readers;
-	if(!(readers = (HandlerReaderPtr*) malloc(sizeof(HandlerReaderPtr) * HANDLER_READER_MAX))){
-		printf("Unable to allocate memory for reader list.");
+HandlerReaderTablePtr _allocateReaderTable(){
+	HandlerReaderTablePtr table;
+	if(!(table = (HandlerReaderTablePtr) malloc(sizeof(HandlerReaderTable)))){
+		printf("Unable to allocate memory for reader table.");
 		_task_block();
 	}
-	memset(readers, 0, sizeof(HandlerReaderPtr) * HANDLER_READER_MAX);
-
-	readerList->count = 0;
-	readerList->maxSize = HANDLER_READER_MAX;
-	readerList->readers = readers;
+	memset(table, 0, sizeof(HandlerReaderTable));
+	return table;
 }
 
-void _initializeHandler(HandlerPtr handler, _queue_id charInputQueue, _queue_id bufferInputQueue, uint32_t terminalInstance){
+void _initializeHandler(HandlerPtr handler, _queue_id bufferInputQueue, uint32_t terminalInstance){
+	_initializeHandlerMutex(&handler->outputMutex);
+	_initializeHandlerMutex(&handler->registrationMutex);
 	_initializeHandlerBuffer(&handler->buffer);
-	_initializeHandlerReaderList(&handler->readerList);
+	handler->readerTable = _allocateReaderTable();
 	handler->currentWriter = 0;
-	handler->charInputQueue = charInputQueue;
 	handler->bufferInputQueue = bufferInputQueue;
 	handler->terminalInstance = terminalInstance;
+	_initializeTxRing(&handler->txRing, terminalInstance);
+	_initializeRxRing(&handler->rxRing);
+	_initializeLinePool(&handler->linePool);
+	_initializeFrameDecoder(&handler->frameDecoder);
+	handler->frameReaderQueue = MSGQ_NULL_QUEUE_ID;
+	handler->readerOverflowCount = 0;
+
+	if(_lwevent_create(&handler->events, LWEVENT_AUTO_CLEAR) != MQX_OK){
+		printf("Handler event initialization failed.\n");
+		_task_block();
+	}
 }
 
+// The log drain runs below every job and can hold the output mutex while it waits for transmit ring space, so
+// the mutexes inherit the priority of their waiters. Otherwise busy jobs would hold up the handler task
+// behind the drain.
 void _initializeHandlerMutex(MUTEX_STRUCT* mutex){
 	MUTEX_ATTR_STRUCT handlerMutexAttributes;
 	if(_mutatr_init(&handlerMutexAttributes) != MQX_OK){
@@ -46,6 +58,11 @@ void _initializeHandlerMutex(MUTEX_STRUCT* mutex){
 		_task_block();
 	}
 
+	if(_mutatr_set_sched_protocol(&handlerMutexAttributes, MUTEX_PRIO_INHERIT) != MQX_OK){
+		printf("Mutex priority inheritance could not be enabled.\n");
+		_task_block();
+	}
+
 	if(_mutex_init(mutex, &handlerMutexAttributes) != MQX_OK){
 		printf("Mutex initialization failed.\n");
 		_task_block();
@@ -56,15 +73,13 @@ void _initializeHandlerMutex(MUTEX_STRUCT* mutex){
                           MESSAGES
  ==============================================================*/
 
-SerialMessagePtr _initializeSerialMessage(char* message, _queue_id destination){
+SerialMessagePtr _initializeSerialMessageWithLength(const char* message, int messageSize, _queue_id destination){
 	SerialMessagePtr serialMessage = (SerialMessagePtr)_msg_alloc(g_SerialMessagePool);
 	if (serialMessage == NULL) {
 	 printf("Could not allocate a message.\n");
 	 _task_block();
 	}
 
-	int messageSize = strlen(message);
-
 	// Allocate a new message string
 	char* messageCopy;
 	if(!(messageCopy = (char*) malloc(sizeof(char) * messageSize))){
@@ -72,59 +87,152 @@ SerialMessagePtr _initializeSerialMessage(char* message, _queue_id destination){
 		_task_block();
 	}
 
-	strncpy(messageCopy, message, messageSize);
+	memcpy(messageCopy, message, messageSize);
 
 	serialMessage->HEADER.SIZE = sizeof(SerialMessage);
 	serialMessage->HEADER.TARGET_QID = destination;
 	serialMessage->length = messageSize;
 	serialMessage->content = messageCopy;
+	serialMessage->line = NULL;
+	serialMessage->isRaw = false;
+
+	return serialMessage;
+}
+
+SerialMessagePtr _initializeSerialMessage(char* message, _queue_id destination){
+	return _initializeSerialMessageWithLength(message, strlen(message), destination);
+}
+
+SerialMessagePtr _initializeSharedLineMessage(SharedLinePtr line, _queue_id destination){
+	SerialMessagePtr serialMessage = (SerialMessagePtr)_msg_alloc(g_SerialMessagePool);
+	if (serialMessage == NULL) {
+	 printf("Could not allocate a message.\n");
+	 _task_block();
+	}
+
+	serialMessage->HEADER.SIZE = sizeof(SerialMessage);
+	serialMessage->HEADER.TARGET_QID = destination;
+	serialMessage->length = line->length;
+	serialMessage->content = line->characters;
+	serialMessage->line = line;
+	serialMessage->isRaw = false;
 
 	return serialMessage;
 }
 
+// Frees a message received by a reader, releasing its reference to a shared line
+void _disposeReaderMessage(SerialMessagePtr message, HandlerPtr handler){
+	if(message->line != NULL){
+		_releaseSharedLine(&handler->linePool, message->line);
+	}
+	else{
+		free(message->content);
+	}
+	_msg_free(message);
+}
+
 /*=============================================================
                       READER MANAGEMENT
  ==============================================================*/
 
-bool _addHandlerReader(_task_id taskId, _queue_id queue, HandlerPtr handler){
+// The reader table is never modified once published. Registration builds a new table and swaps it in, so
+// lookups and broadcasts only pin the current table for as long as they read it and never wait on a lock.
+HandlerReaderTablePtr _acquireReaderTable(HandlerPtr handler){
+	_int_disable();
+	HandlerReaderTablePtr table = handler->readerTable;
+	table->users++;
+	_int_enable();
+	return table;
+}
 
-	int currentReaderCount = handler->readerList.count;
+void _releaseReaderTable(HandlerReaderTablePtr table){
+	_int_disable();
+	table->users--;
+	bool mustFree = table->isRetired && table->users == 0;
+	LWSEM_STRUCT_PTR drainWaiter = (table->users == 1) ? table->drainWaiter : NULL;
+	if(drainWaiter != NULL){
+		table->drainWaiter = NULL;
+	}
+	_int_enable();
 
-	if(currentReaderCount == handler->readerList.maxSize){
-		return false;
+	if(drainWaiter != NULL){
+		_lwsem_post(drainWaiter);
+	}
+	if(mustFree){
+		free(table);
 	}
+}
 
-	HandlerReaderPtr reader;
-	if(!(reader = (HandlerReaderPtr) malloc(sizeof(HandlerReader)))){
-		printf("Unable to allocate memory for HandlerReader.");
+// Blocks until the caller's pin is the last one on a retired table, so no broadcast is still working from it.
+// Only the task that retired the table waits on it, since no other task can pin a table once it is replaced.
+void _waitForReaderTableDrain(HandlerReaderTablePtr table){
+	LWSEM_STRUCT drained;
+	if(_lwsem_create(&drained, 0) != MQX_OK){
+		printf("Reader table drain semaphore initialization failed.\n");
 		_task_block();
 	}
 
-	reader->queueId = queue;
-	reader->taskId = taskId;
+	_int_disable();
+	bool mustWait = table->users > 1;
+	if(mustWait){
+		table->drainWaiter = &drained;
+	}
+	_int_enable();
+
+	if(mustWait){
+		_lwsem_wait(&drained);
+	}
+	_lwsem_destroy(&drained);
+}
+
+// Must be called with the registration mutex held. The previous table is freed once no task is reading it.
+void _publishReaderTable(HandlerPtr handler, HandlerReaderTablePtr newTable){
+	_int_disable();
+	HandlerReaderTablePtr oldTable = handler->readerTable;
+	handler->readerTable = newTable;
+	oldTable->isRetired = true;
+	bool mustFree = oldTable->users == 0;
+	_int_enable();
+
+	if(mustFree){
+		free(oldTable);
+	}
+}
 
-	handler->readerList.readers[currentReaderCount] = reader;
-	handler->readerList.count++;
+// Must be called with the registration mutex held
+bool _addHandlerReader(_task_id taskId, _queue_id queue, HandlerPtr handler){
+	HandlerReaderTablePtr currentTable = handler->readerTable;
+	int currentReaderCount = currentTable->count;
+
+	if(currentReaderCount == HANDLER_READER_MAX){
+		return false;
+	}
+
+	HandlerReaderTablePtr newTable = _allocateReaderTable();
+	memcpy(newTable->readers, currentTable->readers, sizeof(HandlerReader) * currentReaderCount);
+	newTable->readers[currentReaderCount].queueId = queue;
+	newTable->readers[currentReaderCount].taskId = taskId;
+	newTable->count = currentReaderCount + 1;
 
+	_publishReaderTable(handler, newTable);
 	return true;
 }
 
+// Must be called with the registration mutex held
 bool _clearHandlerReader(_task_id taskId, HandlerPtr handler){
-	int numReaders = handler->readerList.count;
-	HandlerReaderPtr* readers = handler->readerList.readers;
+	HandlerReaderTablePtr currentTable = handler->readerTable;
+	int numReaders = currentTable->count;
 
 	for(int i=0; i<numReaders; i++){
-		if(readers[i]->taskId == taskId){
+		if(currentTable->readers[i].taskId == taskId){
 
-			// Deallocate the reader
-			free(readers[i]);
-			readers[i] = NULL;
+			// Copy every other reader into the new table
+			HandlerReaderTablePtr newTable = _allocateReaderTable();
+			memcpy(newTable->readers, currentTable->readers, sizeof(HandlerReader) * i);
+			memcpy(&newTable->readers[i], &currentTable->readers[i+1], sizeof(HandlerReader) * (numReaders - i - 1));
+			newTable->count = numReaders - 1;
 
-			// Shift the remaining readers left by 1 index
-			for (int j=i; j<numReaders-1; j++){
-				readers[j] = readers[j+1];
-			}
-			handler->readerList.count--;
+			_publishReaderTable(handler, newTable);
 			return true;
 		}
 	}
@@ -132,28 +240,59 @@ bool _clearHandlerReader(_task_id taskId, HandlerPtr handler){
 }
 
 _queue_id _getReaderQueueNum(_task_id taskId, HandlerPtr handler){
-	int numReaders = handler->readerList.count;
-	HandlerReaderPtr* readers = handler->readerList.readers;
+	HandlerReaderTablePtr table = _acquireReaderTable(handler);
+	_queue_id queueId = MSGQ_NULL_QUEUE_ID;
 
-	for(int i=0; i<numReaders; i++){
-		if(readers[i]->taskId == taskId){
-			return readers[i]->queueId;
+	for(int i=0; i<table->count; i++){
+		if(table->readers[i].taskId == taskId){
+			queueId = table->readers[i].queueId;
+			break;
 		}
 	}
 
-	return MSGQ_NULL_QUEUE_ID;
+	_releaseReaderTable(table);
+	return queueId;
 }
 
-void _writeMessageToReaders(char* message, HandlerReaderListPtr readerList){
+// Broadcasts a completed line to every reader. All readers share one pooled copy of the line, which is
+// released by the last reader to receive it.
+void _writeMessageToReaders(char* message, int length, HandlerPtr handler){
+	HandlerReaderTablePtr table = _acquireReaderTable(handler);
+
+	// A reader that has stopped calling GetLine misses lines once its backlog is full, rather than holding
+	// on to pooled lines every other reader needs
+	bool isReceiving[HANDLER_READER_MAX];
+	uint32_t receiverCount = 0;
+	for(int i=0; i<table->count; i++){
+		isReceiving[i] = _msgq_get_count(table->readers[i].queueId) < HANDLER_READER_BACKLOG_MAX;
+		if(isReceiving[i]){
+			receiverCount++;
+		}
+		else{
+			handler->readerOverflowCount++;
+		}
+	}
+
+	// The line is dropped, and counted by the pool, if every pooled line is still waiting on a slow reader
+	SharedLinePtr line = NULL;
+	if(receiverCount > 0){
+		line = _acquireSharedLine(&handler->linePool, message, length, receiverCount);
+	}
+
 	SerialMessagePtr serialMessage;
-	for(int i=0; i<readerList->count; i++){
-		serialMessage = _initializeSerialMessage(message, readerList->readers[i]->queueId);
+	for(int i=0; line != NULL && i<table->count; i++){
+		if(!isReceiving[i]){
+			continue;
+		}
+		serialMessage = _initializeSharedLineMessage(line, table->readers[i].queueId);
 		bool result = _msgq_send(serialMessage);
 		if (result != TRUE){
-			printf("Failed to send message to reader %d.\n", readerList->readers[i]->taskId);
+			printf("Failed to send message to reader %d.\n", table->readers[i].taskId);
 			_task_block();
 		}
 	}
+
+	_releaseReaderTable(table);
 }
 
 /*=============================================================
@@ -175,14 +314,12 @@ bool _clearHandlerWriter(_task_id taskId, HandlerPtr handler){
 static const char BackspaceString[] = "\b \b";
 static const int BackspaceStringLen = 3;
 
-void _printCharacterToTerminal(char character, uint32_t terminalId){
-	UART_DRV_SendData(terminalId, &character, sizeof(char));
-	OSA_TimeDelay(PRINT_DELAY_MS);
+void _printCharacterToTerminal(char character, TxRingPtr txRing){
+	_writeToTxRing(txRing, &character, 1);
 }
 
-void _printStringToTerminal(char* string, int size, uint32_t terminalId){
-	UART_DRV_SendData(terminalId, string, sizeof(char) * size);
-	OSA_TimeDelay(PRINT_DELAY_MS);
+void _printStringToTerminal(const char* string, int size, TxRingPtr txRing){
+	_writeToTxRing(txRing, string, size);
 }
 
 bool _addCharacterToEndOfBuffer(char character, HandlerBufferPtr buffer){
@@ -220,18 +357,18 @@ void _clearBuffer(HandlerBufferPtr buffer){
 }
 
 void _handleNewline(HandlerPtr handler){
-	_printStringToTerminal("\r\n", 2, handler->terminalInstance);
+	_printStringToTerminal("\r\n", 2, &handler->txRing);
 	if (handler->buffer.currentSize > 0){
 		_addCharacterToEndOfBuffer('\r', &handler->buffer);
 		_addCharacterToEndOfBuffer('\n', &handler->buffer);
-		_writeMessageToReaders(handler->buffer.characters, &handler->readerList);
+		_writeMessageToReaders(handler->buffer.characters, handler->buffer.currentSize, handler);
 		_clearBuffer(&handler->buffer);
 	}
 }
 
 void _handleBackspace(HandlerPtr handler){
 	_removeCharacterFromEndOfBuffer(&handler->buffer);
-	_printStringToTerminal(BackspaceString, BackspaceStringLen, handler->terminalInstance);
+	_printStringToTerminal(BackspaceString, BackspaceStringLen, &handler->txRing);
 }
 
 void _handleEraseLine(HandlerPtr handler){
@@ -244,7 +381,7 @@ void _handleEraseLine(HandlerPtr handler){
 			whitespaceString[i+j] = BackspaceString[j];
 		}
 	}
-	_printStringToTerminal(whitespaceString, whitespaceStringLen, handler->terminalInstance);
+	_printStringToTerminal(whitespaceString, whitespaceStringLen, &handler->txRing);
 	_clearBuffer(&handler->buffer);
 }
 
@@ -255,14 +392,14 @@ void _handleEraseWord(HandlerPtr handler){
 
 	// Clear any leading whitespace
 	while(lastChar == ' '){
-		_printStringToTerminal("\b \b",  3, handler->terminalInstance);
+		_printStringToTerminal("\b \b",  3, &handler->txRing);
 		_removeCharacterFromEndOfBuffer(buffer);
 		lastChar = _getLastCharacterInBuffer(buffer);
 	}
 
 	// Clear non-space characters until a space character is encountered or the end of the buffer is reached
 	while(lastChar != ' ' && lastChar != '\0'){
-		_printStringToTerminal("\b \b",  3, handler->terminalInstance);
+		_printStringToTerminal("\b \b",  3, &handler->txRing);
 		_removeCharacterFromEndOfBuffer(buffer);
 		lastChar = _getLastCharacterInBuffer(buffer);
 	}
@@ -282,7 +419,7 @@ void _handleEscape(HandlerPtr handler){
 
 void _handleRegularCharacter(char character, HandlerPtr handler){
 	_addCharacterToEndOfBuffer(character, &handler->buffer);
-	_printCharacterToTerminal(character, handler->terminalInstance);
+	_printCharacterToTerminal(character, &handler->txRing);
 }
 
 void _handleCharacterInput(char character, HandlerPtr handler){
@@ -317,41 +454,207 @@ void _handleCharacterInput(char character, HandlerPtr handler){
 	}
 }
 
-void _handleInterruptMessage(InterruptMessagePtr interruptMessage, HandlerPtr handler){
-	char inputChar = interruptMessage->character;
-	_handleCharacterInput(inputChar, g_Handler);
+// Called from the UART receive interrupt. The handler task is only woken when the ring stops being empty,
+// since it drains every available character each time it runs.
+void _handleUartCharacterReceived(uint8_t character, HandlerPtr handler){
+	RxRingPtr rxRing = &handler->rxRing;
+	bool wasEmpty;
+	if(_putRxRingCharacter(rxRing, character, &wasEmpty) && wasEmpty){
+		_lwevent_set(&handler->events, HANDLER_EVENT_RX_READY);
+	}
+
+	// Hold the sender off before the ring overflows
+	if(!rxRing->isThrottled && _getRxRingOccupancy(rxRing) >= RX_RING_HIGH_WATER){
+		rxRing->isThrottled = true;
+		rxRing->throttleCount++;
+		_sendTxRingControlCharacter(&handler->txRing, HANDLER_XOFF);
+	}
+}
+
+// Resumes a throttled sender once the backlog has drained to the low water mark
+void _resumeThrottledSender(HandlerPtr handler){
+	RxRingPtr rxRing = &handler->rxRing;
+	if(!rxRing->isThrottled){
+		return;
+	}
+
+	_int_disable();
+	bool mustResume = rxRing->isThrottled && _getRxRingOccupancy(rxRing) <= RX_RING_LOW_WATER;
+	if(mustResume){
+		rxRing->isThrottled = false;
+		rxRing->resumeCount++;
+	}
+	_int_enable();
+
+	if(mustResume){
+		_sendTxRingControlCharacter(&handler->txRing, HANDLER_XON);
+	}
+}
+
+// Binary frames bypass the line editor entirely: they are neither echoed nor added to the line buffer
+void _handleFrameCharacter(uint8_t character, HandlerPtr handler){
+	_time_get_ticks(&handler->lastFrameCharacterAt);
+	if(_decodeFrameCharacter(&handler->frameDecoder, character) != FRAME_DECODE_COMPLETE){
+		return;
+	}
+
+	// Frames are discarded until a task registers to read them
+	if(handler->frameReaderQueue == MSGQ_NULL_QUEUE_ID){
+		return;
+	}
+
+	FrameMessagePtr frameMessage = (FrameMessagePtr) _msg_alloc(g_FrameMessagePool);
+	if(frameMessage == NULL){
+		handler->frameDecoder.errorCount++;
+		return;
+	}
+	frameMessage->HEADER.SIZE = sizeof(FrameMessage);
+	frameMessage->HEADER.TARGET_QID = handler->frameReaderQueue;
+	_copyDecodedFrame(&handler->frameDecoder, &frameMessage->frame);
+
+	if(_msgq_send(frameMessage) != TRUE){
+		printf("Failed to send a frame to the frame reader.\n");
+		_task_block();
+	}
+}
+
+// Abandons a frame whose sender went quiet part way through, so the text typed after a truncated frame reaches
+// the line editor instead of being taken as the rest of the frame. Returns how many ticks the handler may wait
+// for input before calling this again, or 0 if it may wait indefinitely.
+_mqx_uint _expireIdleFrame(HandlerPtr handler){
+	if(!_isFrameInProgress(&handler->frameDecoder)){
+		return 0;
+	}
+
+	MQX_TICK_STRUCT now;
+	bool overflow;
+	_time_get_ticks(&now);
+	int32_t idleTicks = _time_diff_ticks_int32(&now, &handler->lastFrameCharacterAt, &overflow);
+	if(overflow || idleTicks >= HANDLER_FRAME_IDLE_TICKS){
+		_abandonFrame(&handler->frameDecoder);
+		return 0;
+	}
+	return HANDLER_FRAME_IDLE_TICKS - idleTicks;
+}
+
+void _handleReceivedCharacters(HandlerPtr handler){
+	uint8_t inputChar;
+	while(_getRxRingCharacter(&handler->rxRing, &inputChar)){
+		_resumeThrottledSender(handler);
+		if(_isFrameInProgress(&handler->frameDecoder) || inputChar == FRAME_SYNC_BYTE){
+			_handleFrameCharacter(inputChar, handler);
+		}
+		else{
+			_handleCharacterInput((char) inputChar, handler);
+		}
+	}
 }
 
 void _handleWriteMessage(SerialMessagePtr serialMessage, HandlerPtr handler){
 	char* messageString = serialMessage->content;
 
+	// Raw output goes to the transmit ring in one write; only lines put through PutLine are edited and echoed
+	if(serialMessage->isRaw){
+		_printStringToTerminal(messageString, serialMessage->length, &handler->txRing);
+		return;
+	}
+
 	for(int i=0; i < serialMessage->length; i++){
 		_handleCharacterInput(messageString[i], handler);
 	}
 }
 
 /*=============================================================
-                      USER TASK INTERFACE
+                      INSTANCE LOOKUP
  ==============================================================*/
 
-bool OpenR(uint16_t streamNumber){
-	if(_mutex_lock(&g_HandlerMutex) != MQX_OK){
+void _lockMutex(MUTEX_STRUCT* mutex){
+	if(_mutex_lock(mutex) != MQX_OK){
 		printf("Mutex lock failed.\n");
 		_task_block();
 	}
+}
+
+// Serializes writers to the handler's transmit ring
+void _lockHandlerOutput(HandlerPtr handler){
+	_lockMutex(&handler->outputMutex);
+}
+
+void _unlockHandlerOutput(HandlerPtr handler){
+	_mutex_unlock(&handler->outputMutex);
+}
+
+// Returns the handler the given task reads from, along with its reader queue
+HandlerPtr _findReaderHandler(_task_id taskId, _queue_id* readerQueue){
+	for(uint32_t i=0; i<g_HandlerCount; i++){
+		HandlerPtr handler = g_Handlers[i];
+		_queue_id queue = _getReaderQueueNum(taskId, handler);
+
+		if(queue != MSGQ_NULL_QUEUE_ID){
+			*readerQueue = queue;
+			return handler;
+		}
+	}
+	return NULL;
+}
+
+// Returns the handler whose writer input queue is the given queue, as returned by OpenW
+HandlerPtr _findWriterHandler(_queue_id queueId){
+	for(uint32_t i=0; i<g_HandlerCount; i++){
+		if(g_Handlers[i]->bufferInputQueue == queueId){
+			return g_Handlers[i];
+		}
+	}
+	return NULL;
+}
+
+// Returns the handler behind the given queue if the current task holds write access to it, or NULL
+HandlerPtr _getWriterHandler(_queue_id queueId){
+	HandlerPtr handler = _findWriterHandler(queueId);
+	if(handler == NULL){
+		return NULL;
+	}
+
+	// The writer is a single word, so it can be read without the registration mutex
+	return (handler->currentWriter == _task_get_id()) ? handler : NULL;
+}
+
+/*=============================================================
+                      USER TASK INTERFACE
+ ==============================================================*/
+
+HandlerPtr GetHandler(uint32_t index){
+	return (index < g_HandlerCount) ? g_Handlers[index] : NULL;
+}
+
+uint32_t GetHandlerCount(void){
+	return g_HandlerCount;
+}
+
+// Reads lines from the control terminal
+bool OpenR(uint16_t streamNumber){
+	return OpenRHandler(g_Handler, streamNumber);
+}
+
+// A task reads from at most one handler, since GetLine does not name one
+bool OpenRHandler(HandlerPtr handler, uint16_t streamNumber){
+	if(handler == NULL){
+		return false;
+	}
 
 	_task_id thisTask = _task_get_id();
 
 	// Ensure this task does not already have read privileges
-	if (_getReaderQueueNum(thisTask, g_Handler) != MSGQ_NULL_QUEUE_ID){
-		_mutex_unlock(&g_HandlerMutex);
+	_queue_id existingQueue;
+	if (_findReaderHandler(thisTask, &existingQueue) != NULL){
 		return false;
 	}
 
 	// Register this task for reading with the handler
-	bool result = _addHandlerReader(thisTask, streamNumber, g_Handler);
+	_lockMutex(&handler->registrationMutex);
+	bool result = _addHandlerReader(thisTask, streamNumber, handler);
+	_mutex_unlock(&handler->registrationMutex);
 
-	_mutex_unlock(&g_HandlerMutex);
 	return result;
 }
 
@@ -360,16 +663,10 @@ bool GetLine(char* outputString){
 		return false;
 	}
 
-	// Get the reader queue for this task
-	if(_mutex_lock(&g_HandlerMutex) != MQX_OK){
-		printf("Mutex lock failed.\n");
-		_task_block();
-	}
-	_queue_id readerQueue = _getReaderQueueNum(_task_get_id(), g_Handler);
-	_mutex_unlock(&g_HandlerMutex);
-
-	// Ensure this task has read privileges
-	if(readerQueue == MSGQ_NULL_QUEUE_ID){
+	// Ensure this task has read privileges, and get its reader queue
+	_queue_id readerQueue;
+	HandlerPtr handler = _findReaderHandler(_task_get_id(), &readerQueue);
+	if(handler == NULL){
 		return false;
 	}
 
@@ -382,75 +679,179 @@ bool GetLine(char* outputString){
 
 	// Copy message to output string
 	strncpy(outputString, message->content, message->length);
-
-	// Dispose of message
-	free(message->content);
-	_msg_free(message);
+	_disposeReaderMessage(message, handler);
 
 	return true;
 }
 
+// Writes to the control terminal
 _queue_id OpenW(void){
-	if(_mutex_lock(&g_HandlerMutex) != MQX_OK){
-		printf("Mutex lock failed.\n");
-		_task_block();
+	return OpenWHandler(g_Handler);
+}
+
+_queue_id OpenWHandler(HandlerPtr handler){
+	if(handler == NULL){
+		return 0;
 	}
 
-	_task_id writer = g_Handler->currentWriter;
+	_lockMutex(&handler->registrationMutex);
+
+	_task_id writer = handler->currentWriter;
 
 	if (writer != 0){
-		_mutex_unlock(&g_HandlerMutex);
+		_mutex_unlock(&handler->registrationMutex);
 		return 0;
 	}
 
-	g_Handler->currentWriter = _task_get_id();
-	_queue_id inputQueue = g_Handler->bufferInputQueue;
+	handler->currentWriter = _task_get_id();
+	_queue_id inputQueue = handler->bufferInputQueue;
 
-	_mutex_unlock(&g_HandlerMutex);
+	_mutex_unlock(&handler->registrationMutex);
 	return inputQueue;
 }
 
 bool PutLine(_queue_id queueId, char* inputString){
-	// Get current writer
-	if(_mutex_lock(&g_HandlerMutex) != MQX_OK){
-		printf("Mutex lock failed.\n");
+	// Check that current task has write access
+	HandlerPtr handler = _getWriterHandler(queueId);
+	if(handler == NULL){
+		return false;
+	}
+
+	// Initialize serial message
+	SerialMessagePtr writeMessage = _initializeSerialMessage(inputString, queueId);
+
+	// Write serial message to queue and wake the handler
+	if (!_msgq_send(writeMessage)) {
+		printf("Could not send a message.\n");
 		_task_block();
 	}
+	_lwevent_set(&handler->events, HANDLER_EVENT_WRITE_READY);
 
-	_task_id currentWriter = g_Handler->currentWriter;
+	return true;
+}
 
-	_mutex_unlock(&g_HandlerMutex);
+// Writes the buffer to the terminal exactly as given, bypassing line editing. The output is not echoed
+// character by character or broadcast to readers, and the whole buffer is queued for transmission at once.
+bool PutRaw(_queue_id queueId, const char* buffer, int length){
+	if(buffer == NULL || length <= 0){
+		return false;
+	}
 
 	// Check that current task has write access
-	if(currentWriter != _task_get_id()){
+	HandlerPtr handler = _getWriterHandler(queueId);
+	if(handler == NULL){
 		return false;
 	}
 
-	// Initialize serial message
-	SerialMessagePtr writeMessage = _initializeSerialMessage(inputString, queueId);
+	SerialMessagePtr writeMessage = _initializeSerialMessageWithLength(buffer, length, queueId);
+	writeMessage->isRaw = true;
 
-	// Write serial message to queue
+	// Write serial message to queue and wake the handler
 	if (!_msgq_send(writeMessage)) {
 		printf("Could not send a message.\n");
 		_task_block();
 	}
+	_lwevent_set(&handler->events, HANDLER_EVENT_WRITE_READY);
 
 	return true;
 }
 
+// Releases every read and write privilege the task holds, on every handler. Lines broadcast to the task but
+// not yet read are discarded, so they go back to the line pool.
 bool Close(void){
-	if(_mutex_lock(&g_HandlerMutex) != MQX_OK){
-		printf("Mutex lock failed.\n");
-		_task_block();
-	}
-
 	_task_id thisTask = _task_get_id();
+	bool closeResult = false;
+
+	for(uint32_t i=0; i<g_HandlerCount; i++){
+		HandlerPtr handler = g_Handlers[i];
+		_lockMutex(&handler->registrationMutex);
 
-	bool closeResult = _clearHandlerReader(thisTask, g_Handler) || _clearHandlerWriter(thisTask, g_Handler);
+		// Pin the table the reader is removed from, so a broadcast still working from it can be waited out
+		HandlerReaderTablePtr oldTable = _acquireReaderTable(handler);
+		_queue_id readerQueue = _getReaderQueueNum(thisTask, handler);
+		bool readerCleared = _clearHandlerReader(thisTask, handler);
+		bool writerCleared = _clearHandlerWriter(thisTask, handler);
+		_mutex_unlock(&handler->registrationMutex);
 
-	_mutex_unlock(&g_HandlerMutex);
+		if(readerCleared){
+			_waitForReaderTableDrain(oldTable);
+		}
+		_releaseReaderTable(oldTable);
+
+		// Nothing can be sent to the queue for this handler any more
+		SerialMessagePtr message;
+		while(readerCleared && (message = (SerialMessagePtr) _msgq_poll(readerQueue)) != NULL){
+			_disposeReaderMessage(message, handler);
+		}
+
+		closeResult = closeResult || readerCleared || writerCleared;
+	}
 
 	return closeResult;
 }
 
+void GetTerminalStats(HandlerPtr handler, TerminalStatsPtr stats){
+	RxRingPtr rxRing = &handler->rxRing;
+	_int_disable();
+	stats->ReceivedCount = rxRing->receivedCount;
+	stats->DroppedCount = rxRing->droppedCount;
+	stats->Occupancy = _getRxRingOccupancy(rxRing);
+	stats->MaxOccupancy = rxRing->maxOccupancy;
+	stats->IsThrottled = rxRing->isThrottled;
+	stats->ThrottleCount = rxRing->throttleCount;
+	stats->ResumeCount = rxRing->resumeCount;
+	stats->FrameCount = handler->frameDecoder.frameCount;
+	stats->FrameErrorCount = handler->frameDecoder.errorCount;
+	stats->LinePoolMaxInUse = handler->linePool.maxInUseCount;
+	stats->LinePoolExhaustedCount = handler->linePool.exhaustedCount;
+	stats->ReaderOverflowCount = handler->readerOverflowCount;
+	_int_enable();
+}
+
+// Registers the given queue to receive every binary frame decoded by the control terminal. Only one task may read frames.
+bool OpenFrameReader(_queue_id queueId){
+	_lockMutex(&g_Handler->registrationMutex);
+
+	if(g_Handler->frameReaderQueue != MSGQ_NULL_QUEUE_ID){
+		_mutex_unlock(&g_Handler->registrationMutex);
+		return false;
+	}
+	g_Handler->frameReaderQueue = queueId;
+
+	_mutex_unlock(&g_Handler->registrationMutex);
+	return true;
+}
+
+bool GetFrame(FramePtr frame){
+	if(frame == NULL || g_Handler->frameReaderQueue == MSGQ_NULL_QUEUE_ID){
+		return false;
+	}
+
+	// Wait for the next frame to arrive
+	FrameMessagePtr message = _msgq_receive(g_Handler->frameReaderQueue, 0);
+	if (message == NULL) {
+	   printf("Could not receive a frame\n");
+	   _task_block();
+	}
 
+	*frame = message->frame;
+	_msg_free(message);
+
+	return true;
+}
+
+// Encodes the frame and queues it for transmission in one write, so it cannot be interleaved with terminal output
+bool PutFrame(const FramePtr frame){
+	if(frame == NULL || frame->length > FRAME_MAX_PAYLOAD){
+		return false;
+	}
+
+	uint8_t encodedFrame[FRAME_MAX_ENCODED_SIZE];
+	int encodedSize = _encodeFrame(frame, encodedFrame);
+
+	_lockHandlerOutput(g_Handler);
+	_writeFrameToTxRing(&g_Handler->txRing, encodedFrame, encodedSize);
+	_unlockHandlerOutput(g_Handler);
+
+	return true;
+}
@@ -4,6 +4,13 @@
 #include <message.h>
 #include <mutex.h>
 #include <ctype.h>
+#include <lwevent.h>
+#include <lwsem.h>
+
+#include "txRing.h"
+#include "rxRing.h"
+#include "linePool.h"
+#include "frame.h"
 
 #ifndef SOURCES_HANDLER_H_
 #define SOURCES_HANDLER_H_
@@ -12,9 +19,18 @@
                          CONSTANTS
  ==============================================================*/
 
-#define PRINT_DELAY_MS 10
-#define HANDLER_BUFFER_SIZE 256
+#define HANDLER_BUFFER_SIZE SHARED_LINE_MAX_LENGTH	// A full buffer must fit in one shared line
 #define HANDLER_READER_MAX 32
+#define HANDLER_READER_BACKLOG_MAX 4	// Lines a reader may leave unread before it misses new ones, so one idle reader cannot hold the whole line pool
+#define HANDLER_INSTANCE_MAX 4			// The most terminals, each on its own UART, served at once
+
+#define HANDLER_XON 0x11
+#define HANDLER_XOFF 0x13
+
+#define HANDLER_FRAME_IDLE_TICKS 10		// A frame is abandoned once its sender has been quiet this long, so later text is not swallowed
+
+#define HANDLER_EVENT_RX_READY 0x01		// Set by the UART interrupt when the receive ring becomes non-empty
+#define HANDLER_EVENT_WRITE_READY 0x02	// Set by PutLine after a writer message is queued
 
 /*=============================================================
                       EXPORTED TYPES
@@ -33,23 +49,52 @@ typedef struct HandlerReader{
 	_queue_id queueId;
 } HandlerReader, *HandlerReaderPtr;
 
-// Defines a list of HandlerReader objects
-typedef struct HandlerReaderList{
+// Defines an immutable snapshot of the tasks reading from a handler. Registration replaces the whole table,
+// and a retired table is freed once the last task reading it has released it.
+typedef struct HandlerReaderTable{
 	int count;
-	int maxSize;
-	HandlerReaderPtr* readers;
-} HandlerReaderList, * HandlerReaderListPtr;
+	volatile uint32_t users;		// The number of tasks currently reading this table
+	volatile bool isRetired;		// True once a newer table has replaced this one
+	LWSEM_STRUCT_PTR volatile drainWaiter;	// Posted when only the closing task waiting on it still reads this table
+	HandlerReader readers[HANDLER_READER_MAX];
+} HandlerReaderTable, * HandlerReaderTablePtr;
 
 // Defines a structure for maintaining the handler's internal state
 typedef struct Handler{
-	HandlerReaderList readerList;
-	HandlerBuffer buffer;
-	_task_id currentWriter;
-	_queue_id charInputQueue;
+	MUTEX_STRUCT outputMutex;		// Serializes writers to the transmit ring
+	MUTEX_STRUCT registrationMutex;	// Serializes changes to the reader table, writer and frame reader
+	HandlerReaderTablePtr volatile readerTable;
+	HandlerBuffer buffer;			// Owned by the handler task
+	volatile _task_id currentWriter;
 	_queue_id bufferInputQueue;
 	uint32_t terminalInstance;
+	uint8_t rxCharacter;			// The UART driver's receive buffer for this terminal
+	TxRing txRing;
+	RxRing rxRing;
+	LinePool linePool;
+	FrameDecoder frameDecoder;
+	_queue_id frameReaderQueue;		// The queue decoded frames are sent to, or MSGQ_NULL_QUEUE_ID if frames are discarded
+	LWEVENT_STRUCT events;
+	MQX_TICK_STRUCT lastFrameCharacterAt;	// When the frame in progress last received a character
+	uint32_t readerOverflowCount;	// Lines not sent to a reader because its backlog was full
 } Handler, * HandlerPtr;
 
+// Defines a snapshot of the terminal's receive path counters
+typedef struct TerminalStats{
+	uint32_t ReceivedCount;				// Characters accepted into the receive ring
+	uint32_t DroppedCount;				// Characters lost because the receive ring was full
+	uint32_t Occupancy;					// Characters currently waiting in the receive ring
+	uint32_t MaxOccupancy;				// The largest receive backlog
+	bool IsThrottled;					// Whether the sender is currently held off with XOFF
+	uint32_t ThrottleCount;				// XOFF characters sent
+	uint32_t ResumeCount;				// XON characters sent
+	uint32_t FrameCount;				// Binary frames decoded
+	uint32_t FrameErrorCount;			// Binary frames discarded
+	uint32_t LinePoolMaxInUse;			// The most shared lines held by readers at once
+	uint32_t LinePoolExhaustedCount;	// Lines not broadcast because the line pool was empty
+	uint32_t ReaderOverflowCount;		// Lines not sent to a reader because its backlog was full
+} TerminalStats, * TerminalStatsPtr;
+
 // Defines a generic message pointer used to resolve anonymous message pointers
 typedef struct GenericMessage{
 	MESSAGE_HEADER_STRUCT HEADER;
@@ -60,41 +105,56 @@ typedef struct SerialMessage{
 	MESSAGE_HEADER_STRUCT HEADER;
 	int length;
 	char* content;
+	SharedLinePtr line;		// The shared line content points into, or NULL if content is owned by the message
+	bool isRaw;				// True if the content is written straight to the terminal without line editing
 } SerialMessage, * SerialMessagePtr;
 
-// Defines a message sent from the UART ISR to the handler
-typedef struct InterruptMessage
-{
-   MESSAGE_HEADER_STRUCT   HEADER;
-   uint8_t character;
-} InterruptMessage, * InterruptMessagePtr;
+// Defines a message carrying a decoded binary frame from the handler to the frame reader
+typedef struct FrameMessage{
+	MESSAGE_HEADER_STRUCT HEADER;
+	Frame frame;
+} FrameMessage, * FrameMessagePtr;
 
 /*=============================================================
                       GLOBAL VARIABLES
  ==============================================================*/
 
-extern _pool_id g_InterruptMessagePool;		// A message pool for messages sent between from the UART event handler to the handler task
 extern _pool_id g_SerialMessagePool;		// A message pool for messages sent between the handler task and its user tasks
-extern HandlerPtr g_Handler;				// The global handler instance
-extern MUTEX_STRUCT g_HandlerMutex;			// The mutex controlling access to the handler's internal state
+extern _pool_id g_FrameMessagePool;			// A message pool for decoded frames sent from the handler task to the frame reader
+extern HandlerPtr g_Handler;				// The control terminal's handler, which serves the scheduler interface
+extern HandlerPtr g_Handlers[HANDLER_INSTANCE_MAX];	// Every handler instance, one per terminal UART
+extern uint32_t g_HandlerCount;				// The number of handler instances in g_Handlers
 
 /*=============================================================
                       USER TASK INTERFACE
  ==============================================================*/
 
+HandlerPtr GetHandler(uint32_t index);
+uint32_t GetHandlerCount(void);
 bool OpenR(uint16_t streamNumber);
+bool OpenRHandler(HandlerPtr handler, uint16_t streamNumber);
 bool GetLine(char* outputString);
 _queue_id OpenW(void);
+_queue_id OpenWHandler(HandlerPtr handler);
 bool PutLine(_queue_id queueId, char* inputString);
+bool PutRaw(_queue_id queueId, const char* buffer, int length);
 bool Close(void);
+void GetTerminalStats(HandlerPtr handler, TerminalStatsPtr stats);
+bool OpenFrameReader(_queue_id queueId);
+bool GetFrame(FramePtr frame);
+bool PutFrame(const FramePtr frame);
 
 /*=============================================================
                       INTERNAL INTERFACE
  ==============================================================*/
 
-void _initializeHandler(HandlerPtr handler, _queue_id charInputQueue, _queue_id bufferInputQueue, uint32_t terminalInstance);
+void _initializeHandler(HandlerPtr handler, _queue_id bufferInputQueue, uint32_t terminalInstance);
 void _initializeHandlerMutex(MUTEX_STRUCT* mutex);
-void _handleInterruptMessage(InterruptMessagePtr interruptMessage, HandlerPtr handler);
+void _handleUartCharacterReceived(uint8_t character, HandlerPtr handler);
+void _handleReceivedCharacters(HandlerPtr handler);
+_mqx_uint _expireIdleFrame(HandlerPtr handler);
 void _handleWriteMessage(SerialMessagePtr serialMessage, HandlerPtr handler);
+void _lockHandlerOutput(HandlerPtr handler);
+void _unlockHandlerOutput(HandlerPtr handler);
 
 #endif
@@ -0,0 +1,72 @@
+#include "linePool.h"
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void _initializeLinePool(LinePoolPtr pool){
+	SharedLinePtr lines;
+	if(!(lines = (SharedLinePtr) malloc(sizeof(SharedLine) * LINE_POOL_SIZE))){
+		printf("Unable to allocate memory for the line pool.");
+		_task_block();
+	}
+
+	// Chain every line into the free list
+	for(int i=0; i<LINE_POOL_SIZE; i++){
+		lines[i].next = (i < LINE_POOL_SIZE - 1) ? &lines[i+1] : NULL;
+		lines[i].referenceCount = 0;
+		lines[i].length = 0;
+	}
+
+	pool->lines = lines;
+	pool->freeList = lines;
+	pool->inUseCount = 0;
+	pool->maxInUseCount = 0;
+	pool->exhaustedCount = 0;
+}
+
+/*=============================================================
+                      LINE POOL INTERFACE
+ ==============================================================*/
+
+// Copies a completed line into a free shared line that will be released after referenceCount releases.
+// Returns NULL if every line is still held by a reader.
+SharedLinePtr _acquireSharedLine(LinePoolPtr pool, const char* characters, int length, uint32_t referenceCount){
+	if(length > SHARED_LINE_MAX_LENGTH){
+		length = SHARED_LINE_MAX_LENGTH;
+	}
+
+	_int_disable();
+	SharedLinePtr line = pool->freeList;
+	if(line == NULL){
+		pool->exhaustedCount++;
+		_int_enable();
+		return NULL;
+	}
+	pool->freeList = line->next;
+	pool->inUseCount++;
+	if(pool->inUseCount > pool->maxInUseCount){
+		pool->maxInUseCount = pool->inUseCount;
+	}
+	_int_enable();
+
+	// The line is not visible to any reader yet, so it can be filled without holding the lock
+	memcpy(line->characters, characters, length);
+	line->characters[length] = '\0';
+	line->length = length;
+	line->next = NULL;
+	line->referenceCount = referenceCount;
+
+	return line;
+}
+
+// Drops one reader's reference, returning the line to the pool once no reader holds it
+void _releaseSharedLine(LinePoolPtr pool, SharedLinePtr line){
+	_int_disable();
+	if(--line->referenceCount == 0){
+		line->next = pool->freeList;
+		pool->freeList = line;
+		pool->inUseCount--;
+	}
+	_int_enable();
+}
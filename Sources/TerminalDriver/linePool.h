@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_LINEPOOL_H_
+#define SOURCES_LINEPOOL_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define SHARED_LINE_MAX_LENGTH 256
+#define LINE_POOL_SIZE 16
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a completed terminal line shared by every reader it is broadcast to. The line is returned to its
+// pool when the last reader holding a reference has copied it out.
+typedef struct SharedLine{
+	struct SharedLine* next;			// The next free line while the line is in the pool's free list
+	volatile uint32_t referenceCount;	// The number of readers that have not yet received the line
+	int length;
+	char characters[SHARED_LINE_MAX_LENGTH + 1];
+} SharedLine, * SharedLinePtr;
+
+// Defines a fixed pool of shared lines, allocated by the handler task and released by reader tasks
+typedef struct LinePool{
+	SharedLinePtr lines;
+	SharedLinePtr freeList;
+	uint32_t inUseCount;				// The number of lines currently referenced by at least one reader
+	uint32_t maxInUseCount;				// The largest number of lines referenced at once
+	uint32_t exhaustedCount;			// The number of lines that could not be broadcast because the pool was empty
+} LinePool, * LinePoolPtr;
+
+/*=============================================================
+                      LINE POOL INTERFACE
+ ==============================================================*/
+
+void _initializeLinePool(LinePoolPtr pool);
+SharedLinePtr _acquireSharedLine(LinePoolPtr pool, const char* characters, int length, uint32_t referenceCount);
+void _releaseSharedLine(LinePoolPtr pool, SharedLinePtr line);
+
+#endif
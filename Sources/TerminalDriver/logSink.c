@@ -0,0 +1,189 @@
+#include "logSink.h"
+
+/*=============================================================
+                     LOCAL GLOBAL VARIABLES
+ ==============================================================*/
+
+static LogRecord g_Records[LOG_RING_SIZE];		// The record ring shared by every logging task
+static volatile uint32_t g_Head;				// Free-running count of slots filled by writers
+static volatile uint32_t g_Tail;				// Free-running count of slots drained by the drain task
+static LWEVENT_STRUCT g_Events;					// Wakes the drain task when a record is added to an empty log
+static volatile bool g_IsStarted;				// Whether the drain task and its event exist yet
+static HandlerPtr g_LogHandler;					// The terminal records are drained to
+static LogSinkStats g_Stats;					// Logging statistics
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static bool _appendLogRecord(uint8_t type, uint16_t tag, const void* data, uint16_t length, uint32_t startHwTicks);
+static uint32_t _getElapsedHwTicks(uint32_t startHwTicks);
+static void _runLogDrain(uint32_t parameter);
+static void _writeLogRecordToTerminal(LogRecordPtr record);
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+// Starts the drain task, which writes records to the given terminal. Must be called once that terminal's handler
+// has been initialized. Records logged before this are kept and drained once the task starts.
+void _initializeLogSink(HandlerPtr handler){
+	g_LogHandler = handler;
+
+	if(_lwevent_create(&g_Events, LWEVENT_AUTO_CLEAR) != MQX_OK){
+		printf("Log sink event initialization failed.\n");
+		_task_block();
+	}
+	g_IsStarted = true;
+
+	TASK_TEMPLATE_STRUCT drainTaskTemplate = { 0, _runLogDrain, LOG_DRAIN_TASK_STACK_SIZE, LOG_DRAIN_TASK_PRIORITY, "Log Drain", 0, 0, 0};
+	if(_task_create(0, 0, (uint32_t) &drainTaskTemplate) == MQX_NULL_TASK_ID){
+		printf("Unable to create the log drain task.\n");
+		_task_block();
+	}
+}
+
+/*=============================================================
+                      USER TASK INTERFACE
+ ==============================================================*/
+
+// Formats a text record into the log and returns without waiting for it to be written to the terminal.
+// Returns false if the record was dropped because the log is full.
+bool Log(const char* format, ...){
+	uint32_t startHwTicks = _time_get_hwticks();
+
+	// Format outside the critical section
+	char text[LOG_RECORD_DATA_SIZE];
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(text, LOG_RECORD_DATA_SIZE, format, arguments);
+	va_end(arguments);
+
+	length = (length < 0) ? 0 : ((length >= LOG_RECORD_DATA_SIZE) ? LOG_RECORD_DATA_SIZE - 1 : length);
+	return _appendLogRecord(LOG_RECORD_TYPE_TEXT, 0, text, length, startHwTicks);
+}
+
+// Copies a binary record into the log. The drain task writes it to the terminal as hex.
+bool LogRecordBinary(uint16_t tag, const void* data, uint16_t length){
+	uint32_t startHwTicks = _time_get_hwticks();
+	if(length > LOG_RECORD_DATA_SIZE){
+		length = LOG_RECORD_DATA_SIZE;
+	}
+	return _appendLogRecord(LOG_RECORD_TYPE_BINARY, tag, data, length, startHwTicks);
+}
+
+void getLogSinkStats(LogSinkStatsPtr stats){
+	_int_disable();
+	*stats = g_Stats;
+	_int_enable();
+}
+
+uint32_t _convertLogHwTicksToNanoseconds(uint64_t hwTicks){
+	uint64_t hwTicksPerSecond = (uint64_t) _time_get_hwticks_per_tick() * _time_get_ticks_per_sec();
+	return (uint32_t) ((hwTicks * 1000000000ULL) / hwTicksPerSecond);
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+// Claims the next free slot and fills it with interrupts disabled. The copy is at most LOG_RECORD_DATA_SIZE
+// bytes, and formatting has already been done by the caller, so the critical section stays short. Returns
+// false if every slot is waiting to be drained.
+static bool _appendLogRecord(uint8_t type, uint16_t tag, const void* data, uint16_t length, uint32_t startHwTicks){
+	_task_id taskId = _task_get_id();
+
+	_int_disable();
+	uint32_t head = g_Head;
+	uint32_t occupancy = head - g_Tail;
+	if(occupancy == LOG_RING_SIZE){
+		g_Stats.DroppedCount++;
+		_int_enable();
+		return false;
+	}
+
+	LogRecordPtr record = &g_Records[head & (LOG_RING_SIZE - 1)];
+	record->type = type;
+	record->tag = tag;
+	record->length = length;
+	record->taskId = taskId;
+	memcpy(record->data, data, length);
+	g_Head = head + 1;
+	if(occupancy + 1 > g_Stats.MaxOccupancy){
+		g_Stats.MaxOccupancy = occupancy + 1;
+	}
+	_int_enable();
+
+	// The drain task only needs waking if the log was empty; later records are picked up as it drains
+	if(g_IsStarted && occupancy == 0){
+		_lwevent_set(&g_Events, LOG_EVENT_RECORD_READY);
+	}
+
+	uint32_t cost = _getElapsedHwTicks(startHwTicks);
+	_int_disable();
+	g_Stats.RecordCount++;
+	g_Stats.TotalCostHwTicks += cost;
+	if(cost > g_Stats.MaxCostHwTicks){
+		g_Stats.MaxCostHwTicks = cost;
+	}
+	_int_enable();
+	return true;
+}
+
+// Assumes the call took less than one tick, which holds for every record that fits in a slot
+static uint32_t _getElapsedHwTicks(uint32_t startHwTicks){
+	uint32_t endHwTicks = _time_get_hwticks();
+	if(endHwTicks < startHwTicks){
+		endHwTicks += _time_get_hwticks_per_tick();
+	}
+	return endHwTicks - startHwTicks;
+}
+
+/*=============================================================
+                         DRAIN TASK
+ ==============================================================*/
+
+static void _runLogDrain(uint32_t parameter){
+	while(1){
+		// Wait for a writer to add a record
+		if(g_Tail == g_Head){
+			if(_lwevent_wait_ticks(&g_Events, LOG_EVENT_RECORD_READY, FALSE, 0) != MQX_OK){
+				printf("[Log Drain] Failed to wait for log records.\n");
+				_task_block();
+			}
+			continue;
+		}
+
+		// Release the slot only after it has been written out
+		_writeLogRecordToTerminal(&g_Records[g_Tail & (LOG_RING_SIZE - 1)]);
+		g_Tail++;
+	}
+}
+
+static void _writeLogRecordToTerminal(LogRecordPtr record){
+	char line[LOG_RECORD_DATA_SIZE * 3 + 48];
+	int length = 0;
+
+	if(record->type == LOG_RECORD_TYPE_BINARY){
+		length = snprintf(line, sizeof(line), "[Log] Task %u record %u:", record->taskId, record->tag);
+		for(int i=0; i<record->length; i++){
+			length += snprintf(&line[length], sizeof(line) - length, " %02x", (uint8_t) record->data[i]);
+		}
+		line[length++] = '\r';
+		line[length++] = '\n';
+	}
+	else{
+		// The terminal needs a carriage return before every line feed
+		for(int i=0; i<record->length; i++){
+			if(record->data[i] == '\n'){
+				line[length++] = '\r';
+			}
+			line[length++] = record->data[i];
+		}
+	}
+
+	// The transmit ring is shared with the handler task, which only writes to it while holding the output mutex
+	_lockHandlerOutput(g_LogHandler);
+	_writeToTxRing(&g_LogHandler->txRing, line, length);
+	_unlockHandlerOutput(g_LogHandler);
+}
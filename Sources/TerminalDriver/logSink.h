@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include <lwevent.h>
+
+#include "handler.h"
+
+#ifndef SOURCES_LOGSINK_H_
+#define SOURCES_LOGSINK_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define LOG_RING_SIZE 64				// Must be a power of two
+#define LOG_RECORD_DATA_SIZE 96			// The largest formatted or binary record, truncated beyond this
+#define LOG_DRAIN_TASK_PRIORITY 30		// Below every scheduler, interface and user task
+#define LOG_DRAIN_TASK_STACK_SIZE 1024
+
+#define LOG_RECORD_TYPE_TEXT 0
+#define LOG_RECORD_TYPE_BINARY 1
+
+#define LOG_EVENT_RECORD_READY 0x01		// Set when a record is added to an empty log
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a single log record slot. A writer prepares the record on its own stack and copies it into the slot
+// in the same critical section that claims it, so a writer destroyed part way through never leaves a slot
+// the drain task would wait on.
+typedef struct LogRecord{
+	uint8_t type;
+	uint16_t tag;						// The caller's record identifier for binary records
+	uint16_t length;
+	_task_id taskId;
+	char data[LOG_RECORD_DATA_SIZE];
+} LogRecord, * LogRecordPtr;
+
+// Defines the logging statistics reported to the terminal
+typedef struct LogSinkStats{
+	uint32_t RecordCount;				// The number of records accepted
+	uint32_t DroppedCount;				// The number of records lost because every slot was waiting to be drained
+	uint32_t MaxOccupancy;				// The largest number of records waiting at once
+	uint64_t TotalCostHwTicks;			// The time spent inside Log and LogRecordBinary, in hardware ticks
+	uint32_t MaxCostHwTicks;			// The longest single call, in hardware ticks
+} LogSinkStats, * LogSinkStatsPtr;
+
+/*=============================================================
+                      USER TASK INTERFACE
+ ==============================================================*/
+
+bool Log(const char* format, ...);
+bool LogRecordBinary(uint16_t tag, const void* data, uint16_t length);
+void getLogSinkStats(LogSinkStatsPtr stats);
+uint32_t _convertLogHwTicksToNanoseconds(uint64_t hwTicks);
+
+/*=============================================================
+                      INTERNAL INTERFACE
+ ==============================================================*/
+
+void _initializeLogSink(HandlerPtr handler);
+
+#endif
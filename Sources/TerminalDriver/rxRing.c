@@ -0,0 +1,60 @@
+#include "rxRing.h"
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void _initializeRxRing(RxRingPtr ring){
+	ring->head = 0;
+	ring->tail = 0;
+	ring->receivedCount = 0;
+	ring->droppedCount = 0;
+	ring->maxOccupancy = 0;
+	ring->isThrottled = false;
+	ring->throttleCount = 0;
+	ring->resumeCount = 0;
+}
+
+/*=============================================================
+                      RX RING INTERFACE
+ ==============================================================*/
+
+// Called from the UART interrupt. Returns false if the character was dropped because the ring is full.
+// wasEmpty is set when the ring held no characters before this one, i.e. when the reader must be woken.
+bool _putRxRingCharacter(RxRingPtr ring, uint8_t character, bool* wasEmpty){
+	uint32_t head = ring->head;
+	uint32_t occupancy = head - ring->tail;
+
+	*wasEmpty = (occupancy == 0);
+	if(occupancy == RX_RING_SIZE){
+		ring->droppedCount++;
+		return false;
+	}
+
+	// Store the character before publishing it by advancing the head
+	ring->characters[head & (RX_RING_SIZE - 1)] = character;
+	ring->head = head + 1;
+
+	ring->receivedCount++;
+	if(occupancy + 1 > ring->maxOccupancy){
+		ring->maxOccupancy = occupancy + 1;
+	}
+	return true;
+}
+
+// Called from the handler task. Returns false if the ring is empty.
+bool _getRxRingCharacter(RxRingPtr ring, uint8_t* character){
+	uint32_t tail = ring->tail;
+	if(tail == ring->head){
+		return false;
+	}
+
+	// Read the character before releasing its slot by advancing the tail
+	*character = ring->characters[tail & (RX_RING_SIZE - 1)];
+	ring->tail = tail + 1;
+	return true;
+}
+
+uint32_t _getRxRingOccupancy(RxRingPtr ring){
+	return ring->head - ring->tail;
+}
@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_RXRING_H_
+#define SOURCES_RXRING_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define RX_RING_SIZE 256	// Must be a power of two
+#define RX_RING_HIGH_WATER 192	// The sender is throttled once this many characters are waiting
+#define RX_RING_LOW_WATER 64	// The sender is resumed once the backlog drains to this many characters
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a single-producer/single-consumer receive ring. The UART interrupt is the only writer of head
+// and the handler task is the only writer of tail, so neither side needs a lock.
+typedef struct RxRing{
+	volatile uint8_t characters[RX_RING_SIZE];
+	volatile uint32_t head;				// Free-running count of characters written by the interrupt
+	volatile uint32_t tail;				// Free-running count of characters read by the handler
+	volatile uint32_t receivedCount;	// The number of characters accepted into the ring
+	volatile uint32_t droppedCount;		// The number of characters lost because the ring was full
+	volatile uint32_t maxOccupancy;		// The largest number of characters waiting in the ring
+	volatile bool isThrottled;			// True between sending XOFF and sending XON
+	volatile uint32_t throttleCount;	// The number of times XOFF was sent
+	volatile uint32_t resumeCount;		// The number of times XON was sent
+} RxRing, * RxRingPtr;
+
+/*=============================================================
+                      RX RING INTERFACE
+ ==============================================================*/
+
+void _initializeRxRing(RxRingPtr ring);
+bool _putRxRingCharacter(RxRingPtr ring, uint8_t character, bool* wasEmpty);
+bool _getRxRingCharacter(RxRingPtr ring, uint8_t* character);
+uint32_t _getRxRingOccupancy(RxRingPtr ring);
+
+#endif
@@ -0,0 +1,175 @@
+#include "txRing.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _waitForTxRingSpace(TxRingPtr ring);
+static void _startTransmission(TxRingPtr ring);
+static bool _isInsideFrame(TxRingPtr ring);
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+void _initializeTxRing(TxRingPtr ring, uint32_t terminalInstance){
+	uint8_t* characters;
+	if(!(characters = (uint8_t*) malloc(sizeof(uint8_t) * TX_RING_SIZE))){
+		printf("Unable to allocate memory for the transmit ring.");
+		_task_block();
+	}
+
+	if(_lwsem_create(&ring->spaceAvailable, 0) != MQX_OK){
+		printf("Transmit ring semaphore initialization failed.\n");
+		_task_block();
+	}
+
+	ring->characters = characters;
+	ring->maxSize = TX_RING_SIZE;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->count = 0;
+	ring->isTransmitting = false;
+	ring->isWriterWaiting = false;
+	ring->queuedCount = 0;
+	ring->sentCount = 0;
+	ring->frameStart = 0;
+	ring->frameEnd = 0;
+	ring->pendingControl = 0;
+	ring->isSendingControl = false;
+	ring->controlCharacter = 0;
+	ring->terminalInstance = terminalInstance;
+}
+
+/*=============================================================
+                      TX RING INTERFACE
+ ==============================================================*/
+
+// Queues characters for transmission and returns without waiting for them to be sent, unless the ring is full
+void _writeToTxRing(TxRingPtr ring, const char* characters, int size){
+	for(int i=0; i<size; i++){
+		while(ring->count == ring->maxSize){
+			_waitForTxRingSpace(ring);
+		}
+
+		// Only the writer advances the head, so the character can be stored before it is published
+		ring->characters[ring->head] = (uint8_t) characters[i];
+		ring->head = (ring->head + 1) % ring->maxSize;
+
+		_int_disable();
+		ring->count++;
+		ring->queuedCount++;
+		bool mustStart = !ring->isTransmitting;
+		if(mustStart){
+			ring->isTransmitting = true;
+		}
+		_int_enable();
+
+		if(mustStart){
+			_startTransmission(ring);
+		}
+	}
+}
+
+// Queues a binary frame. Flow control characters are held back until the frame has been sent, so they never
+// land inside it. Frame bytes may themselves equal XON or XOFF, so the host must not act on flow control while
+// it exchanges frames.
+void _writeFrameToTxRing(TxRingPtr ring, const uint8_t* characters, int size){
+	_int_disable();
+	// A frame queued behind one still being sent extends the span instead of replacing it
+	if((int32_t)(ring->sentCount - ring->frameEnd) >= 0){
+		ring->frameStart = ring->queuedCount;
+	}
+	ring->frameEnd = ring->queuedCount + size;
+	_int_enable();
+
+	_writeToTxRing(ring, (const char*) characters, size);
+}
+
+// Called from the UART interrupt after the character at the ring's tail, or a flow control character,
+// has been written to the UART
+void _handleTxRingCharacterSent(TxRingPtr ring, uart_state_t* uartState){
+	if(ring->isSendingControl){
+		ring->isSendingControl = false;
+	}
+	else{
+		ring->tail = (ring->tail + 1) % ring->maxSize;
+		ring->count--;
+		ring->sentCount++;
+	}
+
+	if(ring->isWriterWaiting && ring->count < ring->maxSize){
+		ring->isWriterWaiting = false;
+		_lwsem_post(&ring->spaceAvailable);
+	}
+
+	// Send a pending flow control character ahead of the queue unless a frame is part way out, then point the
+	// driver at the next character, or end the transfer if the ring is empty. A control character held back by
+	// a frame whose remaining characters are not queued yet goes out once the frame's last character is sent.
+	if(ring->pendingControl != 0 && !_isInsideFrame(ring)){
+		ring->controlCharacter = ring->pendingControl;
+		ring->pendingControl = 0;
+		ring->isSendingControl = true;
+		uartState->txBuff = &ring->controlCharacter;
+	}
+	else if(ring->count > 0){
+		uartState->txBuff = &ring->characters[ring->tail];
+	}
+	else{
+		uartState->txSize = 0;
+		ring->isTransmitting = false;
+	}
+}
+
+// Sends a flow control character as soon as the character currently being transmitted completes, ahead of
+// anything queued, or after the frame being transmitted. May be called from the UART receive interrupt or from
+// a task.
+void _sendTxRingControlCharacter(TxRingPtr ring, uint8_t character){
+	_int_disable();
+	if(ring->isTransmitting || _isInsideFrame(ring)){
+		// A later control character supersedes one that has not been sent yet
+		ring->pendingControl = character;
+		_int_enable();
+		return;
+	}
+	ring->isTransmitting = true;
+	ring->controlCharacter = character;
+	ring->isSendingControl = true;
+	_int_enable();
+
+	if(UART_DRV_SendData(ring->terminalInstance, &ring->controlCharacter, 1) != kStatus_UART_Success){
+		ring->isSendingControl = false;
+		ring->isTransmitting = false;
+	}
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+static void _waitForTxRingSpace(TxRingPtr ring){
+	_int_disable();
+	bool isFull = (ring->count == ring->maxSize);
+	if(isFull){
+		ring->isWriterWaiting = true;
+	}
+	_int_enable();
+
+	if(isFull){
+		_lwsem_wait(&ring->spaceAvailable);
+	}
+}
+
+// True once a frame's first character has been sent and until its last one has. Must be called with
+// interrupts disabled or from the UART interrupt.
+static bool _isInsideFrame(TxRingPtr ring){
+	return (int32_t)(ring->sentCount - ring->frameStart) > 0 && (int32_t)(ring->sentCount - ring->frameEnd) < 0;
+}
+
+static void _startTransmission(TxRingPtr ring){
+	// The transfer size stays at 1 while the interrupt keeps advancing txBuff through the ring
+	if(UART_DRV_SendData(ring->terminalInstance, &ring->characters[ring->tail], 1) != kStatus_UART_Success){
+		printf("Unable to start a UART transmission.\n");
+		_task_block();
+	}
+}
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include <lwsem.h>
+#include <fsl_uart_driver.h>
+
+#ifndef SOURCES_TXRING_H_
+#define SOURCES_TXRING_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define TX_RING_SIZE 512
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines a UART transmit ring, filled by the handler task and drained by the UART TX-empty interrupt
+typedef struct TxRing{
+	uint8_t* characters;
+	uint32_t maxSize;
+	volatile uint32_t head;				// The index the next queued character is written to
+	volatile uint32_t tail;				// The index of the character currently being transmitted
+	volatile uint32_t count;			// The number of characters queued, including the one being transmitted
+	volatile bool isTransmitting;		// True while the UART interrupt is draining the ring
+	volatile bool isWriterWaiting;		// True while a writer is blocked on a full ring
+	volatile uint32_t queuedCount;		// Free-running count of characters queued by the writer
+	volatile uint32_t sentCount;		// Free-running count of queued characters the interrupt has sent
+	volatile uint32_t frameStart;		// The queued character count at which the latest frame begins
+	volatile uint32_t frameEnd;			// The queued character count at which the latest frame ends
+	volatile uint8_t pendingControl;	// A flow control character to send ahead of the queued characters, or 0
+	volatile bool isSendingControl;		// True while the character being transmitted is a flow control character
+	uint8_t controlCharacter;			// The flow control character being transmitted
+	LWSEM_STRUCT spaceAvailable;		// Posted by the interrupt when a blocked writer can continue
+	uint32_t terminalInstance;
+} TxRing, * TxRingPtr;
+
+/*=============================================================
+                      TX RING INTERFACE
+ ==============================================================*/
+
+void _initializeTxRing(TxRingPtr ring, uint32_t terminalInstance);
+void _writeToTxRing(TxRingPtr ring, const char* characters, int size);
+void _writeFrameToTxRing(TxRingPtr ring, const uint8_t* characters, int size);
+void _handleTxRingCharacterSent(TxRingPtr ring, uart_state_t* uartState);
+void _sendTxRingControlCharacter(TxRingPtr ring, uint8_t character);
+
+#endif
@@ -0,0 +1,138 @@
+#include "taskTrace.h"
+#include "../Accounting/cpuAccounting.h"
+#include "../Scheduler/templateRegistry.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _appendEvent(uint64_t cycles, TraceEventType type, _task_id taskId, uint32_t argument);
+static bool _isJob(_task_id taskId);
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+// Written by the context switch hook and the scheduler with interrupts disabled, and only read once tracing stops
+static TraceEvent g_Events[TRACE_BUFFER_EVENT_COUNT];
+static uint32_t g_EventCount = 0;
+static uint32_t g_DroppedCount = 0;
+static volatile bool g_IsTracing = false;
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+// Timestamps come from the CPU accounting cycle clock, so CPU accounting must be initialized first
+void tr_initializeTrace(){
+	g_EventCount = 0;
+	g_DroppedCount = 0;
+	g_IsTracing = false;
+}
+
+/*=============================================================
+                       TRACE INTERFACE
+ ==============================================================*/
+
+// Discards any previous trace and starts recording into the empty buffer
+void tr_startTrace(){
+	_int_disable();
+	g_EventCount = 0;
+	g_DroppedCount = 0;
+	g_IsTracing = true;
+	_int_enable();
+}
+
+void tr_stopTrace(){
+	_int_disable();
+	g_IsTracing = false;
+	_int_enable();
+}
+
+// Records an event from task context
+void tr_traceEvent(TraceEventType type, _task_id taskId, uint32_t argument){
+	if(!g_IsTracing){
+		return;
+	}
+
+	_int_disable();
+	_appendEvent(ca_readCycleTime(), type, taskId, argument);
+	_int_enable();
+}
+
+// Called by the context switch hook, with interrupts disabled, once the outgoing task has been charged
+void tr_traceContextSwitch(_task_id taskId, uint64_t cycles){
+	if(g_IsTracing){
+		_appendEvent(cycles, TRACE_EVENT_SWITCH, taskId, 0);
+	}
+}
+
+// Stops tracing and prints the buffer to the console in the form Tools/TraceExport/ddTraceExport reads:
+//   #trace begin <cycles per second> <events> <dropped>
+//   template <index> <name>
+//   task <task id> <name>
+//   event <cycles in hex> <type letter> <task id> <argument>
+//   #trace end
+void tr_dumpTrace(){
+	tr_stopTrace();
+
+	printf("#trace begin %u %u %u\n", _getCycleClockHz(), g_EventCount, g_DroppedCount);
+	uint32_t templateCount = dd_get_template_count();
+	for(uint32_t i = 0; i < templateCount; i++){
+		printf("template %u %s\n", i, dd_get_template_info(i)->Name);
+	}
+
+	// Jobs are named after their template by the converter. Other tasks are named here if they still exist.
+	_task_id namedTasks[TRACE_NAMED_TASK_MAX];
+	uint32_t namedCount = 0;
+	for(uint32_t i = 0; i < g_EventCount && namedCount < TRACE_NAMED_TASK_MAX; i++){
+		_task_id taskId = g_Events[i].TaskId;
+		uint32_t j = 0;
+		while(j < namedCount && namedTasks[j] != taskId){
+			j++;
+		}
+		if(j < namedCount || _isJob(taskId)){
+			continue;
+		}
+
+		namedTasks[namedCount++] = taskId;
+		const char* name = ca_getTaskName(taskId);
+		if(name != NULL){
+			printf("task %u %s\n", taskId, name);
+		}
+	}
+
+	for(uint32_t i = 0; i < g_EventCount; i++){
+		TraceEventPtr event = &g_Events[i];
+		printf("event %08x%08x %c %u %u\n", (uint32_t)(event->Cycles >> 32), (uint32_t) event->Cycles, event->Type,
+				event->TaskId, event->Argument);
+	}
+	printf("#trace end\n");
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+// Interrupts must be disabled
+static void _appendEvent(uint64_t cycles, TraceEventType type, _task_id taskId, uint32_t argument){
+	if(g_EventCount == TRACE_BUFFER_EVENT_COUNT){
+		g_DroppedCount++;
+		return;
+	}
+
+	TraceEventPtr event = &g_Events[g_EventCount++];
+	event->Cycles = cycles;
+	event->Type = type;
+	event->TaskId = taskId;
+	event->Argument = argument;
+}
+
+static bool _isJob(_task_id taskId){
+	for(uint32_t i = 0; i < g_EventCount; i++){
+		if(g_Events[i].TaskId == taskId && g_Events[i].Type == TRACE_EVENT_CREATE){
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_TASKTRACE_H_
+#define SOURCES_TASKTRACE_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define TRACE_BUFFER_EVENT_COUNT 1024		// Events after this many are dropped until the trace is restarted
+#define TRACE_NAMED_TASK_MAX 32				// The most non-job tasks named in a dump
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// The kinds of event recorded. The values are the letters used for them in a dump.
+typedef enum TraceEventType{
+	TRACE_EVENT_SWITCH = 'S',		// The dispatcher resumed the task
+	TRACE_EVENT_CREATE = 'C',		// The scheduler admitted the job. The argument is its template index.
+	TRACE_EVENT_DEADLINE = 'D',		// The job's relative deadline, in microseconds
+	TRACE_EVENT_PRIORITY = 'P',		// The scheduler changed the task's MQX priority to the argument
+	TRACE_EVENT_EXPIRE = 'E',		// The job missed its deadline and was destroyed
+	TRACE_EVENT_FINISH = 'F'		// The job was deleted before its deadline
+} TraceEventType;
+
+// Defines one recorded event
+typedef struct TraceEvent{
+	uint64_t Cycles;				// The CPU accounting cycle clock when the event happened
+	_task_id TaskId;
+	uint32_t Argument;
+	uint8_t Type;
+} TraceEvent, * TraceEventPtr;
+
+/*=============================================================
+                       TRACE INTERFACE
+ ==============================================================*/
+
+void tr_initializeTrace();
+void tr_startTrace();
+void tr_stopTrace();
+void tr_traceEvent(TraceEventType type, _task_id taskId, uint32_t argument);
+void tr_traceContextSwitch(_task_id taskId, uint64_t cycles);
+void tr_dumpTrace();
+
+#endif
@@ -0,0 +1,233 @@
+#include "workload.h"
+#include "../Accounting/cycleClock.h"
+#include <string.h>
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+// Demand is drawn in integer arithmetic only: jobs are not created as floating point tasks, so the FPU
+// registers are not saved when they are preempted. Fractions are fixed point with 24 bits after the point.
+#define FRACTION_BITS 24
+#define FRACTION_ONE ((uint32_t) 1 << FRACTION_BITS)
+#define LOG2_TABLE_BITS 5						// log2 is interpolated between 2^LOG2_TABLE_BITS + 1 table entries
+#define LN2_Q16 45426							// ln(2) with 16 bits after the point
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _runComputeKernel(uint32_t iterations);
+static void _runStreamKernel(uint32_t words);
+static uint32_t _calibrateKernel(void (*kernel)(uint32_t), uint32_t units);
+static uint32_t _drawDemand(const WorkloadSpec* spec, uint32_t meanMicroseconds, uint32_t sequence);
+static uint32_t _nextRandom(uint32_t* state);
+static uint32_t _nextFraction(uint32_t* state);
+static uint32_t _getLog2Q16(uint32_t value);
+
+/*=============================================================
+                          GLOBALS
+ ==============================================================*/
+
+static const WorkloadSpec* g_Specs;
+static uint32_t g_SpecCount = 0;
+static uint32_t g_Sequences[WORKLOAD_TEMPLATE_MAX];		// The next draw in each template's sequence, taken with interrupts disabled
+
+// Kernel speeds found by calibration, in units per millisecond
+static uint32_t g_ComputeIterationsPerMs = 0;
+static uint32_t g_StreamWordsPerMs = 0;
+
+// Shared by every memory-bound job. The data is meaningless, so jobs interleaving their passes does not matter.
+static volatile uint32_t g_StreamBuffer[WORKLOAD_STREAM_BUFFER_WORDS];
+static volatile uint32_t g_ComputeSink;				// Keeps the compute kernel's result, so the loop is not optimized away
+
+// log2(1 + i / 32) with 16 bits after the point
+static const uint32_t LOG2_TABLE_Q16[(1 << LOG2_TABLE_BITS) + 1] = {
+	0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+	38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047,
+	65536
+};
+
+/*=============================================================
+                      INITIALIZATION
+ ==============================================================*/
+
+// Calibrates the kernels and takes each template's workload, indexed like the registered templates. Must run
+// before any job, from a task that is not preempted by jobs, once CPU accounting has started the cycle clock.
+void wl_initializeWorkloads(const WorkloadSpec specs[], uint32_t specCount){
+	g_Specs = specs;
+	g_SpecCount = (specCount < WORKLOAD_TEMPLATE_MAX) ? specCount : WORKLOAD_TEMPLATE_MAX;
+	memset(g_Sequences, 0, sizeof(g_Sequences));
+
+	g_ComputeIterationsPerMs = _calibrateKernel(_runComputeKernel, WORKLOAD_CALIBRATION_ITERATIONS);
+	g_StreamWordsPerMs = _calibrateKernel(_runStreamKernel, WORKLOAD_CALIBRATION_PASSES * WORKLOAD_STREAM_BUFFER_WORDS);
+	printf("[Workload] Calibrated %u compute iterations and %u streamed words per ms.\n",
+			g_ComputeIterationsPerMs, g_StreamWordsPerMs);
+}
+
+/*=============================================================
+                       WORKLOAD INTERFACE
+ ==============================================================*/
+
+// Runs one job's work for the given template and returns the CPU demand drawn for it, in microseconds.
+// Jobs from the same template draw from its sequence in the order they start, so a run that releases the
+// same jobs in the same order sees the same demands.
+uint32_t wl_runTemplateWorkload(int32_t templateIndex, uint32_t creationParameter){
+	const WorkloadSpec* spec = (templateIndex >= 0 && templateIndex < (int32_t) g_SpecCount) ? &g_Specs[templateIndex] : NULL;
+	uint32_t meanMicroseconds = (spec != NULL && spec->MeanMicroseconds != 0) ? spec->MeanMicroseconds
+			: creationParameter * (1000000 / _time_get_ticks_per_sec());
+	if(spec == NULL){
+		wl_burnMicroseconds(meanMicroseconds);
+		return meanMicroseconds;
+	}
+
+	_int_disable();
+	uint32_t sequence = g_Sequences[templateIndex]++;
+	_int_enable();
+	uint32_t demand = _drawDemand(spec, meanMicroseconds, sequence);
+
+	switch(spec->Kind){
+		case WORKLOAD_MEMORY:
+			wl_streamMicroseconds(demand);
+			break;
+		case WORKLOAD_MIXED:{
+			// The first burst takes the remainder, so the bursts add up to the demand
+			uint32_t burst = demand / (spec->IoWaitCount + 1);
+			wl_burnMicroseconds(demand - burst * spec->IoWaitCount);
+			for(uint32_t i = 0; i < spec->IoWaitCount; i++){
+				_time_delay(spec->IoWaitMilliseconds);
+				wl_burnMicroseconds(burst);
+			}
+			break;
+		}
+		default:
+			wl_burnMicroseconds(demand);
+			break;
+	}
+	return demand;
+}
+
+// Runs the compute kernel for the given CPU time. Time spent preempted does not count towards it.
+void wl_burnMicroseconds(uint32_t microseconds){
+	_runComputeKernel((uint32_t)(((uint64_t) microseconds * g_ComputeIterationsPerMs) / 1000));
+}
+
+// Runs the memory streaming kernel for the given CPU time. Time spent preempted does not count towards it.
+void wl_streamMicroseconds(uint32_t microseconds){
+	_runStreamKernel((uint32_t)(((uint64_t) microseconds * g_StreamWordsPerMs) / 1000));
+}
+
+/*=============================================================
+                          KERNELS
+ ==============================================================*/
+
+static void _runComputeKernel(uint32_t iterations){
+	uint32_t x = 0x2545F491;
+	for(uint32_t i = 0; i < iterations; i++){
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		x += i;
+	}
+	g_ComputeSink = x;
+}
+
+static void _runStreamKernel(uint32_t words){
+	uint32_t index = 0;
+	for(uint32_t i = 0; i < words; i++){
+		g_StreamBuffer[index] = g_StreamBuffer[index] * 3 + 1;
+		index = (index + 1 == WORKLOAD_STREAM_BUFFER_WORDS) ? 0 : index + 1;
+	}
+}
+
+// Returns how many units of work the kernel does per millisecond
+static uint32_t _calibrateKernel(void (*kernel)(uint32_t), uint32_t units){
+	uint32_t fastestCycles = UINT32_MAX;
+	for(int i = 0; i < WORKLOAD_CALIBRATION_ROUNDS; i++){
+		uint32_t start = _readCycleClock();
+		kernel(units);
+		uint32_t elapsed = _readCycleClock() - start;
+		if(elapsed < fastestCycles){
+			fastestCycles = elapsed;
+		}
+	}
+
+	if(fastestCycles == 0){
+		fastestCycles = 1;
+	}
+	return (uint32_t)(((uint64_t) units * _getCycleClockHz()) / ((uint64_t) fastestCycles * 1000));
+}
+
+/*=============================================================
+                     DEMAND DISTRIBUTIONS
+ ==============================================================*/
+
+static uint32_t _drawDemand(const WorkloadSpec* spec, uint32_t meanMicroseconds, uint32_t sequence){
+	uint32_t state = spec->Seed + sequence * 0x9E3779B9;
+	if(state == 0){
+		state = 1;
+	}
+	_nextRandom(&state);
+
+	int64_t demand;
+	switch(spec->Distribution){
+		case WORKLOAD_UNIFORM:
+			demand = (int64_t) meanMicroseconds - spec->SpreadMicroseconds
+					+ _nextRandom(&state) % (2 * spec->SpreadMicroseconds + 1);
+			break;
+		case WORKLOAD_EXPONENTIAL:{
+			// -ln(u) = -log2(u) * ln(2), with -log2(u) = FRACTION_BITS - log2(u * 2^FRACTION_BITS)
+			uint32_t negativeLog2 = (FRACTION_BITS << 16) - _getLog2Q16(_nextFraction(&state));
+			demand = (int64_t)(((uint64_t) meanMicroseconds * negativeLog2 * LN2_Q16) >> 32);
+			break;
+		}
+		case WORKLOAD_NORMAL:{
+			// The sum of twelve uniform fractions, less six, has a mean of 0 and a standard deviation of 1
+			int64_t sum = -6 * (int64_t) FRACTION_ONE;
+			for(int i = 0; i < 12; i++){
+				sum += _nextFraction(&state);
+			}
+			demand = (int64_t) meanMicroseconds + sum * spec->SpreadMicroseconds / FRACTION_ONE;
+			break;
+		}
+		default:
+			demand = meanMicroseconds;
+			break;
+	}
+
+	if(demand < 0){
+		demand = 0;
+	}
+	if(spec->MaxMicroseconds != 0 && demand > spec->MaxMicroseconds){
+		demand = spec->MaxMicroseconds;
+	}
+	return (demand > UINT32_MAX) ? UINT32_MAX : (uint32_t) demand;
+}
+
+// The xorshift32 generator. The state must not be 0.
+static uint32_t _nextRandom(uint32_t* state){
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+// Returns a fraction in (0, 1], with FRACTION_BITS bits after the point
+static uint32_t _nextFraction(uint32_t* state){
+	return (_nextRandom(state) >> (32 - FRACTION_BITS)) + 1;
+}
+
+// Returns log2 of a non-zero value with 16 bits after the point. The integer part is the top set bit, and the
+// fraction is interpolated from the table on the bits below it, to within 0.0003.
+static uint32_t _getLog2Q16(uint32_t value){
+	uint32_t exponent = 31 - __builtin_clz(value);
+	uint32_t mantissa = (exponent >= 16) ? (value >> (exponent - 16)) : (value << (16 - exponent));	// [1, 2) with 16 bits after the point
+	uint32_t offset = mantissa & 0xFFFF;
+	uint32_t index = offset >> (16 - LOG2_TABLE_BITS);
+	uint32_t remainder = offset & ((1 << (16 - LOG2_TABLE_BITS)) - 1);
+	uint32_t low = LOG2_TABLE_Q16[index];
+	uint32_t high = LOG2_TABLE_Q16[index + 1];
+	return (exponent << 16) + low + (((high - low) * remainder) >> (16 - LOG2_TABLE_BITS));
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+
+#ifndef SOURCES_WORKLOAD_H_
+#define SOURCES_WORKLOAD_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define WORKLOAD_TEMPLATE_MAX 8					// Templates beyond this many run fixed compute work
+#define WORKLOAD_CALIBRATION_ROUNDS 5			// Calibration keeps the fastest round, the one least disturbed by interrupts
+#define WORKLOAD_CALIBRATION_ITERATIONS 20000	// Compute kernel iterations timed per round
+#define WORKLOAD_CALIBRATION_PASSES 4			// Passes over the streaming buffer timed per round
+#define WORKLOAD_STREAM_BUFFER_WORDS 1024		// The memory streaming kernel's working set, in 32-bit words
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+typedef enum WorkloadKind{
+	WORKLOAD_COMPUTE,			// Integer arithmetic in registers
+	WORKLOAD_MEMORY,			// Read-modify-write passes over a buffer in SRAM, loading the bus rather than the ALU
+	WORKLOAD_MIXED				// Compute split into bursts around _time_delay waits, like a task doing I/O
+} WorkloadKind;
+
+typedef enum WorkloadDistribution{
+	WORKLOAD_FIXED,				// Every job runs for the mean
+	WORKLOAD_UNIFORM,			// Uniform over the mean plus or minus the spread
+	WORKLOAD_EXPONENTIAL,		// Exponential with the given mean
+	WORKLOAD_NORMAL				// Approximately normal, with the spread as the standard deviation
+} WorkloadDistribution;
+
+// Defines the demand of the jobs created from one template. Demand is CPU time, so a job that is preempted
+// still does all of its work.
+typedef struct WorkloadSpec{
+	WorkloadKind Kind;
+	WorkloadDistribution Distribution;
+	uint32_t MeanMicroseconds;		// 0 takes the mean from the template's parameter, in ticks
+	uint32_t SpreadMicroseconds;
+	uint32_t MaxMicroseconds;		// Draws are clamped to this, or not at all if it is 0
+	uint32_t IoWaitCount;			// For mixed work, the number of waits the compute is split around
+	uint32_t IoWaitMilliseconds;	// For mixed work, the length of each wait
+	uint32_t Seed;					// Jobs from the template draw their demand from a sequence starting here
+} WorkloadSpec, * WorkloadSpecPtr;
+
+/*=============================================================
+                       WORKLOAD INTERFACE
+ ==============================================================*/
+
+void wl_initializeWorkloads(const WorkloadSpec specs[], uint32_t specCount);
+uint32_t wl_runTemplateWorkload(int32_t templateIndex, uint32_t creationParameter);
+void wl_burnMicroseconds(uint32_t microseconds);
+void wl_streamMicroseconds(uint32_t microseconds);
+
+#endif
@@ -0,0 +1,265 @@
+#include "binaryInterface.h"
+#include "Scheduler/scheduler.h"
+#include "TerminalDriver/handler.h"
+#include "SchedulerInterface.h"
+#include "schedulerInterface.h"
+
+/*=============================================================
+                      CONSTANTS
+ ==============================================================*/
+
+#define BINARY_INTERFACE_TASK_STACK_SIZE 2048
+#define BINARY_INTERFACE_TASK_PRIORITY PRIORITY_OSA_TO_RTOS(SCHEDULERINTERFACE_TASK_PRIORITY)
+
+#define CREATE_REQUEST_SIZE 6		// Template (1), flags (1), deadline (4)
+#define CREATE_ARGUMENT_SIZE 4		// Argument (4), following a create flagged FRAME_CREATE_FLAG_ARGUMENT
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+void runBinaryInterface(os_task_param_t task_init_data);
+
+// Frame handlers
+static void _handleCreateFrame(FramePtr request, FramePtr response);
+static void _handleDeleteFrame(FramePtr request, FramePtr response);
+static void _handleQueryFrame(FramePtr request, FramePtr response);
+static void _handleBatchFrame(FramePtr request, FramePtr response);
+
+// Helper functions
+static _task_id _createTaskFromRequest(const uint8_t* createRequest);
+static uint32_t _getCreateRequestSize(const uint8_t* createRequest);
+static void _beginResponse(FramePtr response, uint8_t status);
+static void _appendUint8(FramePtr response, uint8_t value);
+static void _appendUint32(FramePtr response, uint32_t value);
+static void _appendUint64(FramePtr response, uint64_t value);
+static uint64_t _getMicroseconds(MQX_TICK_STRUCT_PTR ticks);
+static uint32_t _readUint32(const uint8_t* bytes);
+
+/*=============================================================
+                      BINARY INTERFACE TASK
+ ==============================================================*/
+
+void runBinaryInterface(os_task_param_t task_init_data){
+	printf("[Binary Interface] Task started.\n");
+
+	// Open a queue and register it with the serial handler for every frame it decodes
+	_queue_id frameQueue = _msgq_open((_queue_number) task_init_data, 0);
+	if(frameQueue == MSGQ_NULL_QUEUE_ID){
+		printf("[Binary Interface] Failed to open queue %u.\n", (uint32_t) task_init_data);
+		_task_block();
+	}
+	if(!OpenFrameReader(frameQueue)){
+		printf("[Binary Interface] Unable to register for frames with the serial handler.\n");
+		_task_block();
+	}
+
+	Frame request;
+	Frame response;
+	while(1){
+		GetFrame(&request);
+		bi_handleFrame(&request, &response);
+		PutFrame(&response);
+	}
+}
+
+/*=============================================================
+                      PUBLIC INTERFACE
+ ==============================================================*/
+
+// Starts the task serving binary frames, which it receives on the given queue number
+void bi_startBinaryInterface(uint32_t frameQueueNumber){
+	TASK_TEMPLATE_STRUCT binaryInterfaceTemplate = { 0, runBinaryInterface, BINARY_INTERFACE_TASK_STACK_SIZE,
+			BINARY_INTERFACE_TASK_PRIORITY, "Binary Interface", 0, frameQueueNumber, 0};
+	if(_task_create(0, 0, (uint32_t) &binaryInterfaceTemplate) == MQX_NULL_TASK_ID){
+		printf("[Scheduler Interface] Unable to create the binary interface task.\n");
+		_task_block();
+	}
+}
+
+// Serves one request frame and fills in its response. Every response echoes the request ID, sets the
+// response flag in the opcode and starts with a status byte and the time at which it was served.
+bool bi_handleFrame(FramePtr request, FramePtr response){
+	response->requestId = request->requestId;
+	response->opcode = request->opcode | FRAME_RESPONSE_FLAG;
+	response->length = 0;
+
+	switch(request->opcode){
+		case FRAME_OPCODE_CREATE:
+			_handleCreateFrame(request, response);
+			return true;
+		case FRAME_OPCODE_DELETE:
+			_handleDeleteFrame(request, response);
+			return true;
+		case FRAME_OPCODE_QUERY:
+			_handleQueryFrame(request, response);
+			return true;
+		case FRAME_OPCODE_BATCH:
+			_handleBatchFrame(request, response);
+			return true;
+		default:
+			_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+			return false;
+	}
+}
+
+/*=============================================================
+                       FRAME HANDLERS
+ ==============================================================*/
+
+// Response: status, timestamp, task ID
+static void _handleCreateFrame(FramePtr request, FramePtr response){
+	if(request->length < CREATE_REQUEST_SIZE || request->length != _getCreateRequestSize(request->payload)){
+		_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+		return;
+	}
+
+	_task_id taskId = _createTaskFromRequest(request->payload);
+	_beginResponse(response, (taskId == MQX_NULL_TASK_ID) ? FRAME_STATUS_FAILED : FRAME_STATUS_OK);
+	_appendUint32(response, taskId);
+}
+
+// Response: status, timestamp
+static void _handleDeleteFrame(FramePtr request, FramePtr response){
+	if(request->length != 4){
+		_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+		return;
+	}
+
+	bool result = dd_delete(_readUint32(request->payload));
+	_beginResponse(response, result ? FRAME_STATUS_OK : FRAME_STATUS_FAILED);
+}
+
+// Response: status, timestamp, count, then count entries of task ID, deadline and creation time
+static void _handleQueryFrame(FramePtr request, FramePtr response){
+	if(request->length != 1){
+		_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+		return;
+	}
+
+	TaskList taskList = NULL;
+	bool result;
+	switch(request->payload[0]){
+		case FRAME_QUERY_ACTIVE:
+			result = dd_return_active_list(&taskList);
+			break;
+		case FRAME_QUERY_OVERDUE:
+			result = dd_return_overdue_list(&taskList);
+			break;
+		default:
+			_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+			return;
+	}
+
+	_beginResponse(response, result ? FRAME_STATUS_OK : FRAME_STATUS_FAILED);
+	int countIndex = response->length;
+	_appendUint8(response, 0);
+
+	// Write as many entries as fit in one frame
+	for(TaskListNodePtr currentNode = taskList; currentNode != NULL; currentNode = currentNode->nextNode){
+		if(response->length + FRAME_TASK_ENTRY_SIZE > FRAME_MAX_PAYLOAD){
+			response->payload[0] = FRAME_STATUS_TRUNCATED;
+			break;
+		}
+		_appendUint32(response, currentNode->task->TaskId);
+		_appendUint64(response, _getMicroseconds(&currentNode->task->Deadline));
+		_appendUint64(response, _getMicroseconds(&currentNode->task->CreatedAt));
+		response->payload[countIndex]++;
+	}
+	_freeTaskList(taskList);
+}
+
+// Response: status, timestamp, count, then one task ID per requested creation (0 where creation failed)
+static void _handleBatchFrame(FramePtr request, FramePtr response){
+	if(request->length < 1){
+		_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+		return;
+	}
+	uint8_t count = request->payload[0];
+
+	// Creates with an argument are longer, so walk them to check that exactly count of them fill the payload
+	uint32_t size = 1;
+	int sizedCount = 0;
+	while(sizedCount < count && size + CREATE_REQUEST_SIZE <= request->length){
+		size += _getCreateRequestSize(&request->payload[size]);
+		sizedCount++;
+	}
+	if(sizedCount != count || size != request->length){
+		_beginResponse(response, FRAME_STATUS_BAD_REQUEST);
+		return;
+	}
+
+	_beginResponse(response, FRAME_STATUS_OK);
+	_appendUint8(response, count);
+	for(uint32_t i=0, offset=1; i<count; i++){
+		_task_id taskId = _createTaskFromRequest(&request->payload[offset]);
+		offset += _getCreateRequestSize(&request->payload[offset]);
+		if(taskId == MQX_NULL_TASK_ID){
+			response->payload[0] = FRAME_STATUS_FAILED;
+		}
+		_appendUint32(response, taskId);
+	}
+}
+
+/*=============================================================
+                       HELPER FUNCTIONS
+ ==============================================================*/
+
+static _task_id _createTaskFromRequest(const uint8_t* createRequest){
+	uint32_t templateIndex = createRequest[0];
+	uint8_t flags = createRequest[1];
+	uint32_t deadline = _readUint32(&createRequest[2]);
+
+	if(flags & FRAME_CREATE_FLAG_ARGUMENT){
+		uint32_t argument = _readUint32(&createRequest[CREATE_REQUEST_SIZE]);
+		return (flags & FRAME_CREATE_FLAG_MICROSECONDS) ?
+				dd_tcreate_us_arg(templateIndex, deadline, argument) :
+				dd_tcreate_arg(templateIndex, deadline, argument);
+	}
+	return (flags & FRAME_CREATE_FLAG_MICROSECONDS) ?
+			dd_tcreate_us(templateIndex, deadline) :
+			dd_tcreate(templateIndex, deadline);
+}
+
+static uint32_t _getCreateRequestSize(const uint8_t* createRequest){
+	return (createRequest[1] & FRAME_CREATE_FLAG_ARGUMENT) ? CREATE_REQUEST_SIZE + CREATE_ARGUMENT_SIZE : CREATE_REQUEST_SIZE;
+}
+
+static void _beginResponse(FramePtr response, uint8_t status){
+	MQX_TICK_STRUCT now;
+	_time_get_ticks(&now);
+
+	response->length = 0;
+	_appendUint8(response, status);
+	_appendUint64(response, _getMicroseconds(&now));
+}
+
+static void _appendUint8(FramePtr response, uint8_t value){
+	response->payload[response->length++] = value;
+}
+
+static void _appendUint32(FramePtr response, uint32_t value){
+	for(int i=0; i<4; i++){
+		response->payload[response->length++] = (value >> (8 * i)) & 0xFF;
+	}
+}
+
+static void _appendUint64(FramePtr response, uint64_t value){
+	_appendUint32(response, (uint32_t) value);
+	_appendUint32(response, (uint32_t)(value >> 32));
+}
+
+// Keeps both tick words and the time into the tick, so timestamps neither wrap nor lose sub-tick deadlines
+static uint64_t _getMicroseconds(MQX_TICK_STRUCT_PTR ticks){
+	MQX_TICK_STRUCT tickStart = *ticks;
+	tickStart.HW_TICKS = 0;
+	bool overflow;
+	int32_t microsecondsIntoTick = _time_diff_microseconds(ticks, &tickStart, &overflow);
+
+	uint64_t wholeTicks = ((uint64_t) ticks->TICKS[1] << 32) | ticks->TICKS[0];
+	return wholeTicks * (1000000 / _time_get_ticks_per_sec()) + microsecondsIntoTick;
+}
+
+static uint32_t _readUint32(const uint8_t* bytes){
+	return bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <mqx.h>
+#include <string.h>
+
+#include "TerminalDriver/frame.h"
+
+#ifndef _BINARY_INTERFACEH_
+#define _BINARY_INTERFACEH_
+
+/*=============================================================
+                      BINARY INTERFACE
+ ==============================================================*/
+
+void bi_startBinaryInterface(uint32_t frameQueueNumber);
+bool bi_handleFrame(FramePtr request, FramePtr response);
+
+#endif
@@ -12,10 +12,17 @@ extern "C" {
                         GLOBAL VARIABLES
  ==============================================================*/
 
-_pool_id g_InterruptMessagePool;	// A message pool for messages sent between from the UART event handler to the handler task
 _pool_id g_SerialMessagePool;		// A message pool for messages sent between the handler task and its user tasks
-HandlerPtr g_Handler;				// The global handler instance
-MUTEX_STRUCT g_HandlerMutex;		// The mutex controlling access to the handler's internal state
+_pool_id g_FrameMessagePool;		// A message pool for decoded frames sent from the handler task to the frame reader
+HandlerPtr g_Handler;				// The control terminal's handler, which serves the scheduler interface
+HandlerPtr g_Handlers[HANDLER_INSTANCE_MAX];	// Every handler instance, one per terminal UART
+uint32_t g_HandlerCount;			// The number of handler instances in g_Handlers
+
+// Terminals served by the serial handler, one per UART. The first is the control terminal. To add a terminal,
+// add a UART component for it and list its driver instance and a free input queue number here.
+const HandlerConfig HANDLER_CONFIGS[] = {
+	{ myUART_IDX, HANDLER_INPUT_QUEUE_ID },
+};
 
 /*=============================================================
                      USER TASK DEFINITIONS
@@ -23,11 +30,27 @@ MUTEX_STRUCT g_HandlerMutex;		// The mutex controlling access to the handler's i
 
 #define USER_TASK_STACK_SIZE 700
 
-const uint32_t USER_TASK_COUNT = 3;
-const TASK_TEMPLATE_STRUCT USER_TASKS[] = {
-		{ 0, runUserTask, USER_TASK_STACK_SIZE, DEFAULT_TASK_PRIORITY, "Short Task", 0, 10, 0},
-		{ 0, runUserTask, USER_TASK_STACK_SIZE, DEFAULT_TASK_PRIORITY, "Medium Task", 0, 2000, 0},
-		{ 0, runUserTask, USER_TASK_STACK_SIZE, DEFAULT_TASK_PRIORITY, "Long Task", 0, 5000, 0}
+// Registered by the scheduler at startup, so their template indices match their positions here. Further
+// templates can be registered at run time with dd_register_template.
+// Name, entry point, stack size, parameter, WCET (us), default deadline (ticks), default period (ticks), miss policy
+const uint32_t USER_TASK_COUNT = 6;
+const TaskTemplateInfo USER_TASKS[] = {
+		{ "Short Task", runUserTask, USER_TASK_STACK_SIZE, 10, 50000, 20, 0, MISS_POLICY_ABORT },
+		{ "Medium Task", runUserTask, USER_TASK_STACK_SIZE, 2000, 10000000, 4000, 0, MISS_POLICY_ABORT },
+		{ "Long Task", runUserTask, USER_TASK_STACK_SIZE, 5000, 25000000, 10000, 0, MISS_POLICY_ABORT },
+		{ "Compute Bench", runUserTask, USER_TASK_STACK_SIZE, 0, 6000, 4, 10, MISS_POLICY_ABORT },
+		{ "Memory Bench", runUserTask, USER_TASK_STACK_SIZE, 0, 10000, 4, 20, MISS_POLICY_ABORT },
+		{ "IO Bench", runUserTask, USER_TASK_STACK_SIZE, 0, 12000, 10, 40, MISS_POLICY_DEMOTE }
+};
+
+// Indexed like USER_TASKS. A mean of 0 runs for the template's parameter, in ticks.
+const WorkloadSpec USER_WORKLOADS[] = {
+		{ WORKLOAD_COMPUTE, WORKLOAD_FIXED, 0, 0, 0, 0, 0, 0 },
+		{ WORKLOAD_COMPUTE, WORKLOAD_FIXED, 0, 0, 0, 0, 0, 0 },
+		{ WORKLOAD_COMPUTE, WORKLOAD_FIXED, 0, 0, 0, 0, 0, 0 },
+		{ WORKLOAD_COMPUTE, WORKLOAD_UNIFORM, 4000, 2000, 0, 0, 0, 0x1F2E3D4C },
+		{ WORKLOAD_MEMORY, WORKLOAD_FIXED, 10000, 0, 0, 0, 0, 0 },
+		{ WORKLOAD_MIXED, WORKLOAD_NORMAL, 6000, 1500, 12000, 3, 5, 0x5A5A1234 }
 };
 
 /*=============================================================
@@ -51,21 +74,35 @@ void runScheduler(os_task_param_t task_init_data)
 {
 	printf("[Scheduler] Task started.\n");
 
+	for(uint32_t i = 0; i < USER_TASK_COUNT; i++){
+		if(dd_register_template(&USER_TASKS[i]) < 0){
+			printf("[Scheduler] Unable to register the %s template.\n", USER_TASKS[i].Name);
+			_task_block();
+		}
+	}
+
+	// Charge CPU time to tasks from the first context switch on
+	ca_initializeCpuAccounting(_task_get_id());
+	tr_initializeTrace();
+	sm_initializeStackMonitor();
+	wl_initializeWorkloads(USER_WORKLOADS, USER_TASK_COUNT);
+
 	_queue_id requestQueue = _initializeQueue(SCHEDULER_INTERFACE_QUEUE_ID);
-	_initializeScheduler(requestQueue, USER_TASKS, USER_TASK_COUNT);
+	_initializeScheduler(requestQueue);
 
-	MQX_TICK_STRUCT nextDeadline;
+	MQX_TICK_STRUCT deadlineBackstop;
 	SchedulerRequestMessagePtr requestMessage;
 
 #ifdef PEX_USE_RTOS
   while (1) {
 #endif
 	  requestMessage = NULL;
-	  bool deadlineExists = _getNextDeadline(&nextDeadline);
+	  bool deadlineExists = _getDeadlineBackstop(&deadlineBackstop);
 
-	  // If the scheduler currently has tasks, wait for a new message or the next deadline
+	  // Deadlines are enforced by the deadline timer, which posts a DEADLINE_EXPIRED request. If the scheduler
+	  // currently has tasks, also wake shortly after the next deadline in case that notification was lost.
 	  if(deadlineExists){
-		  requestMessage = _msgq_receive_until(requestQueue, &nextDeadline);
+		  requestMessage = _msgq_receive_until(requestQueue, &deadlineBackstop);
 
 		  // Handle reached deadlines
 		  if(requestMessage == NULL){
@@ -92,16 +129,6 @@ void runScheduler(os_task_param_t task_init_data)
  ==============================================================*/
 
 void _initializeHandlerMessagePools(){
-	// Initialize interrupt message pool
-	g_InterruptMessagePool = _msgpool_create(sizeof(InterruptMessage),
-			INTERRUPT_MESSAGE_POOL_INITIAL_SIZE,
-			INTERRUPT_MESSAGE_POOL_GROWTH_RATE,
-			INTERRUPT_MESSAGE_POOL_MAX_SIZE);
-	if(g_InterruptMessagePool == MSGPOOL_NULL_POOL_ID){
-		printf("Failed to create the interrupt message pool.\n");
-		_task_block();
-	}
-
 	// Initialize serial message pool
 	g_SerialMessagePool = _msgpool_create(sizeof(SerialMessage),
 			SERIAL_MESSAGE_POOL_INITIAL_SIZE,
@@ -111,57 +138,106 @@ void _initializeHandlerMessagePools(){
 		printf("Failed to create the serial message pool.\n");
 		_task_block();
 	}
+
+	// Initialize frame message pool
+	g_FrameMessagePool = _msgpool_create(sizeof(FrameMessage),
+			FRAME_MESSAGE_POOL_INITIAL_SIZE,
+			FRAME_MESSAGE_POOL_GROWTH_RATE,
+			FRAME_MESSAGE_POOL_MAX_SIZE);
+	if(g_FrameMessagePool == MSGPOOL_NULL_POOL_ID){
+		printf("Failed to create the frame message pool.\n");
+		_task_block();
+	}
 }
 
-void runSerialHandler(os_task_param_t task_init_data)
-{
-	printf("[Serial Handler] Task started.\n");
+// Prepares a handler for its UART and attaches it to the UART's interrupts. Its input queue is opened later
+// by the task that serves it, but the queue's ID is fixed by its number.
+void _initializeHandlerInstance(HandlerPtr handler, const HandlerConfig* config){
+	uint32_t uart = config->UartInstance;
+	_initializeHandler(handler, _msgq_get_id(0, config->InputQueueNumber), uart);
 
-		// Initialize queues and message pools
-		_queue_id interruptQueue = _initializeQueue(HANDLER_INTERRUPT_QUEUE_ID);
-		_queue_id inputQueue = _initializeQueue(HANDLER_INPUT_QUEUE_ID);
-		_initializeHandlerMessagePools();
-
-		// Initialize Handler
-		Handler handler;
-		g_Handler = &handler;
-		_initializeHandlerMutex(&g_HandlerMutex);
-		_initializeHandler(g_Handler, interruptQueue, inputQueue, myUART_IDX);
-
-	#ifdef PEX_USE_RTOS
-	  while (1) {
-	#endif
-
-	    // Wait for any incoming messages
-		GenericMessagePtr receivedMessage = (GenericMessagePtr) _msgq_receive(MSGQ_ANY_QUEUE, 0);
-		if (receivedMessage == NULL){
-			   printf("[Serial Handler] Failed to receive a message.\n");
-			   _task_block();
-		}
+	// Drain terminal output from the UART transmit interrupt
+	UART_DRV_InstallTxCallback(uart, myUART_TxCallback, handler->txRing.characters, &handler->txRing);
+
+	// Start filling the receive ring from the UART receive interrupt
+	UART_DRV_InstallRxCallback(uart, myUART_RxCallback, &handler->rxCharacter, handler, true);
+}
 
-		// Lock access to the handler while it processses the message
-		if(_mutex_lock(&g_HandlerMutex) != MQX_OK){
-			printf("[Serial Handler] Mutex lock failed.\n");
+// Serves one handler forever. Each handler has its own task, mutex and queue, so terminals never wait on each other.
+void _serveHandlerInstance(HandlerPtr handler, uint32_t inputQueueNumber){
+	_queue_id inputQueue = _initializeQueue(inputQueueNumber);
+
+	while (1) {
+	    // Wait until characters arrive or a writer queues output. A partly received frame bounds the wait, so
+		// it can be abandoned if the rest never arrives.
+		_mqx_uint timeout = _expireIdleFrame(handler);
+		_mqx_uint waitResult = _lwevent_wait_ticks(&handler->events, HANDLER_EVENT_RX_READY | HANDLER_EVENT_WRITE_READY, FALSE, timeout);
+		if(waitResult == LWEVENT_WAIT_TIMEOUT){
+			continue;
+		}
+		if(waitResult != MQX_OK){
+			printf("[Serial Handler] Failed to wait for handler events.\n");
 			_task_block();
 		}
 
-		// If the message is an serial message from the current writer, handle the writer input
-		if(receivedMessage->HEADER.TARGET_QID == inputQueue){
-			_handleWriteMessage((SerialMessagePtr) receivedMessage, g_Handler);
-		}
-		// If the message is an interrupt message from the UART event handler, handle the character press
-		else if (receivedMessage->HEADER.TARGET_QID == interruptQueue){
-			_handleInterruptMessage((InterruptMessagePtr) receivedMessage, g_Handler);
+		// Only the transmit ring is shared while the input is processed; readers and writers never take this mutex
+		_lockHandlerOutput(handler);
+
+		// Handle every character received since the last wakeup
+		_handleReceivedCharacters(handler);
+
+		// Handle every serial message queued by the current writer
+		SerialMessagePtr serialMessage;
+		while((serialMessage = (SerialMessagePtr) _msgq_poll(inputQueue)) != NULL){
+			_handleWriteMessage(serialMessage, handler);
+			free(serialMessage->content);
+			_msg_free(serialMessage);
 		}
 
-		_msg_free(receivedMessage);
+		// Release the transmit ring to the log drain and frame responses
+		_unlockHandlerOutput(handler);
+	}
+}
 
-		// Unlock the handler for user access
-		_mutex_unlock(&g_HandlerMutex);
+// Entry point of the tasks serving every handler after the control terminal's
+void runHandlerInstance(os_task_param_t handlerIndex){
+	_serveHandlerInstance(g_Handlers[handlerIndex], HANDLER_CONFIGS[handlerIndex].InputQueueNumber);
+}
 
-	#ifdef PEX_USE_RTOS
-	  }
-	#endif
+void runSerialHandler(os_task_param_t task_init_data)
+{
+	printf("[Serial Handler] Task started.\n");
+
+	_initializeHandlerMessagePools();
+
+	// Initialize every handler. Their state is too large for this task's stack.
+	static Handler handlers[HANDLER_INSTANCE_MAX];
+	uint32_t handlerCount = sizeof(HANDLER_CONFIGS) / sizeof(HandlerConfig);
+	if(handlerCount > HANDLER_INSTANCE_MAX){
+		printf("[Serial Handler] Too many terminals configured.\n");
+		_task_block();
+	}
+	for(uint32_t i=0; i<handlerCount; i++){
+		_initializeHandlerInstance(&handlers[i], &HANDLER_CONFIGS[i]);
+		g_Handlers[i] = &handlers[i];
+	}
+	g_HandlerCount = handlerCount;
+	g_Handler = g_Handlers[0];
+
+	// Serve every other terminal from its own task at this task's priority
+	for(uint32_t i=1; i<handlerCount; i++){
+		TASK_TEMPLATE_STRUCT handlerTemplate = { 0, runHandlerInstance, SERIALHANDLER_TASK_STACK_SIZE,
+				PRIORITY_OSA_TO_RTOS(SERIALHANDLER_TASK_PRIORITY), "Serial Handler", 0, i, 0};
+		if(_task_create(0, 0, (uint32_t) &handlerTemplate) == MQX_NULL_TASK_ID){
+			printf("[Serial Handler] Unable to create a handler task.\n");
+			_task_block();
+		}
+	}
+
+	// Start draining log records to their terminal
+	_initializeLogSink(g_Handlers[LOG_HANDLER_INDEX < handlerCount ? LOG_HANDLER_INDEX : 0]);
+
+	_serveHandlerInstance(g_Handler, HANDLER_CONFIGS[0].InputQueueNumber);
 }
 
 /*=============================================================
@@ -188,6 +264,13 @@ void runSchedulerInterface(os_task_param_t task_init_data)
 		_task_block();
 	}
 
+	// Periodic streams are started by text create commands; the binary interface only creates single jobs.
+	// Phase spreading estimates each stream's demand from its template's WCET.
+	sr_initializeStreamRegistry();
+
+	// Serve framed binary requests alongside text commands
+	bi_startBinaryInterface(BINARY_INTERFACE_QUEUE_ID);
+
 #ifdef PEX_USE_RTOS
   while (1) {
 #endif
@@ -214,29 +297,10 @@ void runSchedulerInterface(os_task_param_t task_init_data)
                           USER TASKS
  ==============================================================*/
 
-void doBusyWorkForTicks(uint32_t numTicks){
-	MQX_TICK_STRUCT currentTime;
-	 _time_get_ticks(&currentTime);
-
-	 uint32_t ticksRun = 0;
-	 uint32_t currentTicks = currentTime.TICKS[0];
-	 uint32_t previousTicks = currentTime.TICKS[0];
-
-	do{
-		_time_get_ticks(&currentTime);
-		currentTicks = currentTime.TICKS[0];
-		if(currentTicks > previousTicks){
-			ticksRun++; // The ticks run is only updated if the system clock ticks have increased
-			previousTicks = currentTicks;
-		}
-	}
-	while(ticksRun < numTicks);
-}
-
 void runUserTask(uint32_t numTicks){
-	printf("[User] Doing busy work for %u ticks.\n", numTicks);
-	doBusyWorkForTicks(numTicks);
-	printf("[User] Task complete.\n");
+	Log("[User] Task started.\n");
+	uint32_t demand = wl_runTemplateWorkload(ca_getTaskTemplateIndex(_task_get_id()), numTicks);
+	Log("[User] Task complete after %u us of work.\n", demand);
 	dd_delete(_task_get_id());
 }
 
@@ -244,53 +308,56 @@ void runUserTask(uint32_t numTicks){
                     STATUS UPDATE TASK
  ==============================================================*/
 
-#define FRDM_K64F_CLOCK_RATE 120e6 // 120 MHz
-#define CLOCK_CYCLES_PER_IDLE_TASK_INCREMENT 14 // Rough approximation - tuned manually
-#define MS_PER_SEC 1000
-
-// Returns the current value of the counter inside the MQX idle task
-uint64_t _getIdleCount(){
-    volatile KERNEL_DATA_STRUCT_PTR kernel_data;
-    _GET_KERNEL_DATA(kernel_data);
-    uint64_t idleCount = kernel_data->IDLE_LOOP.IDLE_LOOP2;
-    idleCount = idleCount << 32;
-    idleCount += kernel_data->IDLE_LOOP.IDLE_LOOP1;
-    return idleCount;
+// Returns the share of the report's total time, in tenths of a percent
+uint32_t _getPermille(uint64_t cycles, uint64_t totalCycles){
+	return (totalCycles == 0) ? 0 : (uint32_t)((cycles * 1000) / totalCycles);
 }
 
-// Converts a value in MQX idle task counter units into milliseconds
-uint32_t _getIdleMilliseconds(uint64_t idleCount){
-	static uint32_t cyclesPerMs = FRDM_K64F_CLOCK_RATE / MS_PER_SEC;
-	uint64_t elapsedCycles = idleCount * CLOCK_CYCLES_PER_IDLE_TASK_INCREMENT;
-	return elapsedCycles / cyclesPerMs;
+void _printCpuUsageReport(CpuUsageReportPtr report){
+	uint32_t busyPermille = 1000 - _getPermille(report->IdleCycles, report->TotalCycles);
+	uint32_t isrPermille = _getPermille(report->IsrCycles, report->TotalCycles);
+	uint32_t schedulerPermille = _getPermille(report->SchedulerCycles, report->TotalCycles);
+	printf("[Status Update] CPU utilization: %u.%u %%, interrupts: %u.%u %%, scheduler: %u.%u %%\n",
+			busyPermille / 10, busyPermille % 10, isrPermille / 10, isrPermille % 10, schedulerPermille / 10, schedulerPermille % 10);
+
+	printf(" %-10s %-16s %7s %12s\n", "Task ID", "Name", "CPU %", "Time (us)");
+	for(uint32_t i = 0; i < report->TaskCount; i++){
+		CpuTaskUsagePtr usage = &report->Tasks[i];
+		uint32_t permille = _getPermille(usage->Cycles, report->TotalCycles);
+		uint32_t microseconds = (uint32_t)((usage->Cycles * 1000000) / _getCycleClockHz());
+		printf(" 0x%-8x %-16s %5u.%u %12u\n", usage->TaskId, (usage->Name == NULL) ? "-" : usage->Name,
+				permille / 10, permille % 10, microseconds);
+	}
+
+	uint32_t templateCount = dd_get_template_count();
+	for(uint32_t i = 0; i < templateCount && i < CPU_ACCOUNTING_TEMPLATE_MAX; i++){
+		uint32_t permille = _getPermille(report->TemplateCycles[i], report->TotalCycles);
+		printf(" Template %u (%s): %u.%u %%\n", i, dd_get_template_info(i)->Name, permille / 10, permille % 10);
+	}
+	if(report->UntrackedCycles != 0){
+		uint32_t permille = _getPermille(report->UntrackedCycles, report->TotalCycles);
+		printf(" Untracked tasks: %u.%u %%\n", permille / 10, permille % 10);
+	}
 }
 
 void runStatusUpdate(os_task_param_t task_init_data)
 {
 	printf("[Status Update] Task started.\n");
 
-	uint64_t currentIdleCount;						// The current value of the idle task's counter
-	uint64_t previousIdleCount = _getIdleCount();	// The value of the idle task counter at the start of the previous update
-	uint32_t idleCountDuringPeriod;					// The number of times the idle task counter was incrmeneted during this period
-	uint32_t inactiveMilliseconds;					// The number of milliseconds the CPU was inactive for during this period
-	uint32_t activeMilliseconds;					// The number of milliseconds the CPU was active for during this period
-	uint32_t cpuUtilization;						// The CPU utilization during this period
+	CpuUsageReportPtr report;
+	if(!(report = (CpuUsageReportPtr) malloc(sizeof(CpuUsageReport)))){
+		printf("[Status Update] Unable to allocate memory for the CPU usage report.\n");
+		_task_block();
+	}
+
+	// Discard the time used before the first period
+	ca_collectCpuUsage(report);
 
 	while(1){
 		_time_delay(STATUS_UPDATE_PERIOD);
 
-		currentIdleCount = _getIdleCount();
-		idleCountDuringPeriod = currentIdleCount - previousIdleCount;
-		inactiveMilliseconds = _getIdleMilliseconds(idleCountDuringPeriod);
-
-		// It may be possible that the number of elapsed milliseconds is slightly greater than the milliseconds in the status update period
-		// due to randomness in the MQX scheduler. If it is greater, simply set the active milliseconds to zero to avoid an overflow.
-		activeMilliseconds = (inactiveMilliseconds > STATUS_UPDATE_PERIOD) ? 0 : STATUS_UPDATE_PERIOD - inactiveMilliseconds;
-		cpuUtilization = (activeMilliseconds * 100) / STATUS_UPDATE_PERIOD;
-
-		printf("[Status Update] CPU Utilization is: %u %% \n", cpuUtilization);
-
-		previousIdleCount = currentIdleCount;
+		ca_collectCpuUsage(report);
+		_printCpuUsageReport(report);
 	}
 }
 
@@ -308,22 +375,26 @@ void runStatusUpdate(os_task_param_t task_init_data)
 */
 void runMonitor(os_task_param_t task_init_data)
 {
-  /* Write your local variable definition here */
-  
+	printf("[Monitor] Task started.\n");
+	hm_initializeHealthMonitor();
+
+	HealthSummary summary;
+	uint32_t sampleCount = 0;
+
 #ifdef PEX_USE_RTOS
   while (1) {
 #endif
-    /* Write your code here ... */
-    
-    
-    OSA_TimeDelay(10);                 /* Example code (for task release) */
-   
-    
-    
-    
-#ifdef PEX_USE_RTOS   
+	_time_delay(HEALTH_SAMPLE_PERIOD_MS);
+	hm_sampleHealth();
+
+	// Print once per window so the console is not flooded; the latest summary can be queried at any time
+	if(++sampleCount % HEALTH_WINDOW_SAMPLES == 0){
+		hm_getHealthSummary(&summary);
+		hm_printHealthSummary(&summary);
+	}
+#ifdef PEX_USE_RTOS
   }
-#endif    
+#endif
 }
 
 
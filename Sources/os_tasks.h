@@ -23,7 +23,15 @@
 
 #include "Scheduler/scheduler.h"
 #include "TerminalDriver/handler.h"
+#include "TerminalDriver/logSink.h"
+#include "Streams/streamRegistry.h"
+#include "Accounting/cpuAccounting.h"
+#include "Trace/taskTrace.h"
+#include "Workload/workload.h"
+#include "Monitor/healthMonitor.h"
+#include "Monitor/stackMonitor.h"
 #include "schedulerInterface.h"
+#include "binaryInterface.h"
 #include "monitor.h"
 #include "statusUpdate.h"
 #include "serialHandler.h"
@@ -37,27 +45,39 @@ extern "C" {
                           CONSTANTS
  ==============================================================*/
 
-#define HANDLER_INTERRUPT_QUEUE_ID 8
 #define HANDLER_INPUT_QUEUE_ID 9
+#define LOG_HANDLER_INDEX 0				// The terminal log records are drained to
 #define SCHEDULER_QUEUE_ID 10
 #define SCHEDULER_INTERFACE_QUEUE_ID 11
+#define BINARY_INTERFACE_QUEUE_ID 12
 
 #define SERIAL_MESSAGE_POOL_INITIAL_SIZE 1
 #define SERIAL_MESSAGE_POOL_GROWTH_RATE 1
 #define SERIAL_MESSAGE_POOL_MAX_SIZE 16
 
-#define INTERRUPT_MESSAGE_POOL_INITIAL_SIZE 1
-#define INTERRUPT_MESSAGE_POOL_GROWTH_RATE 1
-#define INTERRUPT_MESSAGE_POOL_MAX_SIZE 16
+#define FRAME_MESSAGE_POOL_INITIAL_SIZE 1
+#define FRAME_MESSAGE_POOL_GROWTH_RATE 1
+#define FRAME_MESSAGE_POOL_MAX_SIZE 8
 
 #define STATUS_UPDATE_PERIOD 10000
 
+/*=============================================================
+                      STRUCT DEFINITIONS
+ ==============================================================*/
+
+// Defines a terminal served by its own handler instance
+typedef struct HandlerConfig{
+	uint32_t UartInstance;				// The KSDK UART driver instance
+	uint32_t InputQueueNumber;			// The queue number writers' messages are sent to
+} HandlerConfig, *HandlerConfigPtr;
+
 /*=============================================================
                      TASK ENTRY POINTS
  ==============================================================*/
 
 void runScheduler(os_task_param_t task_init_data);
 void runSerialHandler(os_task_param_t task_init_data);
+void runHandlerInstance(os_task_param_t handlerIndex);
 void runSchedulerInterface(os_task_param_t task_init_data);
 void runStatusUpdate(os_task_param_t task_init_data);
 void runUserTask(uint32_t numTicks);
@@ -1,15 +1,15 @@
 #include "schedulerInterface.h"
 #include "Scheduler/scheduler.h"
+#include "Scheduler/deadlineTimer.h"
 #include "TerminalDriver/handler.h"
+#include "TerminalDriver/logSink.h"
+#include "Streams/streamRegistry.h"
+#include "Monitor/healthMonitor.h"
+#include "Monitor/stackMonitor.h"
+#include "Monitor/heapTelemetry.h"
+#include "Trace/taskTrace.h"
 #include "mqx_ksdk.h"
 
-/*=============================================================
-                      CONSTANTS
- ==============================================================*/
-
-#define PERIODIC_TASK_STACK_SIZE 700
-#define PERIODIC_GENERATOR_TASK_PRIORITY 5
-
 /*=============================================================
                       FUNCTION PROTOTYPES
  ==============================================================*/
@@ -19,82 +19,22 @@ _task_id _handleCreateCommand(char* commandString);
 bool _handleDeleteCommand(char* commandString);
 void _handleGetActiveCommand();
 void _handleGetOverdueCommand();
-
-// Periodic task generation
-void runPeriodicGenerator(os_task_param_t task_init_data);
-_task_id _createPeriodicTask(uint32_t templateIndex, uint32_t deadline, uint32_t period,  PeriodicTaskMappingPtr periodicTaskMap);
-
-//globals
-PeriodicTaskMappingPtr g_mapGeneratorWithTask[50];
-uint32_t g_mapIndex = 0;
+void _handleGetQueueStatsCommand();
+void _handleGetLogStatsCommand();
+void _handleGetTerminalStatsCommand();
+void _handleGetHealthCommand();
+void _handleGetStackUsageCommand();
+void _handleGetHeapCommand();
+bool _handleStreamCommand(char* commandString);
+void _handleListStreamsCommand();
+bool _handleStreamJitterCommand(uint32_t streamId);
+bool _handleTraceCommand(char* commandString);
+void _handleListTemplatesCommand();
 
 // Helper functions
 void _freeTaskList(TaskList taskList);
 void _prettyPrintTaskList();
 
-/*=============================================================
-                      PERIODIC GENERATOR TASK
- ==============================================================*/
-
-//periodic generator task run method
-void runPeriodicGenerator(os_task_param_t parameterListPtr){
-  printf("[Generator] Periodic Task created\n");
-  PeriodicTaskParameterListPtr paramList = (PeriodicTaskParameterListPtr) parameterListPtr;
-#ifdef PEX_USE_RTOS
-  while (1) {
-#endif
-	  printf("[Generator] Periodic task being run\n");
-	  _task_id taskNum = dd_tcreate(paramList->TemplateIndex, paramList->Deadline);
-	  if(taskNum == 0) {
-		  printf("[Generator] Could not create periodic task\n");
-		  _task_block();
-	  }
-	  paramList->periodicTaskMap->userTaskID = taskNum; // Add the task id to the paramlist
-	  printf("[Generator] Periodic task ID is: %u\n", taskNum);
-	  _time_delay(paramList->Period);
-
-#ifdef PEX_USE_RTOS
-  }
-#endif
-  free(paramList);
-}
-
-//initialize the parameter list struct
-static PeriodicTaskParameterListPtr _initializePeriodicTaskParameterList(){
-	PeriodicTaskParameterListPtr list;
-	if(!(list = (PeriodicTaskParameterListPtr) malloc(sizeof(PeriodicTaskParameterList)))){
-		printf("[Scheduler Interface] Unable to allocate memory for periodic task parameter list struct.\n");
-		_task_block();
-	}
-	memset(list, 0, sizeof(PeriodicTaskParameterList));
-	return list;
-}
-
-//initialize the mapping list struct
-static PeriodicTaskMappingPtr _initializePeriodicTaskMapping(){
-	PeriodicTaskMappingPtr list;
-	if(!(list = (PeriodicTaskMappingPtr) malloc(sizeof(PeriodicTaskMapping)))){
-		printf("[Scheduler Interface] Unable to allocate memory for periodic task mapping struct.\n");
-		_task_block();
-	}
-	memset(list, 0, sizeof(PeriodicTaskMapping));
-	return list;
-}
-
-//create a periodic task
-_task_id _createPeriodicTask(uint32_t templateIndex, uint32_t deadline, uint32_t period, PeriodicTaskMappingPtr periodicTaskMap){
-	//create struct to hold uint32_t templateIndex, uint32_t deadline, uint32_t period
-	PeriodicTaskParameterListPtr paramList = _initializePeriodicTaskParameterList();
-	paramList->TemplateIndex = templateIndex; //add all the elements of the paramlist
-	paramList->Deadline = deadline;
-	paramList->Period = period;
-	paramList->periodicTaskMap = periodicTaskMap;
-	TASK_TEMPLATE_STRUCT generatorTaskTemplate = { 0, runPeriodicGenerator, PERIODIC_TASK_STACK_SIZE, 1, "Periodic Task", 0, (uint32_t) paramList, 0};
-	_task_id newTaskId = _task_create(0, 0, (uint32_t) &generatorTaskTemplate);
-	return newTaskId;
-}
-
-
 /*=============================================================
                       PUBLIC INTERFACE
  ==============================================================*/
@@ -113,6 +53,31 @@ bool si_handleCommand(char* commandString){
 		case 'o': // Request overdue task list
 			_handleGetOverdueCommand();
 			break;
+		case 'q': // Request scheduler queue statistics
+			_handleGetQueueStatsCommand();
+			break;
+		case 'l': // Request logging statistics
+			_handleGetLogStatsCommand();
+			break;
+		case 't': // Request terminal receive statistics
+			_handleGetTerminalStatsCommand();
+			break;
+		case 'h': // Request the health monitor's latest summary
+			_handleGetHealthCommand();
+			break;
+		case 's': // Request stack usage and recommended stack sizes
+			_handleGetStackUsageCommand();
+			break;
+		case 'm': // Request heap usage and allocator statistics
+			_handleGetHeapCommand();
+			break;
+		case 'p': // List, stop or change the period of periodic streams
+			return _handleStreamCommand(commandString);
+		case 'x': // Start, stop or dump the task trace
+			return _handleTraceCommand(commandString);
+		case 'r': // List the registered task templates
+			_handleListTemplatesCommand();
+			break;
 		default:
 			printf("[Scheduler Interface] Invalid command.\n");
 			return false;
@@ -128,22 +93,45 @@ bool si_handleCommand(char* commandString){
 _task_id _handleCreateCommand(char* commandString){
 	char token[2] = " ";
 	strtok(commandString,token);
-	uint32_t templateIndex = atoi(strtok(NULL,token));
-	uint32_t deadline = atoi(strtok(NULL,token));
-	uint32_t period = atoi(strtok(NULL,token));
-	if(period == 0){//aperiodic task. Just call this once
-		return dd_tcreate(templateIndex, deadline);
-	} else {//periodic task. Create a Generator, mapping between user task Id and generator id, and add mapping to array
-		PeriodicTaskMappingPtr periodicTaskMap = _initializePeriodicTaskMapping();
-		_task_id newPeriodicGenerator = _createPeriodicTask(templateIndex, deadline, period, periodicTaskMap);
-		periodicTaskMap->periodicGeneratorID = newPeriodicGenerator;
-		g_mapGeneratorWithTask[g_mapIndex] = periodicTaskMap;
-		if(g_mapIndex > 47){//make sure the the array doesn't overflow
-			printf("[Scheduler Interface] Too many periodic tasks. Do not add more.\n");
-		} else {
-			g_mapIndex++;
+	char* templateString = strtok(NULL,token);
+	char* deadlineString = strtok(NULL,token);
+	if(templateString == NULL || deadlineString == NULL){//both the template and the deadline are required
+		printf("[Scheduler Interface] Usage: c <template> <deadline>[us] [period] [phase|auto] [arg=<argument>]\n");
+		return MQX_NULL_TASK_ID;
+	}
+	uint32_t templateIndex = atoi(templateString);
+	uint32_t deadline = atoi(deadlineString);
+	bool deadlineInMicroseconds = (strstr(deadlineString, "us") != NULL);//deadlines such as "500us" are in microseconds rather than ticks
+	uint32_t period = 0;
+	uint32_t phase = STREAM_PHASE_NONE;
+	uint32_t argument = 0;
+	bool hasArgument = false;
+	int positionCount = 0;
+	for(char* optionString = strtok(NULL,token); optionString != NULL; optionString = strtok(NULL,token)){
+		if(strncmp(optionString, "arg=", 4) == 0){//an argument passed to the job in place of the template's parameter
+			argument = strtoul(&optionString[4], NULL, 0);
+			hasArgument = true;
+		} else if(positionCount++ == 0){
+			period = atoi(optionString);
+		} else if(isdigit((unsigned char) optionString[0])){//an optional phase in ticks, or "auto" to spread releases out
+			phase = atoi(optionString);
+		} else if(strncmp(optionString, "auto", 4) == 0){
+			phase = STREAM_PHASE_AUTO;
+		}
+	}
+	if(period == 0 && hasArgument){//aperiodic task. Just call this once
+		return deadlineInMicroseconds ? dd_tcreate_us_arg(templateIndex, deadline, argument) : dd_tcreate_arg(templateIndex, deadline, argument);
+	} else if(period == 0){
+		return deadlineInMicroseconds ? dd_tcreate_us(templateIndex, deadline) : dd_tcreate(templateIndex, deadline);
+	} else {//periodic task. Start a stream whose generator releases a job every period
+		uint32_t streamId = sr_createStream(templateIndex, deadline, deadlineInMicroseconds, period, phase,
+				hasArgument ? &argument : NULL);
+		if(streamId == 0){
+			printf("[Scheduler Interface] Unable to start a periodic stream.\n");
+			return MQX_NULL_TASK_ID;
 		}
-		return newPeriodicGenerator;
+		printf("[Scheduler Interface] Started periodic stream %u\n", streamId);
+		return streamId;
 	}
 }
 
@@ -155,11 +143,9 @@ bool _handleDeleteCommand(char* commandString){
 	if(strtok(NULL,token) != NULL){
 			return false;
 	}
-	int i = 0;
-	for(i = 0; i < g_mapIndex + 1; i++){
-		if(g_mapGeneratorWithTask[i]->userTaskID == taskId){
-			_task_destroy(g_mapGeneratorWithTask[i]->periodicGeneratorID);
-		}
+	uint32_t streamId = sr_getStreamOfJob(taskId);
+	if(streamId != 0){//deleting a periodic job also stops the stream that released it
+		sr_stopStream(streamId);
 	}
 	return dd_delete(taskId);
 }
@@ -192,6 +178,198 @@ void _handleGetOverdueCommand(){
 	return;
 }
 
+//prints the scheduler request queue statistics
+void _handleGetQueueStatsCommand(){
+	static const char* requestNames[SCHEDULER_MESSAGE_TYPE_COUNT] = { "Create", "Delete", "Active", "Overdue", "Expired" };
+	SchedulerQueueStats stats;
+	dd_get_queue_stats(&stats);
+	printf("[Scheduler Interface] Request queue depth: %u (max %u)\n", stats.CurrentDepth, stats.MaxDepth);
+	for(int i = 0; i < SCHEDULER_MESSAGE_TYPE_COUNT; i++){
+		uint32_t averageWait = (stats.RequestCount[i] == 0) ? 0 : (uint32_t)(stats.TotalWaitTicks[i] / stats.RequestCount[i]);
+		printf(" %-8s count: %u  avg wait: %u ticks  max wait: %u ticks\n",
+				requestNames[i], stats.RequestCount[i], averageWait, stats.MaxWaitTicks[i]);
+	}
+
+	DeadlineTimerStats timerStats;
+	getDeadlineTimerStats(&timerStats);
+	int32_t averageLatency = (timerStats.Expirations == 0) ? 0 : (int32_t)(timerStats.TotalLatencyUs / timerStats.Expirations);
+	printf("[Scheduler Interface] Deadline enforcement: %u expirations, latency min/avg/max: %d/%d/%d us, early: %u, dropped: %u\n",
+			timerStats.Expirations, timerStats.MinLatencyUs, averageLatency, timerStats.MaxLatencyUs,
+			timerStats.EarlyCount, timerStats.DroppedNotifications);
+	return;
+}
+
+//prints the asynchronous log's per-call cost and dropped record count
+void _handleGetLogStatsCommand(){
+	LogSinkStats stats;
+	getLogSinkStats(&stats);
+	uint64_t averageCost = (stats.RecordCount == 0) ? 0 : stats.TotalCostHwTicks / stats.RecordCount;
+	printf("[Scheduler Interface] Log records: %u, dropped: %u, max waiting: %u/%u\n",
+			stats.RecordCount, stats.DroppedCount, stats.MaxOccupancy, LOG_RING_SIZE);
+	printf("[Scheduler Interface] Log call cost: avg %u ns, max %u ns\n",
+			_convertLogHwTicksToNanoseconds(averageCost), _convertLogHwTicksToNanoseconds(stats.MaxCostHwTicks));
+	return;
+}
+
+//prints each terminal's receive backlog, flow control and framing counters
+void _handleGetTerminalStatsCommand(){
+	TerminalStats stats;
+	for(uint32_t i = 0; i < GetHandlerCount(); i++){
+		GetTerminalStats(GetHandler(i), &stats);
+		printf("[Scheduler Interface] Terminal %u received: %u, dropped: %u, backlog: %u (max %u of %u)\n",
+				i, stats.ReceivedCount, stats.DroppedCount, stats.Occupancy, stats.MaxOccupancy, RX_RING_SIZE);
+		printf(" Flow control: %s, XOFF sent: %u, XON sent: %u\n",
+				stats.IsThrottled ? "throttled" : "open", stats.ThrottleCount, stats.ResumeCount);
+		printf(" Frames decoded: %u, discarded: %u; line pool max in use: %u, exhausted: %u, reader overflows: %u\n",
+				stats.FrameCount, stats.FrameErrorCount, stats.LinePoolMaxInUse, stats.LinePoolExhaustedCount,
+				stats.ReaderOverflowCount);
+	}
+	return;
+}
+
+//prints the health monitor's summary of its most recent window
+void _handleGetHealthCommand(){
+	HealthSummary summary;
+	hm_getHealthSummary(&summary);
+	hm_printHealthSummary(&summary);
+	return;
+}
+
+//prints each template's and task's deepest stack use and a recommended stack size
+void _handleGetStackUsageCommand(){
+	StackUsageReportPtr report = (StackUsageReportPtr) malloc(sizeof(StackUsageReport));
+	if(report == NULL){
+		printf("[Scheduler Interface] Unable to allocate a stack usage report.\n");
+		return;
+	}
+	sm_collectStackUsage(report);
+	sm_printStackUsageReport(report);
+	free(report);
+	return;
+}
+
+//prints the heap's free space and fragmentation with malloc and free counts and latencies
+void _handleGetHeapCommand(){
+	HeapAllocatorStats stats;
+	HeapUsage usage;
+	ht_getAllocatorStats(&stats);
+	ht_getHeapUsage(&usage);
+	ht_printHeapReport(&stats, &usage);
+	return;
+}
+
+//handles "p" to list periodic streams, "p stop <stream>", "p period <stream> <ticks>", "p jitter <stream>"
+//and "p spread on|off", which sets whether streams created without a phase have one chosen for them
+bool _handleStreamCommand(char* commandString){
+	char token[3] = " \n";
+	strtok(commandString,token);
+	char* operation = strtok(NULL,token);
+	if(operation == NULL || strcmp(operation, "list") == 0){
+		_handleListStreamsCommand();
+		return true;
+	}
+
+	char* streamIdString = strtok(NULL,token);
+	if(streamIdString == NULL){
+		return false;
+	}
+	if(strcmp(operation, "spread") == 0){
+		sr_setPhaseSpreading(strcmp(streamIdString, "on") == 0);
+		return true;
+	}
+	uint32_t streamId = atoi(streamIdString);
+	if(strcmp(operation, "stop") == 0){
+		return sr_stopStream(streamId);
+	}
+	if(strcmp(operation, "period") == 0){
+		char* periodString = strtok(NULL,token);
+		return periodString != NULL && sr_setStreamPeriod(streamId, atoi(periodString));
+	}
+	if(strcmp(operation, "jitter") == 0){
+		return _handleStreamJitterCommand(streamId);
+	}
+	printf("[Scheduler Interface] Invalid stream command.\n");
+	return false;
+}
+
+//prints every running periodic stream
+void _handleListStreamsCommand(){
+	uint32_t count;
+	PeriodicStreamInfoPtr streams = sr_getStreamList(&count);
+	if(streams == NULL){
+		printf("[Scheduler Interface] No Periodic Streams\n");
+		return;
+	}
+	printf("[Scheduler Interface] Periodic Streams:\n");
+	for(uint32_t i = 0; i < count; i++){
+		printf(" Stream %u  template: %u  deadline: %u%s  argument: %u  period: %u ticks  phase: %u  released: %u  latest job: %u\n",
+				streams[i].StreamId, streams[i].TemplateIndex, streams[i].Deadline,
+				streams[i].DeadlineInMicroseconds ? " us" : " ticks", streams[i].Argument, streams[i].Period, streams[i].Phase,
+				streams[i].ReleaseCount, streams[i].LatestJobId);
+	}
+	free(streams);
+	return;
+}
+
+//prints every registered task template and its scheduling metadata
+void _handleListTemplatesCommand(){
+	uint32_t count = dd_get_template_count();
+	printf("[Scheduler Interface] Task Templates:\n");
+	for(uint32_t i = 0; i < count; i++){
+		const TaskTemplateInfo* info = dd_get_template_info(i);
+		printf(" Template %u  %s  stack: %u  parameter: %u  WCET: %u us  deadline: %u ticks  period: %u ticks  on miss: %s\n",
+				i, info->Name, info->StackSize, info->Parameter, info->WcetMicroseconds, info->DefaultDeadline,
+				info->DefaultPeriod, (info->MissPolicy == MISS_POLICY_DEMOTE) ? "demote" : "abort");
+	}
+}
+
+//prints a stream's release jitter histogram
+bool _handleStreamJitterCommand(uint32_t streamId){
+	StreamJitterStats stats;
+	if(!sr_getStreamJitter(streamId, &stats)){
+		printf("[Scheduler Interface] No such periodic stream.\n");
+		return false;
+	}
+	int32_t averageJitter = (stats.ReleaseCount == 0) ? 0 : (int32_t)(stats.TotalJitterUs / stats.ReleaseCount);
+	printf("[Scheduler Interface] Stream %u releases: %u, jitter min/avg/max: %d/%d/%d us, early: %u, overruns: %u\n",
+			streamId, stats.ReleaseCount, stats.MinJitterUs, averageJitter, stats.MaxJitterUs, stats.EarlyCount,
+			stats.OverrunCount);
+	for(int i = 0; i < STREAM_JITTER_BUCKET_COUNT; i++){
+		if(i < STREAM_JITTER_BUCKET_COUNT - 1){
+			printf(" < %6u us: %u\n", STREAM_JITTER_FIRST_BUCKET_US << i, stats.Histogram[i]);
+		} else {
+			printf(" >= %5u us: %u\n", STREAM_JITTER_FIRST_BUCKET_US << (i - 1), stats.Histogram[i]);
+		}
+	}
+	return true;
+}
+
+//handles "x start" to clear the trace buffer and start tracing, "x stop" and "x dump", which stops tracing and
+//prints the buffer for Tools/TraceExport/ddTraceExport
+bool _handleTraceCommand(char* commandString){
+	char token[3] = " \n";
+	strtok(commandString,token);
+	char* operation = strtok(NULL,token);
+	if(operation == NULL){
+		return false;
+	}
+	if(strcmp(operation, "start") == 0){
+		tr_startTrace();
+		printf("[Scheduler Interface] Tracing started.\n");
+		return true;
+	}
+	if(strcmp(operation, "stop") == 0){
+		tr_stopTrace();
+		printf("[Scheduler Interface] Tracing stopped.\n");
+		return true;
+	}
+	if(strcmp(operation, "dump") == 0){
+		tr_dumpTrace();
+		return true;
+	}
+	printf("[Scheduler Interface] Invalid trace command.\n");
+	return false;
+}
 
 /*=============================================================
                        HELPER FUNCTIONS
@@ -5,30 +5,16 @@
 #include <mutex.h>
 #include <ctype.h>
 #include <string.h>
+#include "Scheduler/scheduler.h"
 
 #ifndef _SCHEDULER_INTERFACEH_
 #define _SCHEDULER_INTERFACEH_
 
-/*=============================================================
-                      STRUCT DEFINITIONS
- ==============================================================*/
-
-typedef struct PeriodicTaskMapping{
-	_task_id periodicGeneratorID;
-	_task_id userTaskID;
-} PeriodicTaskMapping, *PeriodicTaskMappingPtr;
-
-typedef struct PeriodicTaskParameterList{
-	uint32_t TemplateIndex;
-	uint32_t Deadline;
-	uint32_t Period;
-	PeriodicTaskMappingPtr periodicTaskMap;
-} PeriodicTaskParameterList, *PeriodicTaskParameterListPtr;
-
 /*=============================================================
                       SCHEDULER INTERFACE
  ==============================================================*/
 bool si_handleCommand(char* commandString);
+void _freeTaskList(TaskList taskList);
 
 
 #endif
@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "edfAnalysis.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define EDF_LINE_MAX 256
+#define EDF_UTILIZATION_EPSILON 1e-12
+#define EDF_BUSY_PERIOD_ITERATION_MAX 1000		// Past this, the demand bound falls back to the utilization bound
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+// Task set parsing
+static bool _parseTaskLine(char* line, int lineNumber, EdfTaskSetPtr taskSet);
+static char* _parseTaskName(char* line, char* name);
+
+// Demand bound helpers
+static uint64_t _getMaxDeadlineBefore(const EdfTaskSet* taskSet, uint64_t t);
+static bool _iterateSynchronousBusyPeriod(const EdfTaskSet* taskSet, uint64_t* length, uint64_t limit);
+static uint64_t _getDemandBound(const EdfTaskSet* taskSet, double utilization, uint64_t* busyPeriodFloor);
+static uint64_t _getHyperperiod(const EdfTaskSet* taskSet);
+static uint32_t _getMinimumDeadline(const EdfTaskSet* taskSet);
+
+/*=============================================================
+                         TASK SETS
+ ==============================================================*/
+
+void edf_initializeTaskSet(EdfTaskSetPtr taskSet){
+	taskSet->Count = 0;
+	taskSet->MaxSize = 0;
+	taskSet->Tasks = NULL;
+}
+
+void edf_freeTaskSet(EdfTaskSetPtr taskSet){
+	free(taskSet->Tasks);
+	edf_initializeTaskSet(taskSet);
+}
+
+bool edf_addTask(EdfTaskSetPtr taskSet, const char* name, uint32_t wcet, uint32_t deadline, uint32_t period){
+	if(wcet == 0 || deadline == 0 || period == 0){
+		return false;
+	}
+
+	// Grow the task array if it is full
+	if(taskSet->Count == taskSet->MaxSize){
+		uint32_t newSize = (taskSet->MaxSize == 0) ? EDF_TASK_SET_INITIAL_SIZE : taskSet->MaxSize * 2;
+		EdfTaskPtr tasks;
+		if(!(tasks = (EdfTaskPtr) realloc(taskSet->Tasks, sizeof(EdfTask) * newSize))){
+			fprintf(stderr, "Unable to allocate memory for %u tasks.\n", newSize);
+			return false;
+		}
+		taskSet->Tasks = tasks;
+		taskSet->MaxSize = newSize;
+	}
+
+	EdfTaskPtr task = &taskSet->Tasks[taskSet->Count];
+	memset(task, 0, sizeof(EdfTask));
+	strncpy(task->Name, name, EDF_TASK_NAME_MAX - 1);
+	task->Wcet = wcet;
+	task->Deadline = deadline;
+	task->Period = period;
+	taskSet->Count++;
+
+	return true;
+}
+
+// Reads a task set in which every line mirrors a USER_TASKS entry:
+//   <name> <creation parameter (WCET ticks)> <relative deadline> <period>
+// Names containing spaces must be quoted. Text after a '#' is ignored.
+bool edf_loadTaskSet(const char* path, EdfTaskSetPtr taskSet){
+	FILE* file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+	if(file == NULL){
+		fprintf(stderr, "Unable to open task set file %s.\n", path);
+		return false;
+	}
+
+	char line[EDF_LINE_MAX];
+	int lineNumber = 0;
+	bool result = true;
+	while(result && fgets(line, sizeof(line), file) != NULL){
+		lineNumber++;
+		result = _parseTaskLine(line, lineNumber, taskSet);
+	}
+
+	if(file != stdin){
+		fclose(file);
+	}
+	return result;
+}
+
+/*=============================================================
+                         ANALYSIS
+ ==============================================================*/
+
+double edf_getUtilization(const EdfTaskSet* taskSet){
+	double utilization = 0;
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		utilization += (double) taskSet->Tasks[i].Wcet / taskSet->Tasks[i].Period;
+	}
+	return utilization;
+}
+
+// Returns h(t), the total execution time of all jobs released and due within [0, t]
+uint64_t edf_getDemand(const EdfTaskSet* taskSet, uint64_t t){
+	uint64_t demand = 0;
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		const EdfTask* task = &taskSet->Tasks[i];
+		if(task->Deadline <= t){
+			demand += ((t - task->Deadline) / task->Period + 1) * task->Wcet;
+		}
+	}
+	return demand;
+}
+
+// Quick Processor-demand Analysis (Zhang & Burns, 2009). Instead of evaluating h(t) at every absolute
+// deadline below the bound L, the test walks backwards from L and jumps straight to h(t) whenever
+// h(t) < t, so only a handful of demand evaluations are needed even for large task sets.
+bool edf_runQpa(const EdfTaskSet* taskSet, EdfResultPtr result){
+	return edf_runQpaFrom(taskSet, 0, result);
+}
+
+// As edf_runQpa, but the busy period iteration starts from busyPeriodFloor, which must not exceed the set's
+// synchronous busy period. The BusyPeriodFloor of a previous result qualifies whenever no task has since had
+// its WCET lowered or its period raised.
+bool edf_runQpaFrom(const EdfTaskSet* taskSet, uint64_t busyPeriodFloor, EdfResultPtr result){
+	memset(result, 0, sizeof(EdfResult));
+	result->Utilization = edf_getUtilization(taskSet);
+
+	if(taskSet->Count == 0){
+		result->Feasible = true;
+		return true;
+	}
+
+	// A set that needs more than the whole processor can never be feasible
+	if(result->Utilization > 1 + EDF_UTILIZATION_EPSILON){
+		result->Feasible = false;
+		return false;
+	}
+
+	uint64_t bound = _getDemandBound(taskSet, result->Utilization, &busyPeriodFloor);
+	result->BusyPeriodFloor = busyPeriodFloor;
+
+	// A set whose demand bound does not fit in 64 bits cannot be checked, so it is not accepted
+	if(bound == UINT64_MAX){
+		result->Bound = bound;
+		result->Feasible = false;
+		return false;
+	}
+
+	uint64_t minimumDeadline = _getMinimumDeadline(taskSet);
+	uint64_t t = _getMaxDeadlineBefore(taskSet, bound);
+	uint64_t demand = edf_getDemand(taskSet, t);
+
+	result->Bound = bound;
+	result->Iterations = 1;
+	result->MinimumSlack = (int64_t) t - (int64_t) demand;
+
+	while(demand <= t && demand > minimumDeadline){
+		t = (demand < t) ? demand : _getMaxDeadlineBefore(taskSet, t);
+		demand = edf_getDemand(taskSet, t);
+		result->Iterations++;
+
+		int64_t slack = (int64_t) t - (int64_t) demand;
+		if(slack < result->MinimumSlack){
+			result->MinimumSlack = slack;
+		}
+	}
+
+	result->Feasible = (demand <= minimumDeadline);
+	result->FailedAt = result->Feasible ? 0 : t;
+	return result->Feasible;
+}
+
+/*=============================================================
+                      DEMAND BOUND HELPERS
+ ==============================================================*/
+
+// Returns the largest absolute deadline strictly less than t, or 0 if there is none
+static uint64_t _getMaxDeadlineBefore(const EdfTaskSet* taskSet, uint64_t t){
+	uint64_t maxDeadline = 0;
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		const EdfTask* task = &taskSet->Tasks[i];
+		if(task->Deadline < t){
+			uint64_t deadline = task->Deadline + ((t - task->Deadline - 1) / task->Period) * task->Period;
+			if(deadline > maxDeadline){
+				maxDeadline = deadline;
+			}
+		}
+	}
+	return maxDeadline;
+}
+
+// Iterates the length of the first busy period, when every task is released at time 0, upwards from *length,
+// which must not exceed it. Returns true once the iteration converges, leaving the busy period in *length. Returns
+// false if *length reaches limit or the iteration cap first, leaving a lower bound on the busy period in *length.
+static bool _iterateSynchronousBusyPeriod(const EdfTaskSet* taskSet, uint64_t* length, uint64_t limit){
+	uint64_t totalWcet = 0;
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		totalWcet += taskSet->Tasks[i].Wcet;
+	}
+	if(*length < totalWcet){
+		*length = totalWcet;
+	}
+
+	for(uint32_t iteration=0; iteration<EDF_BUSY_PERIOD_ITERATION_MAX && *length < limit; iteration++){
+		uint64_t nextLength = 0;
+		for(uint32_t i=0; i<taskSet->Count; i++){
+			const EdfTask* task = &taskSet->Tasks[i];
+			nextLength += ((*length + task->Period - 1) / task->Period) * task->Wcet;
+		}
+		if(nextLength == *length){
+			return true;
+		}
+		*length = nextLength;
+	}
+	return false;
+}
+
+// Returns L, the length of the interval beyond which no deadline can be missed if none was missed before it, or
+// UINT64_MAX if there is none. *busyPeriodFloor seeds the busy period iteration, and is raised to where it stopped.
+static uint64_t _getDemandBound(const EdfTaskSet* taskSet, double utilization, uint64_t* busyPeriodFloor){
+	// When the processor is fully utilized, the busy period runs to the hyperperiod. Otherwise it is capped by the
+	// Baruah/Zhang-Burns utilization bound, which grows without limit as utilization approaches 1.
+	uint64_t limit;
+	if(utilization > 1 - EDF_UTILIZATION_EPSILON){
+		limit = _getHyperperiod(taskSet);
+	}
+	else{
+		double weightedLaxity = 0;
+		uint32_t maxDeadline = 0;
+		for(uint32_t i=0; i<taskSet->Count; i++){
+			const EdfTask* task = &taskSet->Tasks[i];
+			weightedLaxity += ((double) task->Period - task->Deadline) * task->Wcet / task->Period;
+			if(task->Deadline > maxDeadline){
+				maxDeadline = task->Deadline;
+			}
+		}
+
+		double utilizationBound = ceil(weightedLaxity / (1 - utilization));
+		limit = (utilizationBound >= (double) UINT64_MAX) ? UINT64_MAX : (uint64_t) utilizationBound;
+		if(limit < maxDeadline){
+			limit = maxDeadline;
+		}
+	}
+
+	// Use the busy period if it converges below the limit; the limit is a valid bound in its own right
+	uint64_t busyPeriod = *busyPeriodFloor;
+	bool isConverged = _iterateSynchronousBusyPeriod(taskSet, &busyPeriod, limit);
+	*busyPeriodFloor = busyPeriod;
+	return (isConverged && busyPeriod < limit) ? busyPeriod : limit;
+}
+
+// Returns the least common multiple of the periods, or UINT64_MAX if it does not fit
+static uint64_t _getHyperperiod(const EdfTaskSet* taskSet){
+	uint64_t hyperperiod = 1;
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		uint64_t a = hyperperiod, b = taskSet->Tasks[i].Period;
+		while(b != 0){
+			uint64_t remainder = a % b;
+			a = b;
+			b = remainder;
+		}
+		uint64_t factor = taskSet->Tasks[i].Period / a;
+		if(hyperperiod > UINT64_MAX / factor){
+			return UINT64_MAX;
+		}
+		hyperperiod *= factor;
+	}
+	return hyperperiod;
+}
+
+static uint32_t _getMinimumDeadline(const EdfTaskSet* taskSet){
+	uint32_t minimumDeadline = UINT32_MAX;
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		if(taskSet->Tasks[i].Deadline < minimumDeadline){
+			minimumDeadline = taskSet->Tasks[i].Deadline;
+		}
+	}
+	return minimumDeadline;
+}
+
+/*=============================================================
+                       TASK SET PARSING
+ ==============================================================*/
+
+static bool _parseTaskLine(char* line, int lineNumber, EdfTaskSetPtr taskSet){
+	// Strip comments
+	char* comment = strchr(line, '#');
+	if(comment != NULL){
+		*comment = '\0';
+	}
+
+	// Skip blank lines
+	while(isspace((unsigned char) *line)){
+		line++;
+	}
+	if(*line == '\0'){
+		return true;
+	}
+
+	char name[EDF_TASK_NAME_MAX];
+	char* fields = _parseTaskName(line, name);
+	unsigned long wcet, deadline, period;
+	char trailing;
+	if(fields == NULL || sscanf(fields, "%lu %lu %lu %c", &wcet, &deadline, &period, &trailing) != 3){
+		fprintf(stderr, "Line %d: expected <name> <wcet> <deadline> <period>.\n", lineNumber);
+		return false;
+	}
+
+	if(wcet == 0 || deadline == 0 || period == 0 || wcet > UINT32_MAX || deadline > UINT32_MAX || period > UINT32_MAX){
+		fprintf(stderr, "Line %d: wcet, deadline and period must be positive 32-bit tick counts.\n", lineNumber);
+		return false;
+	}
+
+	return edf_addTask(taskSet, name, (uint32_t) wcet, (uint32_t) deadline, (uint32_t) period);
+}
+
+// Copies the (optionally quoted) task name at the start of line into name and returns the remainder of the line
+static char* _parseTaskName(char* line, char* name){
+	char terminator = ' ';
+	if(*line == '"'){
+		terminator = '"';
+		line++;
+	}
+
+	int length = 0;
+	while(*line != '\0' && *line != terminator && (terminator == '"' || !isspace((unsigned char) *line))){
+		if(length < EDF_TASK_NAME_MAX - 1){
+			name[length++] = *line;
+		}
+		line++;
+	}
+	name[length] = '\0';
+
+	if(terminator == '"'){
+		if(*line != '"'){
+			return NULL;
+		}
+		line++;
+	}
+	return (length == 0) ? NULL : line;
+}
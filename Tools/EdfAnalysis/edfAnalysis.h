@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TOOLS_EDFANALYSIS_H_
+#define TOOLS_EDFANALYSIS_H_
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define EDF_TASK_NAME_MAX 32
+#define EDF_TASK_SET_INITIAL_SIZE 16
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines one periodic task stream; all times are in scheduler ticks
+typedef struct EdfTask{
+	char Name[EDF_TASK_NAME_MAX];
+	uint32_t Wcet;
+	uint32_t Deadline;
+	uint32_t Period;
+} EdfTask, *EdfTaskPtr;
+
+// Defines a growable list of EdfTask objects
+typedef struct EdfTaskSet{
+	uint32_t Count;
+	uint32_t MaxSize;
+	EdfTaskPtr Tasks;
+} EdfTaskSet, *EdfTaskSetPtr;
+
+// Defines the outcome of a feasibility test
+typedef struct EdfResult{
+	bool Feasible;
+	double Utilization;
+	uint64_t Bound;					// The length of the interval that had to be checked
+	uint64_t FailedAt;				// The interval length at which demand exceeded supply (infeasible sets only)
+	int64_t MinimumSlack;			// The smallest t - h(t) over every interval the test evaluated
+	uint32_t Iterations;			// The number of demand evaluations performed
+	uint64_t BusyPeriodFloor;		// A lower bound on the synchronous busy period, to seed a later run
+} EdfResult, *EdfResultPtr;
+
+/*=============================================================
+                        TASK SETS
+ ==============================================================*/
+
+void edf_initializeTaskSet(EdfTaskSetPtr taskSet);
+void edf_freeTaskSet(EdfTaskSetPtr taskSet);
+bool edf_addTask(EdfTaskSetPtr taskSet, const char* name, uint32_t wcet, uint32_t deadline, uint32_t period);
+bool edf_loadTaskSet(const char* path, EdfTaskSetPtr taskSet);
+
+/*=============================================================
+                         ANALYSIS
+ ==============================================================*/
+
+double edf_getUtilization(const EdfTaskSet* taskSet);
+uint64_t edf_getDemand(const EdfTaskSet* taskSet, uint64_t t);
+bool edf_runQpa(const EdfTaskSet* taskSet, EdfResultPtr result);
+bool edf_runQpaFrom(const EdfTaskSet* taskSet, uint64_t busyPeriodFloor, EdfResultPtr result);
+
+#endif
@@ -0,0 +1,85 @@
+// Offline EDF schedulability analyzer for DDScheduler task sets.
+//
+// Build (host):  gcc -std=c99 -O2 -o edfAnalyzer edfAnalyzer.c edfAnalysis.c -lm
+// Usage:         edfAnalyzer <taskset file | ->
+//
+// The task set format is described in edfAnalysis.c; see taskset.txt for the USER_TASKS table.
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "edfAnalysis.h"
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static void _printTaskSet(const EdfTaskSet* taskSet);
+static void _printResult(const EdfResult* result, double elapsedMs);
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	if(argc != 2){
+		fprintf(stderr, "Usage: %s <taskset file | ->\n", argv[0]);
+		return 2;
+	}
+
+	EdfTaskSet taskSet;
+	edf_initializeTaskSet(&taskSet);
+	if(!edf_loadTaskSet(argv[1], &taskSet)){
+		edf_freeTaskSet(&taskSet);
+		return 2;
+	}
+
+	EdfResult result;
+	clock_t start = clock();
+	edf_runQpa(&taskSet, &result);
+	double elapsedMs = (double)(clock() - start) * 1000 / CLOCKS_PER_SEC;
+
+	_printTaskSet(&taskSet);
+	_printResult(&result, elapsedMs);
+
+	edf_freeTaskSet(&taskSet);
+	return result.Feasible ? 0 : 1;
+}
+
+/*=============================================================
+                           OUTPUT
+ ==============================================================*/
+
+static void _printTaskSet(const EdfTaskSet* taskSet){
+	printf("%-*s %10s %10s %10s %8s\n", EDF_TASK_NAME_MAX, "Task", "WCET", "Deadline", "Period", "Util");
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		const EdfTask* task = &taskSet->Tasks[i];
+		printf("%-*s %10u %10u %10u %8.4f\n", EDF_TASK_NAME_MAX, task->Name,
+				task->Wcet, task->Deadline, task->Period, (double) task->Wcet / task->Period);
+	}
+	printf("\n");
+}
+
+static void _printResult(const EdfResult* result, double elapsedMs){
+	printf("Utilization:        %.4f (slack %.4f)\n", result->Utilization, 1 - result->Utilization);
+	printf("Interval checked:   %llu ticks\n", (unsigned long long) result->Bound);
+	printf("Demand evaluations: %u\n", result->Iterations);
+	if(result->Iterations > 0){
+		printf("Minimum slack:      %lld ticks\n", (long long) result->MinimumSlack);
+	}
+	printf("Analysis time:      %.3f ms\n", elapsedMs);
+
+	if(result->Feasible){
+		printf("Verdict:            FEASIBLE\n");
+	}
+	else if(result->Bound == UINT64_MAX){
+		printf("Verdict:            INFEASIBLE (no demand bound within 64 bits; not analyzed)\n");
+	}
+	else if(result->Iterations == 0){
+		printf("Verdict:            INFEASIBLE (utilization exceeds 1)\n");
+	}
+	else{
+		printf("Verdict:            INFEASIBLE (demand exceeds supply at t = %llu)\n",
+				(unsigned long long) result->FailedAt);
+	}
+}
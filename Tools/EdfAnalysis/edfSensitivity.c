@@ -0,0 +1,188 @@
+// EDF sensitivity analysis for DDScheduler task sets.
+//
+// Build (host):  gcc -std=c99 -O2 -o edfSensitivity edfSensitivity.c edfAnalysis.c -lm
+// Usage:         edfSensitivity <taskset file | ->
+//
+// For every template in the task set, the largest WCET and the smallest period that keep the whole
+// set EDF-feasible are found by binary search, holding every other task fixed. Feasibility is
+// monotone in both parameters, so each search needs O(log range) QPA runs. The demand bound QPA has to
+// check grows without limit as utilization approaches 1, so probes within EDF_SENSITIVITY_MARGIN of full
+// utilization are rejected without analysis, and the headroom reported leaves that much spare. Each probe
+// also starts its busy period iteration from where the last feasible probe's stopped.
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "edfAnalysis.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define EDF_SENSITIVITY_MARGIN 1e-3			// The utilization every probe must leave spare
+
+/*=============================================================
+                        LOCAL TYPES
+ ==============================================================*/
+
+// Defines the headroom of a single template
+typedef struct EdfHeadroom{
+	uint32_t MaxWcet;
+	uint32_t MinPeriod;
+} EdfHeadroom, *EdfHeadroomPtr;
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static bool _isFeasible(const EdfTaskSet* taskSet, uint64_t* busyPeriodFloor);
+static uint32_t _findMaxWcet(EdfTaskSetPtr taskSet, uint32_t taskIndex, uint64_t busyPeriodFloor);
+static uint32_t _findMinPeriod(EdfTaskSetPtr taskSet, uint32_t taskIndex, uint64_t busyPeriodFloor);
+static void _printHeadroomTable(const EdfTaskSet* taskSet, const EdfHeadroom headroom[]);
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	if(argc != 2){
+		fprintf(stderr, "Usage: %s <taskset file | ->\n", argv[0]);
+		return 2;
+	}
+
+	EdfTaskSet taskSet;
+	edf_initializeTaskSet(&taskSet);
+	if(!edf_loadTaskSet(argv[1], &taskSet)){
+		edf_freeTaskSet(&taskSet);
+		return 2;
+	}
+
+	// Sensitivity is only meaningful for a set that is feasible to begin with. Every probe has at least as much
+	// demand as the set itself, so its busy period floor seeds them all.
+	EdfResult result;
+	if(!edf_runQpa(&taskSet, &result)){
+		printf("The task set is not EDF-feasible; there is no headroom to report.\n");
+		edf_freeTaskSet(&taskSet);
+		return 1;
+	}
+
+	EdfHeadroomPtr headroom;
+	if(!(headroom = (EdfHeadroomPtr) malloc(sizeof(EdfHeadroom) * taskSet.Count))){
+		fprintf(stderr, "Unable to allocate memory for the headroom table.\n");
+		edf_freeTaskSet(&taskSet);
+		return 2;
+	}
+
+	clock_t start = clock();
+	for(uint32_t i=0; i<taskSet.Count; i++){
+		headroom[i].MaxWcet = _findMaxWcet(&taskSet, i, result.BusyPeriodFloor);
+		headroom[i].MinPeriod = _findMinPeriod(&taskSet, i, result.BusyPeriodFloor);
+	}
+	double elapsedMs = (double)(clock() - start) * 1000 / CLOCKS_PER_SEC;
+
+	_printHeadroomTable(&taskSet, headroom);
+	printf("\nAnalysis time: %.3f ms\n", elapsedMs);
+
+	free(headroom);
+	edf_freeTaskSet(&taskSet);
+	return 0;
+}
+
+/*=============================================================
+                        BINARY SEARCH
+ ==============================================================*/
+
+// Runs QPA on a probe, seeded with the busy period floor of a probe with no more demand. On success the floor is
+// raised to this probe's, ready for a probe with more demand still.
+static bool _isFeasible(const EdfTaskSet* taskSet, uint64_t* busyPeriodFloor){
+	if(edf_getUtilization(taskSet) > 1 - EDF_SENSITIVITY_MARGIN){
+		return false;
+	}
+
+	EdfResult result;
+	if(!edf_runQpaFrom(taskSet, *busyPeriodFloor, &result)){
+		return false;
+	}
+	*busyPeriodFloor = result.BusyPeriodFloor;
+	return true;
+}
+
+// Returns the largest WCET for the given task that keeps the set feasible. The task's WCET is restored before returning.
+static uint32_t _findMaxWcet(EdfTaskSetPtr taskSet, uint32_t taskIndex, uint64_t busyPeriodFloor){
+	EdfTaskPtr task = &taskSet->Tasks[taskIndex];
+	uint32_t originalWcet = task->Wcet;
+
+	// The WCET can grow by at most the spare utilization times the period (plus one tick to absorb rounding),
+	// and a job can never exceed its deadline
+	double spareUtilization = 1 - edf_getUtilization(taskSet);
+	uint64_t upper = originalWcet + (uint64_t)(spareUtilization * task->Period) + 1;
+	if(upper > task->Deadline){
+		upper = task->Deadline;
+	}
+
+	// Invariant: low is feasible, anything above high is not
+	uint32_t low = originalWcet;
+	uint32_t high = (upper < originalWcet) ? originalWcet : (uint32_t) upper;
+	while(low < high){
+		uint32_t middle = low + (high - low + 1) / 2;
+		task->Wcet = middle;
+		if(_isFeasible(taskSet, &busyPeriodFloor)){
+			low = middle;
+		}
+		else{
+			high = middle - 1;
+		}
+	}
+
+	task->Wcet = originalWcet;
+	return low;
+}
+
+// Returns the smallest period for the given task that keeps the set feasible. The task's period is restored before returning.
+static uint32_t _findMinPeriod(EdfTaskSetPtr taskSet, uint32_t taskIndex, uint64_t busyPeriodFloor){
+	EdfTaskPtr task = &taskSet->Tasks[taskIndex];
+	uint32_t originalPeriod = task->Period;
+
+	// The period cannot drop below the task's deadline, which the analysis requires it to be constrained by, nor
+	// below the point where the task alone would use all of the spare utilization
+	double otherUtilization = edf_getUtilization(taskSet) - (double) task->Wcet / task->Period;
+	uint32_t lower = (task->Deadline > task->Wcet) ? task->Deadline : task->Wcet;
+	if(otherUtilization < 1){
+		double utilizationBound = task->Wcet / (1 - otherUtilization);
+		if(utilizationBound > lower){
+			lower = (uint32_t) utilizationBound;
+		}
+	}
+
+	// Invariant: high is feasible, anything below low is not
+	uint32_t low = (lower > originalPeriod) ? originalPeriod : lower;
+	uint32_t high = originalPeriod;
+	while(low < high){
+		uint32_t middle = low + (high - low) / 2;
+		task->Period = middle;
+		if(_isFeasible(taskSet, &busyPeriodFloor)){
+			high = middle;
+		}
+		else{
+			low = middle + 1;
+		}
+	}
+
+	task->Period = originalPeriod;
+	return high;
+}
+
+/*=============================================================
+                           OUTPUT
+ ==============================================================*/
+
+static void _printHeadroomTable(const EdfTaskSet* taskSet, const EdfHeadroom headroom[]){
+	printf("%-*s %10s %10s %8s %10s %10s %8s\n", EDF_TASK_NAME_MAX,
+			"Template", "WCET", "Max WCET", "Scale", "Period", "Min Period", "Scale");
+	for(uint32_t i=0; i<taskSet->Count; i++){
+		const EdfTask* task = &taskSet->Tasks[i];
+		printf("%-*s %10u %10u %7.2fx %10u %10u %7.2fx\n", EDF_TASK_NAME_MAX, task->Name,
+				task->Wcet, headroom[i].MaxWcet, (double) headroom[i].MaxWcet / task->Wcet,
+				task->Period, headroom[i].MinPeriod, (double) headroom[i].MinPeriod / task->Period);
+	}
+}
@@ -0,0 +1,189 @@
+// Host simulation of deadline enforcement by Sources/Scheduler/deadlineTimer.c.
+//
+// Build (host):  gcc -std=c99 -O2 -Istubs -I../../Sources/Scheduler -o deadlineTimerTest deadlineTimerTest.c ../../Sources/Scheduler/deadlineTimer.c
+// Usage:         deadlineTimerTest [trial count]
+//
+// Arms the timer for random tick-aligned and sub-tick deadlines, from random points within the current tick,
+// then drives the tick interrupt the way the kernel does: the tick count is advanced first, and the lightweight
+// timer queues are serviced after. Reports the enforcement latency and exits non-zero if any deadline was
+// enforced early, or more than one tick late.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "deadlineTimer.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define SIM_TICKS_PER_SEC 200					// BSP_ALARM_FREQUENCY
+#define SIM_HW_TICKS_PER_TICK 600000			// 120 MHz SysTick clock
+#define SIM_US_PER_TICK (1000000 / SIM_TICKS_PER_SEC)
+#define SIM_MAX_DEADLINE_TICKS 40
+#define SIM_DEFAULT_TRIALS 100000
+
+/*=============================================================
+                    SIMULATED KERNEL STATE
+ ==============================================================*/
+
+static uint64_t g_Ticks;							// Whole ticks since start
+static uint32_t g_HwTicks;							// Hardware ticks into the current tick
+static LWTIMER_PERIOD_STRUCT_PTR g_TimerQueue;		// The registered timer queue, or NULL
+static _task_id g_DemotedTaskId;					// The last job the timer demoted
+static _task_id g_NotifiedTaskId;					// The last job the scheduler was told about
+static SchedulerMessage g_Message;
+
+/*=============================================================
+                      SIMULATED KERNEL
+ ==============================================================*/
+
+void _int_disable(void){}
+void _int_enable(void){}
+
+void _task_block(void){
+	printf("FAIL: the module under test blocked\n");
+	exit(1);
+}
+
+_mqx_uint _task_set_priority(_task_id taskId, _mqx_uint newPriority, _mqx_uint* oldPriority){
+	g_DemotedTaskId = taskId;
+	*oldPriority = DEFAULT_TASK_PRIORITY;
+	return MQX_OK;
+}
+
+void _time_get_ticks(MQX_TICK_STRUCT_PTR ticks){
+	ticks->TICKS[0] = (_mqx_uint) g_Ticks;
+	ticks->TICKS[1] = (_mqx_uint)(g_Ticks >> 32);
+	ticks->HW_TICKS = g_HwTicks;
+}
+
+_mqx_uint _time_get_ticks_per_sec(void){
+	return SIM_TICKS_PER_SEC;
+}
+
+int32_t _time_diff_microseconds(MQX_TICK_STRUCT_PTR end, MQX_TICK_STRUCT_PTR start, bool* overflow){
+	int64_t endHw = (int64_t)((((uint64_t) end->TICKS[1] << 32) | end->TICKS[0]) * SIM_HW_TICKS_PER_TICK + end->HW_TICKS);
+	int64_t startHw = (int64_t)((((uint64_t) start->TICKS[1] << 32) | start->TICKS[0]) * SIM_HW_TICKS_PER_TICK + start->HW_TICKS);
+	int64_t us = (endHw - startHw) * SIM_US_PER_TICK / SIM_HW_TICKS_PER_TICK;
+	*overflow = (us > INT32_MAX || us < INT32_MIN);
+	return (int32_t) us;
+}
+
+void* _msg_alloc(_pool_id pool){
+	return &g_Message;
+}
+
+bool _msgq_send_urgent(void* message){
+	g_NotifiedTaskId = ((DeadlineExpiredMessagePtr) message)->TaskId;
+	return TRUE;
+}
+
+_mqx_uint _lwtimer_create_periodic_queue(LWTIMER_PERIOD_STRUCT_PTR period, _mqx_uint periodTicks, _mqx_uint waitTicks){
+	period->PERIOD = periodTicks;
+	period->EXPIRY = 0;
+	period->WAIT = waitTicks;
+	period->TIMER = NULL;
+	g_TimerQueue = period;
+	return MQX_OK;
+}
+
+_mqx_uint _lwtimer_add_timer_to_queue(LWTIMER_PERIOD_STRUCT_PTR period, LWTIMER_STRUCT_PTR timer, _mqx_uint ticks,
+		LWTIMER_ISR_FPTR function, void* parameter){
+	timer->RELATIVE_TICKS = ticks;
+	timer->TIMER_FUNCTION = function;
+	timer->PARAMETER = parameter;
+	period->TIMER = timer;
+	return MQX_OK;
+}
+
+_mqx_uint _lwtimer_cancel_period(LWTIMER_PERIOD_STRUCT_PTR period){
+	if(g_TimerQueue == period){
+		g_TimerQueue = NULL;
+	}
+	return MQX_OK;
+}
+
+// Mirrors _time_notify_kernel: the tick count advances before _lwtimer_isr_internal services the queues
+static void _simulateTickInterrupt(){
+	g_Ticks++;
+	g_HwTicks = 0;
+
+	LWTIMER_PERIOD_STRUCT_PTR period = g_TimerQueue;
+	if(period == NULL){
+		return;
+	}
+	if(period->WAIT){
+		--period->WAIT;
+		return;
+	}
+	if(period->TIMER != NULL && period->TIMER->RELATIVE_TICKS <= period->EXPIRY){
+		(*period->TIMER->TIMER_FUNCTION)(period->TIMER->PARAMETER);
+	}
+	if(++period->EXPIRY == period->PERIOD){
+		period->EXPIRY = 0;
+	}
+}
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	uint32_t trialCount = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 10) : SIM_DEFAULT_TRIALS;
+	srand(1);
+
+	initializeDeadlineTimer(1, NULL);
+	g_Ticks = 1000;
+	bool isPassing = true;
+
+	for(uint32_t trial = 0; trial < trialCount; trial++){
+		// Arm from a random point within the current tick, for a deadline that has not passed yet
+		g_HwTicks = (uint32_t) rand() % SIM_HW_TICKS_PER_TICK;
+		uint64_t deadlineTicks = g_Ticks + (uint64_t)(rand() % SIM_MAX_DEADLINE_TICKS);
+		uint32_t deadlineHwTicks = (rand() % 2 == 0) ? 0 : (uint32_t) rand() % SIM_HW_TICKS_PER_TICK;
+		if(deadlineTicks == g_Ticks && deadlineHwTicks <= g_HwTicks){
+			deadlineTicks++;
+		}
+
+		SchedulerTask task;
+		memset(&task, 0, sizeof(SchedulerTask));
+		task.TaskId = trial + 1;
+		task.Deadline.TICKS[0] = (_mqx_uint) deadlineTicks;
+		task.Deadline.TICKS[1] = (_mqx_uint)(deadlineTicks >> 32);
+		task.Deadline.HW_TICKS = deadlineHwTicks;
+		armDeadlineTimer(&task);
+
+		uint32_t ticksRun = 0;
+		while(g_NotifiedTaskId != task.TaskId && ticksRun <= SIM_MAX_DEADLINE_TICKS + 1){
+			_simulateTickInterrupt();
+			ticksRun++;
+		}
+		if(g_NotifiedTaskId != task.TaskId || g_DemotedTaskId != task.TaskId){
+			printf("FAIL: trial %u was never enforced\n", trial);
+			isPassing = false;
+			break;
+		}
+		disarmDeadlineTimer();
+	}
+
+	DeadlineTimerStats stats;
+	getDeadlineTimerStats(&stats);
+	int32_t averageLatency = (stats.Expirations == 0) ? 0 : (int32_t)(stats.TotalLatencyUs / stats.Expirations);
+	printf("Deadlines enforced: %u, latency min/avg/max: %d/%d/%d us (tick %d us), early: %u, dropped: %u\n",
+			stats.Expirations, stats.MinLatencyUs, averageLatency, stats.MaxLatencyUs, SIM_US_PER_TICK,
+			stats.EarlyCount, stats.DroppedNotifications);
+
+	if(stats.EarlyCount > 0 || stats.MinLatencyUs < 0){
+		printf("FAIL: deadlines were enforced before they were reached\n");
+		isPassing = false;
+	}
+	if(stats.MaxLatencyUs > SIM_US_PER_TICK){
+		printf("FAIL: deadlines were enforced more than one tick late\n");
+		isPassing = false;
+	}
+
+	printf(isPassing ? "PASS\n" : "FAIL\n");
+	return isPassing ? 0 : 1;
+}
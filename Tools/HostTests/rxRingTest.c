@@ -0,0 +1,171 @@
+// Host simulation of the terminal receive path at 115200 baud, using Sources/TerminalDriver/rxRing.c.
+//
+// Build (host):  gcc -std=c99 -O2 -Istubs -I../../Sources/TerminalDriver -o rxRingTest rxRingTest.c ../../Sources/TerminalDriver/rxRing.c
+// Usage:         rxRingTest [simulated seconds]
+//
+// A sender streams characters at the line rate (11520 per second at 8N1) into the receive interrupt, which
+// fills the ring and wakes the handler task when the ring goes from empty to non-empty. The handler drains the
+// ring at a fixed cost per character after a wakeup latency, and can be held off the CPU for a burst of
+// higher-priority work. Flow control follows the handler's water marks: XOFF at RX_RING_HIGH_WATER, XON at
+// RX_RING_LOW_WATER, with the sender stopping a FIFO's worth of characters after XOFF.
+// Reports throughput and drops per scenario, and exits non-zero if a scenario that should not drop does.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "rxRing.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define SIM_BAUD_RATE 115200
+#define SIM_BITS_PER_CHARACTER 10							// Start, 8 data and stop bits
+#define SIM_CHARACTER_NS (1000000000ull * SIM_BITS_PER_CHARACTER / SIM_BAUD_RATE)
+#define SIM_STEP_NS 1000ull
+#define SIM_DEFAULT_SECONDS 10
+#define SIM_SENDER_FIFO_CHARACTERS 16						// Characters a sender still sends after XOFF arrives
+#define SIM_WAKEUP_NS 20000ull								// From the ring event to the handler running
+#define SIM_CHARACTER_COST_NS 3000ull						// Handler time per character: line editing and echo
+
+/*=============================================================
+                      EXPORTED TYPES
+ ==============================================================*/
+
+// Defines one run of the simulation
+typedef struct Scenario{
+	const char* Name;
+	bool IsFlowControlled;
+	uint64_t StallPeriodNs;				// The handler is held off the CPU for StallNs every StallPeriodNs, or never if 0
+	uint64_t StallNs;
+	bool MayDrop;						// Whether the scenario is expected to lose characters
+} Scenario;
+
+typedef enum HandlerState{
+	HANDLER_WAITING,					// Blocked on the ring event
+	HANDLER_WAKING,						// Made ready by the event, not yet running
+	HANDLER_RUNNING
+} HandlerState;
+
+/*=============================================================
+                      SIMULATED KERNEL
+ ==============================================================*/
+
+void _int_disable(void){}
+void _int_enable(void){}
+
+/*=============================================================
+                         SIMULATION
+ ==============================================================*/
+
+static bool _runScenario(const Scenario* scenario, uint32_t seconds){
+	RxRing ring;
+	_initializeRxRing(&ring);
+
+	uint64_t endNs = (uint64_t) seconds * 1000000000ull;
+	uint64_t nextCharacterNs = 0;
+	uint32_t sentCount = 0;
+	uint32_t handledCount = 0;
+	int32_t sendsBeforeStop = -1;		// Characters still in the sender's FIFO after XOFF, or -1 while not stopping
+	bool isSenderStopped = false;
+	HandlerState handlerState = HANDLER_WAITING;
+	uint64_t handlerReadyNs = 0;
+	uint64_t characterDoneNs = 0;
+
+	for(uint64_t now = 0; now < endNs; now += SIM_STEP_NS){
+		// The receive interrupt, as _handleUartCharacterReceived
+		if(!isSenderStopped && now >= nextCharacterNs){
+			nextCharacterNs += SIM_CHARACTER_NS;
+			sentCount++;
+			bool wasEmpty;
+			if(_putRxRingCharacter(&ring, (uint8_t) sentCount, &wasEmpty) && wasEmpty && handlerState == HANDLER_WAITING){
+				handlerState = HANDLER_WAKING;
+				handlerReadyNs = now + SIM_WAKEUP_NS;
+			}
+			if(scenario->IsFlowControlled && !ring.isThrottled && _getRxRingOccupancy(&ring) >= RX_RING_HIGH_WATER){
+				ring.isThrottled = true;
+				ring.throttleCount++;
+				sendsBeforeStop = SIM_SENDER_FIFO_CHARACTERS;
+			}
+			if(sendsBeforeStop >= 0 && sendsBeforeStop-- == 0){
+				isSenderStopped = true;
+			}
+		}
+
+		// The handler task, unless higher-priority work holds it off
+		bool isStalled = scenario->StallPeriodNs != 0 && now % scenario->StallPeriodNs < scenario->StallNs;
+		if(isStalled){
+			if(handlerState == HANDLER_RUNNING){
+				characterDoneNs += SIM_STEP_NS;
+			}
+			continue;
+		}
+		if(handlerState == HANDLER_WAKING && now >= handlerReadyNs){
+			handlerState = HANDLER_RUNNING;
+			characterDoneNs = now + SIM_CHARACTER_COST_NS;
+		}
+		while(handlerState == HANDLER_RUNNING && now >= characterDoneNs){
+			uint8_t character;
+			if(!_getRxRingCharacter(&ring, &character)){
+				handlerState = HANDLER_WAITING;
+				break;
+			}
+			handledCount++;
+			characterDoneNs += SIM_CHARACTER_COST_NS;
+
+			// As _resumeThrottledSender; the sender restarts once XON reaches it
+			if(ring.isThrottled && _getRxRingOccupancy(&ring) <= RX_RING_LOW_WATER){
+				ring.isThrottled = false;
+				ring.resumeCount++;
+				sendsBeforeStop = -1;
+				if(isSenderStopped){
+					isSenderStopped = false;
+					nextCharacterNs = now + 2 * SIM_CHARACTER_NS;
+				}
+			}
+		}
+	}
+
+	uint32_t lineRate = (uint32_t)(1000000000ull / SIM_CHARACTER_NS);
+	printf("%-36s sent %u, handled %u (%u/s of %u/s line rate), dropped %u, max backlog %u of %u, XOFF %u\n",
+			scenario->Name, sentCount, handledCount, handledCount / seconds, lineRate, ring.droppedCount,
+			ring.maxOccupancy, RX_RING_SIZE, ring.throttleCount);
+
+	if(!scenario->MayDrop && ring.droppedCount > 0){
+		printf("FAIL: %s dropped characters\n", scenario->Name);
+		return false;
+	}
+	if(!scenario->IsFlowControlled && scenario->StallPeriodNs == 0 && handledCount < (uint64_t) lineRate * seconds * 99 / 100){
+		printf("FAIL: %s did not keep up with the line rate\n", scenario->Name);
+		return false;
+	}
+	return true;
+}
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	uint32_t seconds = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 10) : SIM_DEFAULT_SECONDS;
+	if(seconds == 0){
+		seconds = 1;
+	}
+
+	// The ring holds 256 characters, 22 ms at the line rate, so a 30 ms stall overruns it without flow control
+	static const Scenario scenarios[] = {
+		{ "Unloaded handler",                  false, 0,          0,         false },
+		{ "10 ms stalls every 100 ms",         false, 100000000,  10000000,  false },
+		{ "30 ms stalls every 100 ms",         false, 100000000,  30000000,  true },
+		{ "30 ms stalls every 100 ms, XON/XOFF", true, 100000000, 30000000, false },
+	};
+
+	bool isPassing = true;
+	for(uint32_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++){
+		isPassing = _runScenario(&scenarios[i], seconds) && isPassing;
+	}
+
+	printf(isPassing ? "PASS\n" : "FAIL\n");
+	return isPassing ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+// Host simulation of the create request path through Sources/Scheduler/scheduler.c.
+//
+// Build (host):  gcc -std=c99 -O2 -Istubs -I../../Sources/Scheduler -o schedulerTest schedulerTest.c ../../Sources/Scheduler/scheduler.c ../../Sources/Scheduler/templateRegistry.c
+// Usage:         schedulerTest
+//
+// Registers two job templates, then creates jobs through each of the dd_tcreate variants. The request queue is
+// served synchronously, the way the scheduler task would serve it, and the task manager is replaced by one that
+// records each request it is handed. Exits non-zero if a job does not reach the task manager with the deadline
+// and argument it was created with, or with its template's defaults where it was created without them, or if
+// the deadline backstop does not carry into the high tick word when the low word wraps.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "scheduler.h"
+#include "taskManagement.h"
+#include "deadlineTimer.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define SIM_TICKS_PER_SEC 200					// BSP_ALARM_FREQUENCY
+#define SIM_REQUEST_QUEUE 8
+#define SIM_QUEUE_COUNT (MAX_RESPONSE_QUEUE_ID + 1)
+
+/*=============================================================
+                    SIMULATED KERNEL STATE
+ ==============================================================*/
+
+static void* g_PendingMessages[SIM_QUEUE_COUNT];	// The message waiting on each open queue, or NULL
+static bool g_IsQueueOpen[SIM_QUEUE_COUNT];
+static uint32_t g_AllocatedMessages;				// Messages allocated and not yet freed
+static _task_id g_NextTaskId = 1;
+static MQX_TICK_STRUCT g_NextDeadline;				// The deadline the task manager reports for its current job
+
+// The last request the task manager was handed
+static struct{
+	uint32_t TemplateIndex;
+	uint32_t TicksToDeadline;
+	uint32_t MicrosecondsToDeadline;
+	uint32_t Argument;
+} g_LastCreate;
+
+/*=============================================================
+                      SIMULATED KERNEL
+ ==============================================================*/
+
+void _int_disable(void){}
+void _int_enable(void){}
+
+void _task_block(void){
+	printf("FAIL: the module under test blocked\n");
+	exit(1);
+}
+
+_task_id _task_get_id(void){
+	return MQX_NULL_TASK_ID;
+}
+
+void _time_get_ticks(MQX_TICK_STRUCT_PTR ticks){
+	memset(ticks, 0, sizeof(MQX_TICK_STRUCT));
+}
+
+_mqx_uint _time_get_ticks_per_sec(void){
+	return SIM_TICKS_PER_SEC;
+}
+
+int32_t _time_diff_ticks_int32(MQX_TICK_STRUCT_PTR end, MQX_TICK_STRUCT_PTR start, bool* overflow){
+	*overflow = false;
+	return (int32_t)(end->TICKS[0] - start->TICKS[0]);
+}
+
+_pool_id _msgpool_create(uint16_t messageSize, uint16_t initialCount, uint16_t growCount, uint16_t maxCount){
+	return (_pool_id) &g_AllocatedMessages;
+}
+
+void* _msg_alloc(_pool_id pool){
+	g_AllocatedMessages++;
+	return malloc(sizeof(SchedulerMessage));
+}
+
+void _msg_free(void* message){
+	g_AllocatedMessages--;
+	free(message);
+}
+
+_queue_id _msgq_open(_mqx_uint queueNumber, uint16_t maxSize){
+	if(queueNumber >= SIM_QUEUE_COUNT || g_IsQueueOpen[queueNumber]){
+		return MSGQ_NULL_QUEUE_ID;
+	}
+	g_IsQueueOpen[queueNumber] = true;
+	return (_queue_id) queueNumber;
+}
+
+bool _msgq_close(_queue_id queue){
+	g_IsQueueOpen[queue] = false;
+	return TRUE;
+}
+
+// Responses wait on their queue until the requesting task receives them
+bool _msgq_send(void* message){
+	_queue_id target = ((MESSAGE_HEADER_STRUCT_PTR) message)->TARGET_QID;
+	if(target >= SIM_QUEUE_COUNT || !g_IsQueueOpen[target] || g_PendingMessages[target] != NULL){
+		return FALSE;
+	}
+	g_PendingMessages[target] = message;
+	return TRUE;
+}
+
+// Requests are served at once, as if the scheduler task preempted the requesting task
+bool _msgq_send_priority(void* message, _mqx_uint priority){
+	if(((MESSAGE_HEADER_STRUCT_PTR) message)->TARGET_QID != SIM_REQUEST_QUEUE){
+		return FALSE;
+	}
+	_handleSchedulerRequest((SchedulerRequestMessagePtr) message);
+	_msg_free(message);
+	return TRUE;
+}
+
+void* _msgq_receive(_queue_id queue, uint32_t timeoutMs){
+	void* message = g_PendingMessages[queue];
+	g_PendingMessages[queue] = NULL;
+	return message;
+}
+
+_mqx_uint _msgq_get_count(_queue_id queue){
+	return 0;
+}
+
+_mqx_uint _mutatr_init(MUTEX_ATTR_STRUCT_PTR attributes){
+	return MQX_OK;
+}
+
+_mqx_uint _mutex_init(MUTEX_STRUCT_PTR mutex, MUTEX_ATTR_STRUCT_PTR attributes){
+	return MQX_OK;
+}
+
+_mqx_uint _mutex_lock(MUTEX_STRUCT_PTR mutex){
+	return MQX_OK;
+}
+
+_mqx_uint _mutex_unlock(MUTEX_STRUCT_PTR mutex){
+	return MQX_OK;
+}
+
+/*=============================================================
+                 SIMULATED SCHEDULER MODULES
+ ==============================================================*/
+
+bool Log(const char* format, ...){
+	return true;
+}
+
+void initializeDeadlineTimer(_queue_id requestQueue, _pool_id messagePool){}
+
+void initializeTaskManager(){}
+
+_task_id createTask(uint32_t templateIndex, uint32_t ticksToDeadline, uint32_t argument){
+	g_LastCreate.TemplateIndex = templateIndex;
+	g_LastCreate.TicksToDeadline = ticksToDeadline;
+	g_LastCreate.MicrosecondsToDeadline = 0;
+	g_LastCreate.Argument = argument;
+	return g_NextTaskId++;
+}
+
+_task_id createTaskWithMicrosecondDeadline(uint32_t templateIndex, uint32_t microsecondsToDeadline, uint32_t argument){
+	g_LastCreate.TemplateIndex = templateIndex;
+	g_LastCreate.TicksToDeadline = 0;
+	g_LastCreate.MicrosecondsToDeadline = microsecondsToDeadline;
+	g_LastCreate.Argument = argument;
+	return g_NextTaskId++;
+}
+
+_task_id setCurrentTaskAsOverdue(){
+	return MQX_NULL_TASK_ID;
+}
+
+_task_id setTaskAsOverdue(_task_id taskId){
+	return MQX_NULL_TASK_ID;
+}
+
+bool deleteTask(_task_id taskId){
+	return false;
+}
+
+TaskList getCopyOfActiveTasks(){
+	return NULL;
+}
+
+TaskList getCopyOfOverdueTasks(){
+	return NULL;
+}
+
+bool getNextTaskDeadline(MQX_TICK_STRUCT_PTR deadline){
+	*deadline = g_NextDeadline;
+	return true;
+}
+
+void getTaskHealthStats(SchedulerHealthStatsPtr stats){
+	memset(stats, 0, sizeof(SchedulerHealthStats));
+}
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+static void _simulatedJob(uint32_t argument){}
+
+// Checks that the last job reached the task manager as expected
+static bool _isLastCreate(const char* description, _task_id taskId, uint32_t templateIndex, uint32_t ticksToDeadline,
+		uint32_t microsecondsToDeadline, uint32_t argument){
+	bool isExpected = taskId != MQX_NULL_TASK_ID
+			&& g_LastCreate.TemplateIndex == templateIndex
+			&& g_LastCreate.TicksToDeadline == ticksToDeadline
+			&& g_LastCreate.MicrosecondsToDeadline == microsecondsToDeadline
+			&& g_LastCreate.Argument == argument;
+	printf("%-36s deadline %u ticks / %u us, argument %u%s\n", description, g_LastCreate.TicksToDeadline,
+			g_LastCreate.MicrosecondsToDeadline, g_LastCreate.Argument, isExpected ? "" : " (unexpected)");
+	return isExpected;
+}
+
+int main(int argc, char* argv[]){
+	TaskTemplateInfo sensorInfo = { "Sensor", _simulatedJob, PSP_MINSTACKSIZE, 11, 1000, 40, 0, MISS_POLICY_ABORT };
+	TaskTemplateInfo loggerInfo = { "Logger", _simulatedJob, PSP_MINSTACKSIZE, 22, 1000, 60, 0, MISS_POLICY_ABORT };
+	uint32_t sensor = (uint32_t) dd_register_template(&sensorInfo);
+	uint32_t logger = (uint32_t) dd_register_template(&loggerInfo);
+	_initializeScheduler(SIM_REQUEST_QUEUE);
+
+	bool isPassing = true;
+	isPassing &= _isLastCreate("dd_tcreate", dd_tcreate(sensor, 5), sensor, 5, 0, 11);
+	isPassing &= _isLastCreate("dd_tcreate, default deadline", dd_tcreate(logger, 0), logger, 60, 0, 22);
+	isPassing &= _isLastCreate("dd_tcreate_us", dd_tcreate_us(logger, 2500), logger, 0, 2500, 22);
+	isPassing &= _isLastCreate("dd_tcreate_arg", dd_tcreate_arg(sensor, 5, 0xA5A5A5A5), sensor, 5, 0, 0xA5A5A5A5);
+	isPassing &= _isLastCreate("dd_tcreate_arg, argument 0", dd_tcreate_arg(logger, 5, 0), logger, 5, 0, 0);
+	isPassing &= _isLastCreate("dd_tcreate_arg, default deadline", dd_tcreate_arg(sensor, 0, 7), sensor, 40, 0, 7);
+	isPassing &= _isLastCreate("dd_tcreate_us_arg", dd_tcreate_us_arg(logger, 2500, 8), logger, 0, 2500, 8);
+	isPassing &= _isLastCreate("dd_tcreate_us_arg, default deadline", dd_tcreate_us_arg(logger, 0, 9), logger, 60, 0, 9);
+
+	// The backstop falls a few ticks after a deadline just short of the low tick word wrapping
+	MQX_TICK_STRUCT backstop;
+	g_NextDeadline.TICKS[0] = UINT32_MAX;
+	g_NextDeadline.TICKS[1] = 1;
+	_getDeadlineBackstop(&backstop);
+	uint64_t expectedBackstop = ((uint64_t) 1 << 32) + UINT32_MAX + DEADLINE_BACKSTOP_GRACE_TICKS;
+	uint64_t actualBackstop = ((uint64_t) backstop.TICKS[1] << 32) | backstop.TICKS[0];
+	printf("%-36s deadline 0x%08X%08X, backstop 0x%08X%08X\n", "_getDeadlineBackstop across a wrap",
+			g_NextDeadline.TICKS[1], g_NextDeadline.TICKS[0], backstop.TICKS[1], backstop.TICKS[0]);
+	if(actualBackstop != expectedBackstop){
+		printf("FAIL: the backstop did not carry into the high tick word\n");
+		isPassing = false;
+	}
+
+	if(g_AllocatedMessages != 0){
+		printf("FAIL: %u messages were not freed\n", g_AllocatedMessages);
+		isPassing = false;
+	}
+
+	printf(isPassing ? "PASS\n" : "FAIL\n");
+	return isPassing ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+// Host stand-in for the KSDK UART driver header
+
+#include <stddef.h>
+#include "mqx.h"
+
+#ifndef HOSTTESTS_STUBS_FSL_UART_DRIVER_H_
+#define HOSTTESTS_STUBS_FSL_UART_DRIVER_H_
+
+typedef enum _uart_status{
+	kStatus_UART_Success = 0,
+	kStatus_UART_TxBusy = 3
+} uart_status_t;
+
+typedef struct UartState{
+	const uint8_t* txBuff;
+	volatile size_t txSize;
+	volatile bool isTxBusy;
+} uart_state_t;
+
+uart_status_t UART_DRV_SendData(uint32_t instance, const uint8_t* txBuff, uint32_t txSize);
+
+#endif
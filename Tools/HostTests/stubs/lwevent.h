@@ -0,0 +1,12 @@
+// Host stand-in for the MQX lightweight event header
+
+#include "mqx.h"
+
+#ifndef HOSTTESTS_STUBS_LWEVENT_H_
+#define HOSTTESTS_STUBS_LWEVENT_H_
+
+typedef struct lwevent_struct{
+	_mqx_uint VALUE;
+} LWEVENT_STRUCT, * LWEVENT_STRUCT_PTR;
+
+#endif
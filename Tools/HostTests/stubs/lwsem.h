@@ -0,0 +1,16 @@
+// Host stand-in for the MQX lightweight semaphore header
+
+#include "mqx.h"
+
+#ifndef HOSTTESTS_STUBS_LWSEM_H_
+#define HOSTTESTS_STUBS_LWSEM_H_
+
+typedef struct lwsem_struct{
+	_mqx_int VALUE;
+} LWSEM_STRUCT, * LWSEM_STRUCT_PTR;
+
+_mqx_uint _lwsem_create(LWSEM_STRUCT_PTR semaphore, _mqx_int initialCount);
+_mqx_uint _lwsem_post(LWSEM_STRUCT_PTR semaphore);
+_mqx_uint _lwsem_wait(LWSEM_STRUCT_PTR semaphore);
+
+#endif
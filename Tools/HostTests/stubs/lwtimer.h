@@ -0,0 +1,28 @@
+// Host stand-in for the MQX lightweight timer header
+
+#include "mqx.h"
+
+#ifndef HOSTTESTS_STUBS_LWTIMER_H_
+#define HOSTTESTS_STUBS_LWTIMER_H_
+
+typedef void (*LWTIMER_ISR_FPTR)(void*);
+
+typedef struct lwtimer_struct{
+	_mqx_uint RELATIVE_TICKS;
+	LWTIMER_ISR_FPTR TIMER_FUNCTION;
+	void* PARAMETER;
+} LWTIMER_STRUCT, * LWTIMER_STRUCT_PTR;
+
+typedef struct lwtimer_period_struct{
+	_mqx_uint PERIOD;
+	_mqx_uint EXPIRY;
+	_mqx_uint WAIT;
+	LWTIMER_STRUCT_PTR TIMER;			// The simulation supports one timer per queue
+} LWTIMER_PERIOD_STRUCT, * LWTIMER_PERIOD_STRUCT_PTR;
+
+_mqx_uint _lwtimer_create_periodic_queue(LWTIMER_PERIOD_STRUCT_PTR period, _mqx_uint periodTicks, _mqx_uint waitTicks);
+_mqx_uint _lwtimer_add_timer_to_queue(LWTIMER_PERIOD_STRUCT_PTR period, LWTIMER_STRUCT_PTR timer, _mqx_uint ticks,
+		LWTIMER_ISR_FPTR function, void* parameter);
+_mqx_uint _lwtimer_cancel_period(LWTIMER_PERIOD_STRUCT_PTR period);
+
+#endif
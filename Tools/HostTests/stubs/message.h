@@ -0,0 +1,34 @@
+// Host stand-in for the MQX message header
+
+#include "mqx.h"
+
+#ifndef HOSTTESTS_STUBS_MESSAGE_H_
+#define HOSTTESTS_STUBS_MESSAGE_H_
+
+#define MSGQ_NULL_QUEUE_ID ((_queue_id) 0)
+#define MSG_MAX_PRIORITY (0xF)
+#define MSGPOOL_NULL_POOL_ID ((_pool_id) 0)
+
+typedef void* _pool_id;
+typedef uint32_t _queue_id;
+
+typedef struct message_header_struct{
+	uint32_t SIZE;
+	_queue_id TARGET_QID;
+	_queue_id SOURCE_QID;
+	uint8_t CONTROL;
+	uint8_t RESERVED;
+} MESSAGE_HEADER_STRUCT, * MESSAGE_HEADER_STRUCT_PTR;
+
+_pool_id _msgpool_create(uint16_t messageSize, uint16_t initialCount, uint16_t growCount, uint16_t maxCount);
+void* _msg_alloc(_pool_id pool);
+void _msg_free(void* message);
+_queue_id _msgq_open(_mqx_uint queueNumber, uint16_t maxSize);
+bool _msgq_close(_queue_id queue);
+bool _msgq_send(void* message);
+bool _msgq_send_priority(void* message, _mqx_uint priority);
+bool _msgq_send_urgent(void* message);
+void* _msgq_receive(_queue_id queue, uint32_t timeoutMs);
+_mqx_uint _msgq_get_count(_queue_id queue);
+
+#endif
@@ -0,0 +1,53 @@
+// Host stand-in for the MQX kernel header. Declares just the types and calls the firmware modules under test
+// use; each host test defines the calls itself, simulating the kernel behaviour it needs.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef HOSTTESTS_STUBS_MQX_H_
+#define HOSTTESTS_STUBS_MQX_H_
+
+#define TRUE 1
+#define FALSE 0
+
+#define MQX_OK 0
+#define MQX_NULL_TASK_ID ((_task_id) 0)
+#define MQXCFG_LOWEST_TASK_PRIORITY 30
+#define PSP_MINSTACKSIZE 256
+
+typedef uint32_t _mqx_uint;
+typedef int32_t _mqx_int;
+typedef uint32_t _task_id;
+
+typedef void (*TASK_FPTR)(uint32_t);
+
+typedef struct task_template_struct{
+	_mqx_uint TASK_TEMPLATE_INDEX;
+	TASK_FPTR TASK_ADDRESS;
+	_mqx_uint TASK_STACKSIZE;
+	_mqx_uint TASK_PRIORITY;
+	char* TASK_NAME;
+	_mqx_uint TASK_ATTRIBUTES;
+	uint32_t CREATION_PARAMETER;
+	_mqx_uint DEFAULT_TIME_SLICE;
+} TASK_TEMPLATE_STRUCT, * TASK_TEMPLATE_STRUCT_PTR;
+
+typedef struct mqx_tick_struct{
+	_mqx_uint TICKS[2];
+	uint32_t HW_TICKS;
+} MQX_TICK_STRUCT, * MQX_TICK_STRUCT_PTR;
+
+void _int_disable(void);
+void _int_enable(void);
+void _task_block(void);
+_task_id _task_get_id(void);
+_mqx_uint _task_set_priority(_task_id taskId, _mqx_uint newPriority, _mqx_uint* oldPriority);
+
+void _time_get_ticks(MQX_TICK_STRUCT_PTR ticks);
+_mqx_uint _time_get_ticks_per_sec(void);
+int32_t _time_diff_microseconds(MQX_TICK_STRUCT_PTR end, MQX_TICK_STRUCT_PTR start, bool* overflow);
+int32_t _time_diff_ticks_int32(MQX_TICK_STRUCT_PTR end, MQX_TICK_STRUCT_PTR start, bool* overflow);
+
+#endif
@@ -0,0 +1,21 @@
+// Host stand-in for the MQX mutex header
+
+#include "mqx.h"
+
+#ifndef HOSTTESTS_STUBS_MUTEX_H_
+#define HOSTTESTS_STUBS_MUTEX_H_
+
+typedef struct mutex_struct{
+	_task_id OWNER;
+} MUTEX_STRUCT, * MUTEX_STRUCT_PTR;
+
+typedef struct mutex_attr_struct{
+	_mqx_uint SCHED_PROTOCOL;
+} MUTEX_ATTR_STRUCT, * MUTEX_ATTR_STRUCT_PTR;
+
+_mqx_uint _mutatr_init(MUTEX_ATTR_STRUCT_PTR attributes);
+_mqx_uint _mutex_init(MUTEX_STRUCT_PTR mutex, MUTEX_ATTR_STRUCT_PTR attributes);
+_mqx_uint _mutex_lock(MUTEX_STRUCT_PTR mutex);
+_mqx_uint _mutex_unlock(MUTEX_STRUCT_PTR mutex);
+
+#endif
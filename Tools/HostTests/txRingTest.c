@@ -0,0 +1,267 @@
+// Host simulation of the interrupt-driven transmit ring in Sources/TerminalDriver/txRing.c.
+//
+// Build (host):  gcc -std=c99 -O2 -Istubs -I../../Sources/TerminalDriver -o txRingTest txRingTest.c ../../Sources/TerminalDriver/txRing.c
+// Usage:         txRingTest
+//
+// The UART is modelled the way the KSDK driver runs the transmit interrupt: each interrupt puts the character
+// at txBuff on the wire and calls the ring's callback, and the transfer completes once the callback sets txSize
+// to 0. Interrupts are taken whenever the code under test re-enables them, and whenever a writer blocks.
+// A receive interrupt toggling XON/XOFF can also be taken at those points, while a binary frame is sent.
+// Exits non-zero if the characters on the wire differ from those written, or a flow control character lands
+// inside a frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "txRing.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define SIM_WIRE_MAX (16 * TX_RING_SIZE)
+#define SIM_FRAME_ROUNDS 200
+
+/*=============================================================
+                    SIMULATED KERNEL STATE
+ ==============================================================*/
+
+static uart_state_t g_UartState;
+static TxRing g_Ring;
+static uint8_t g_Wire[SIM_WIRE_MAX];			// Every character the UART has sent
+static bool g_IsWireControl[SIM_WIRE_MAX];		// Whether each character sent was a flow control character
+static uint32_t g_WireCount;
+static bool g_IsInInterrupt;
+static uint32_t g_InterruptPercent = 30;		// The chance a transmit interrupt is taken when interrupts are re-enabled
+static uint32_t g_ControlPercent = 0;			// The chance a receive interrupt sends XON or XOFF at the same points
+static bool g_IsThrottled;
+static uint32_t g_ControlCount;					// Flow control characters requested
+static uint32_t g_WriterBlockCount;				// The number of times a writer waited on a full ring
+static uint32_t g_MaxCount;						// The most characters seen queued in the ring
+
+/*=============================================================
+                      SIMULATED KERNEL
+ ==============================================================*/
+
+static bool _simulateTxInterrupt();
+static void _simulateRxInterrupt();
+
+void _int_disable(void){}
+
+// Pending interrupts are taken as soon as interrupts are enabled again
+void _int_enable(void){
+	if(g_IsInInterrupt){
+		return;
+	}
+	if(rand() % 100 < (int) g_ControlPercent){
+		_simulateRxInterrupt();
+	}
+	if(rand() % 100 < (int) g_InterruptPercent){
+		_simulateTxInterrupt();
+	}
+}
+
+void _task_block(void){
+	printf("FAIL: the module under test blocked\n");
+	exit(1);
+}
+
+_mqx_uint _lwsem_create(LWSEM_STRUCT_PTR semaphore, _mqx_int initialCount){
+	semaphore->VALUE = initialCount;
+	return MQX_OK;
+}
+
+_mqx_uint _lwsem_post(LWSEM_STRUCT_PTR semaphore){
+	semaphore->VALUE++;
+	return MQX_OK;
+}
+
+// The writer sleeps while the transmit interrupt drains the ring
+_mqx_uint _lwsem_wait(LWSEM_STRUCT_PTR semaphore){
+	g_WriterBlockCount++;
+	if(g_Ring.count > g_MaxCount){
+		g_MaxCount = g_Ring.count;
+	}
+	while(semaphore->VALUE == 0){
+		if(!_simulateTxInterrupt()){
+			printf("FAIL: a writer is waiting on a ring that is not transmitting\n");
+			exit(1);
+		}
+	}
+	semaphore->VALUE--;
+	return MQX_OK;
+}
+
+uart_status_t UART_DRV_SendData(uint32_t instance, const uint8_t* txBuff, uint32_t txSize){
+	if(g_UartState.isTxBusy){
+		return kStatus_UART_TxBusy;
+	}
+	g_UartState.txBuff = txBuff;
+	g_UartState.txSize = txSize;
+	g_UartState.isTxBusy = true;
+	return kStatus_UART_Success;
+}
+
+// Sends one character, as UART_DRV_IRQHandler does on a TX-empty interrupt. Returns false if the UART is idle.
+static bool _simulateTxInterrupt(){
+	if(!g_UartState.isTxBusy){
+		return false;
+	}
+
+	g_IsInInterrupt = true;
+	if(g_WireCount == SIM_WIRE_MAX){
+		printf("FAIL: more characters were sent than written\n");
+		exit(1);
+	}
+	g_IsWireControl[g_WireCount] = (g_UartState.txBuff == &g_Ring.controlCharacter);
+	g_Wire[g_WireCount++] = *g_UartState.txBuff;
+	_handleTxRingCharacterSent(&g_Ring, &g_UartState);
+	if(g_UartState.txSize == 0){
+		g_UartState.isTxBusy = false;
+	}
+	g_IsInInterrupt = false;
+	return true;
+}
+
+// Throttles or resumes the sender, as _handleUartCharacterReceived and _resumeThrottledSender do
+static void _simulateRxInterrupt(){
+	g_IsInInterrupt = true;
+	g_IsThrottled = !g_IsThrottled;
+	g_ControlCount++;
+	_sendTxRingControlCharacter(&g_Ring, g_IsThrottled ? 0x13 : 0x11);
+	g_IsInInterrupt = false;
+}
+
+static void _drainUart(){
+	while(_simulateTxInterrupt());
+}
+
+/*=============================================================
+                           TESTS
+ ==============================================================*/
+
+// Writes far more than the ring holds in one call, so the writer repeatedly fills the ring and waits on it
+static bool _testFullOccupancy(){
+	static char text[3 * TX_RING_SIZE + 17];
+	for(uint32_t i = 0; i < sizeof(text); i++){
+		text[i] = (char)('a' + i % 26);
+	}
+
+	g_WireCount = 0;
+	g_WriterBlockCount = 0;
+	g_MaxCount = 0;
+	_writeToTxRing(&g_Ring, text, sizeof(text));
+	_writeToTxRing(&g_Ring, "\r\n", 2);
+	_drainUart();
+
+	bool isPassing = (g_WireCount == sizeof(text) + 2 && memcmp(g_Wire, text, sizeof(text)) == 0
+			&& g_Wire[sizeof(text)] == '\r' && g_Wire[sizeof(text) + 1] == '\n');
+	printf("Full occupancy: %u characters written, %u sent, writer blocked %u times, max queued %u of %u\n",
+			(uint32_t) sizeof(text) + 2, g_WireCount, g_WriterBlockCount, g_MaxCount, TX_RING_SIZE);
+	if(!isPassing){
+		printf("FAIL: the characters sent differ from those written\n");
+	}
+	if(g_MaxCount != TX_RING_SIZE || g_WriterBlockCount == 0){
+		printf("FAIL: the ring never filled\n");
+		isPassing = false;
+	}
+	if(g_Ring.count != 0 || g_Ring.isTransmitting){
+		printf("FAIL: the ring did not return to idle\n");
+		isPassing = false;
+	}
+	return isPassing;
+}
+
+// Sends text, then a frame whose bytes include XON and XOFF, then more text, while flow control characters
+// are requested at random. Control characters may appear anywhere on the wire except inside the frame.
+static bool _testFrameWhileThrottled(uint32_t interruptPercent){
+	static uint8_t expected[3 * TX_RING_SIZE];
+	uint32_t violationCount = 0;
+	uint32_t controlsSent = 0;
+	uint32_t controlsRequested = 0;
+	g_InterruptPercent = interruptPercent;
+
+	for(uint32_t round = 0; round < SIM_FRAME_ROUNDS; round++){
+		uint32_t textSize = 1 + (uint32_t) rand() % 64;
+		uint32_t frameSize = 2 + (uint32_t) rand() % 246;
+		uint32_t size = 0;
+		for(uint32_t i = 0; i < textSize; i++){
+			expected[size++] = (uint8_t)('a' + i % 26);
+		}
+		uint32_t frameStart = size;
+		for(uint32_t i = 0; i < frameSize; i++){
+			expected[size++] = (i % 3 == 0) ? 0x11 : (i % 3 == 1) ? 0x13 : (uint8_t) rand();
+		}
+		uint32_t frameEnd = size;
+		for(uint32_t i = 0; i < textSize; i++){
+			expected[size++] = (uint8_t)('A' + i % 26);
+		}
+
+		// Throttle before the frame, so it is sent while the sender is held off
+		g_WireCount = 0;
+		g_ControlCount = 0;
+		g_ControlPercent = 0;
+		g_IsThrottled = false;
+		_simulateRxInterrupt();
+		_writeToTxRing(&g_Ring, (const char*) expected, frameStart);
+		g_ControlPercent = 5;
+		_writeFrameToTxRing(&g_Ring, &expected[frameStart], frameEnd - frameStart);
+		_writeToTxRing(&g_Ring, (const char*) &expected[frameEnd], size - frameEnd);
+		g_ControlPercent = 0;
+		_drainUart();
+		if(g_IsThrottled){
+			_simulateRxInterrupt();
+			_drainUart();
+		}
+		controlsRequested += g_ControlCount;
+
+		// Apart from the flow control characters, the wire must carry exactly what was written, and no flow
+		// control character may follow the frame's first character before its last one
+		uint32_t next = 0;
+		for(uint32_t i = 0; i < g_WireCount; i++){
+			if(g_IsWireControl[i]){
+				controlsSent++;
+				if(next > frameStart && next < frameEnd){
+					violationCount++;
+				}
+			}
+			else if(next >= size || g_Wire[i] != expected[next++]){
+				violationCount++;
+			}
+		}
+		if(next != size){
+			violationCount++;
+		}
+	}
+
+	printf("Frames while throttled (%u%% interrupt rate): %u frames, %u flow control characters requested, %u sent, %u violations\n",
+			interruptPercent, SIM_FRAME_ROUNDS, controlsRequested, controlsSent, violationCount);
+	g_InterruptPercent = 30;
+	if(violationCount > 0){
+		printf("FAIL: flow control characters were sent inside a frame, or frame characters were lost\n");
+		return false;
+	}
+	if(controlsSent == 0){
+		printf("FAIL: no flow control characters were sent\n");
+		return false;
+	}
+	return true;
+}
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	srand(1);
+	memset(&g_UartState, 0, sizeof(uart_state_t));
+	_initializeTxRing(&g_Ring, 0);
+
+	bool isPassing = _testFullOccupancy();
+	isPassing = _testFrameWhileThrottled(30) && isPassing;
+	isPassing = _testFrameWhileThrottled(100) && isPassing;
+
+	printf(isPassing ? "PASS\n" : "FAIL\n");
+	return isPassing ? 0 : 1;
+}
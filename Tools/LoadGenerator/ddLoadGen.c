@@ -0,0 +1,494 @@
+// Host load generator for the DDScheduler binary frame protocol.
+//
+// Build (host):  gcc -std=gnu99 -O2 -I../../Sources/TerminalDriver -o ddLoadGen ddLoadGen.c ../../Sources/TerminalDriver/frame.c
+// Usage:         ddLoadGen [options] <serial device | --pty>
+//
+// Sends create requests (or batches of them) as binary frames and matches each response to its request ID,
+// reporting throughput, round-trip latency and protocol errors. With --pty a pseudo-terminal is opened and its
+// slave path printed, so the generator can be attached to a host build or bridged to a board with socat.
+//
+// The board throttles the generator with XOFF when its receive ring backs up, and resumes it with XON. The
+// board only sends these between frames, so they are acted on while the decoder is idle: no frame is sent
+// while paused, and each frame is drained to the line before the next, so at most one frame follows an XOFF.
+// The ring keeps RX_RING_SIZE - RX_RING_HIGH_WATER bytes spare for it, enough for batches of up to 9 creates, or 5 with -a.
+//
+// Options:
+//   -n <count>      Number of tasks to create (default 100)
+//   -r <rate>       Requests sent per second, 0 for as fast as the window allows (default 0)
+//   -w <window>     Requests allowed in flight at once (default 1)
+//   -b <size>       Creates per batch frame, 1 sends single create frames (default 1)
+//   -t <template>   Template index to create (default 0)
+//   -d <deadline>   Deadline in ticks, or microseconds with -u (default 1000)
+//   -u              Deadlines are in microseconds
+//   -a <argument>   Pass each job this argument instead of its template's parameter
+//   -q              Query the active task list after the run
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "frame.h"
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define LOADGEN_MAX_WINDOW 256
+#define LOADGEN_RESPONSE_TIMEOUT_MS 2000
+#define LOADGEN_CREATE_SIZE 6
+#define LOADGEN_ARGUMENT_SIZE 4
+#define LOADGEN_XON 0x11
+#define LOADGEN_XOFF 0x13
+
+/*=============================================================
+                      LOCAL TYPES
+ ==============================================================*/
+
+typedef struct LoadGenOptions{
+	const char* Device;
+	bool UsePty;
+	uint32_t Count;
+	uint32_t Rate;
+	uint32_t Window;
+	uint32_t BatchSize;
+	uint8_t TemplateIndex;
+	uint32_t Deadline;
+	bool Microseconds;
+	bool HasArgument;
+	uint32_t Argument;
+	bool QueryAfterRun;
+} LoadGenOptions;
+
+typedef struct PendingRequest{
+	bool InFlight;
+	uint16_t RequestId;
+	double SentAt;
+	uint32_t Creates;
+} PendingRequest;
+
+// Tracks the board's XON/XOFF flow control
+typedef struct FlowControl{
+	bool IsPaused;						// True from an XOFF until the next XON
+	double PausedAt;
+	uint32_t PauseCount;
+	double PausedMs;					// The total time spent paused
+} FlowControl;
+
+typedef struct LoadGenResults{
+	uint32_t Requests;
+	uint32_t Responses;
+	uint32_t Created;
+	uint32_t Failed;
+	uint32_t Unmatched;
+	double MinLatencyMs;
+	double MaxLatencyMs;
+	double TotalLatencyMs;
+} LoadGenResults;
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static bool _parseOptions(int argc, char* argv[], LoadGenOptions* options);
+static int _openDevice(const LoadGenOptions* options);
+static double _getTimeMs(void);
+static bool _sendFrame(int fd, const Frame* frame);
+static bool _receiveFrame(int fd, FrameDecoderPtr decoder, FlowControl* flow, Frame* frame, int timeoutMs);
+static void _handleFlowControl(FlowControl* flow, uint8_t character);
+static uint32_t _getCreateSize(const LoadGenOptions* options);
+static void _buildCreateFrame(const LoadGenOptions* options, uint16_t requestId, uint32_t creates, Frame* frame);
+static void _handleResponse(const Frame* response, PendingRequest* pending, LoadGenResults* results);
+static void _queryActiveTasks(int fd, FrameDecoderPtr decoder, FlowControl* flow, uint16_t requestId);
+static uint32_t _readUint32(const uint8_t* bytes);
+static uint64_t _readUint64(const uint8_t* bytes);
+static void _printResults(const LoadGenResults* results, const FlowControl* flow, uint32_t decodeErrors, double elapsedMs);
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	LoadGenOptions options;
+	if(!_parseOptions(argc, argv, &options)){
+		fprintf(stderr, "Usage: %s [-n count] [-r rate] [-w window] [-b batch] [-t template] [-d deadline] [-u] [-a argument] [-q] <serial device | --pty>\n", argv[0]);
+		return 2;
+	}
+
+	int fd = _openDevice(&options);
+	if(fd < 0){
+		return 2;
+	}
+
+	FrameDecoder decoder;
+	_initializeFrameDecoder(&decoder);
+	FlowControl flow;
+	memset(&flow, 0, sizeof(flow));
+
+	PendingRequest pending[LOADGEN_MAX_WINDOW];
+	memset(pending, 0, sizeof(pending));
+	LoadGenResults results;
+	memset(&results, 0, sizeof(results));
+	results.MinLatencyMs = 1e9;
+
+	uint16_t nextRequestId = 1;
+	uint32_t createsSent = 0;
+	uint32_t inFlight = 0;
+	double interval = (options.Rate == 0) ? 0 : 1000.0 / options.Rate;
+	double start = _getTimeMs();
+	double nextSendAt = start;
+
+	while(createsSent < options.Count || inFlight > 0){
+		// Send while the window, the rate and the board allow
+		while(createsSent < options.Count && inFlight < options.Window && !flow.IsPaused && _getTimeMs() >= nextSendAt){
+			uint32_t creates = options.Count - createsSent;
+			if(creates > options.BatchSize){
+				creates = options.BatchSize;
+			}
+
+			Frame request;
+			_buildCreateFrame(&options, nextRequestId, creates, &request);
+			if(!_sendFrame(fd, &request)){
+				close(fd);
+				return 2;
+			}
+
+			PendingRequest* slot = &pending[nextRequestId % LOADGEN_MAX_WINDOW];
+			slot->InFlight = true;
+			slot->RequestId = nextRequestId;
+			slot->SentAt = _getTimeMs();
+			slot->Creates = creates;
+
+			nextRequestId = (nextRequestId == UINT16_MAX) ? 1 : nextRequestId + 1;
+			createsSent += creates;
+			inFlight++;
+			results.Requests++;
+			nextSendAt += interval;
+		}
+
+		// Wait for a response, or only until the next send is due when the window has room. While paused, an XON
+		// also ends the wait.
+		int timeoutMs = LOADGEN_RESPONSE_TIMEOUT_MS;
+		if(createsSent < options.Count && inFlight < options.Window && !flow.IsPaused){
+			double untilNextSend = nextSendAt - _getTimeMs();
+			timeoutMs = (untilNextSend > 0) ? (int) untilNextSend + 1 : 0;
+		}
+
+		Frame response;
+		bool wasPaused = flow.IsPaused;
+		if(_receiveFrame(fd, &decoder, &flow, &response, timeoutMs)){
+			PendingRequest* slot = &pending[response.requestId % LOADGEN_MAX_WINDOW];
+			if(slot->InFlight && slot->RequestId == response.requestId){
+				inFlight--;
+			}
+			_handleResponse(&response, slot, &results);
+		}
+		else if(timeoutMs == LOADGEN_RESPONSE_TIMEOUT_MS && !(wasPaused && !flow.IsPaused)){
+			fprintf(stderr, "Timed out with %u requests in flight%s.\n", inFlight, flow.IsPaused ? ", paused by XOFF" : "");
+			break;
+		}
+	}
+
+	_printResults(&results, &flow, decoder.errorCount, _getTimeMs() - start);
+
+	if(options.QueryAfterRun){
+		_queryActiveTasks(fd, &decoder, &flow, nextRequestId);
+	}
+
+	close(fd);
+	return (results.Failed == 0 && results.Responses == results.Requests) ? 0 : 1;
+}
+
+/*=============================================================
+                          OPTIONS
+ ==============================================================*/
+
+static bool _parseOptions(int argc, char* argv[], LoadGenOptions* options){
+	memset(options, 0, sizeof(LoadGenOptions));
+	options->Count = 100;
+	options->Window = 1;
+	options->BatchSize = 1;
+	options->Deadline = 1000;
+
+	int i;
+	for(i=1; i<argc - 1; i++){
+		if(strcmp(argv[i], "-u") == 0){
+			options->Microseconds = true;
+		}
+		else if(strcmp(argv[i], "-q") == 0){
+			options->QueryAfterRun = true;
+		}
+		else if(argv[i][0] == '-' && argv[i][1] != '\0' && argv[i][2] == '\0' && i + 1 < argc - 1){
+			uint32_t value = (uint32_t) strtoul(argv[++i], NULL, 10);
+			switch(argv[i-1][1]){
+				case 'n': options->Count = value; break;
+				case 'r': options->Rate = value; break;
+				case 'w': options->Window = value; break;
+				case 'b': options->BatchSize = value; break;
+				case 't': options->TemplateIndex = (uint8_t) value; break;
+				case 'd': options->Deadline = value; break;
+				case 'a': options->Argument = value; options->HasArgument = true; break;
+				default: return false;
+			}
+		}
+		else{
+			return false;
+		}
+	}
+	if(i != argc - 1){
+		return false;
+	}
+
+	options->UsePty = (strcmp(argv[argc-1], "--pty") == 0);
+	options->Device = argv[argc-1];
+
+	uint32_t maxBatch = (FRAME_MAX_PAYLOAD - 1) / _getCreateSize(options);
+	return options->Window >= 1 && options->Window <= LOADGEN_MAX_WINDOW
+			&& options->BatchSize >= 1 && options->BatchSize <= maxBatch;
+}
+
+/*=============================================================
+                           DEVICE
+ ==============================================================*/
+
+static int _openDevice(const LoadGenOptions* options){
+	int fd;
+	if(options->UsePty){
+		fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if(fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0){
+			perror("Unable to open a pseudo-terminal");
+			return -1;
+		}
+		printf("Pseudo-terminal slave: %s\n", ptsname(fd));
+		printf("Attach the target to it, then press enter to start.\n");
+		getchar();
+	}
+	else{
+		fd = open(options->Device, O_RDWR | O_NOCTTY);
+		if(fd < 0){
+			fprintf(stderr, "Unable to open %s: %s\n", options->Device, strerror(errno));
+			return -1;
+		}
+	}
+
+	// Raw 8N1 at the board's terminal rate, so frames pass through unmodified. Raw mode also turns IXON off,
+	// which binary mode needs: frame bytes may equal XON or XOFF, so _receiveFrame acts on them itself.
+	struct termios attributes;
+	if(tcgetattr(fd, &attributes) == 0){
+		cfmakeraw(&attributes);
+		cfsetispeed(&attributes, B115200);
+		cfsetospeed(&attributes, B115200);
+		tcsetattr(fd, TCSANOW, &attributes);
+	}
+	return fd;
+}
+
+static double _getTimeMs(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+static bool _sendFrame(int fd, const Frame* frame){
+	uint8_t buffer[FRAME_MAX_ENCODED_SIZE];
+	int size = _encodeFrame((const FramePtr) frame, buffer);
+	for(int written = 0; written < size;){
+		ssize_t result = write(fd, &buffer[written], size - written);
+		if(result < 0){
+			perror("Unable to write a frame");
+			return false;
+		}
+		written += result;
+	}
+
+	// Hold the frame until it has left, so no more than one frame is committed to the line when XOFF arrives
+	tcdrain(fd);
+	return true;
+}
+
+// Returns false if no complete frame arrived within the timeout, or once an XON resumes a paused sender. XON and
+// XOFF between frames update the flow control, and other terminal text between frames is ignored.
+static bool _receiveFrame(int fd, FrameDecoderPtr decoder, FlowControl* flow, Frame* frame, int timeoutMs){
+	double deadline = _getTimeMs() + timeoutMs;
+	while(1){
+		int remainingMs = (int)(deadline - _getTimeMs());
+		struct pollfd pollFd = { fd, POLLIN, 0 };
+		if(poll(&pollFd, 1, remainingMs > 0 ? remainingMs : 0) <= 0){
+			return false;
+		}
+
+		uint8_t character;
+		if(read(fd, &character, 1) != 1){
+			return false;
+		}
+		if(!_isFrameInProgress(decoder) && (character == LOADGEN_XON || character == LOADGEN_XOFF)){
+			bool wasPaused = flow->IsPaused;
+			_handleFlowControl(flow, character);
+			if(wasPaused && !flow->IsPaused){
+				return false;
+			}
+			continue;
+		}
+		if(_decodeFrameCharacter(decoder, character) == FRAME_DECODE_COMPLETE){
+			_copyDecodedFrame(decoder, frame);
+			return true;
+		}
+	}
+}
+
+static void _handleFlowControl(FlowControl* flow, uint8_t character){
+	bool isPaused = (character == LOADGEN_XOFF);
+	if(isPaused == flow->IsPaused){
+		return;
+	}
+
+	flow->IsPaused = isPaused;
+	if(isPaused){
+		flow->PauseCount++;
+		flow->PausedAt = _getTimeMs();
+	}
+	else{
+		flow->PausedMs += _getTimeMs() - flow->PausedAt;
+	}
+}
+
+/*=============================================================
+                          REQUESTS
+ ==============================================================*/
+
+static uint32_t _getCreateSize(const LoadGenOptions* options){
+	return options->HasArgument ? LOADGEN_CREATE_SIZE + LOADGEN_ARGUMENT_SIZE : LOADGEN_CREATE_SIZE;
+}
+
+static void _appendCreate(const LoadGenOptions* options, uint8_t* payload){
+	payload[0] = options->TemplateIndex;
+	payload[1] = (options->Microseconds ? FRAME_CREATE_FLAG_MICROSECONDS : 0) | (options->HasArgument ? FRAME_CREATE_FLAG_ARGUMENT : 0);
+	for(int i=0; i<4; i++){
+		payload[2 + i] = (options->Deadline >> (8 * i)) & 0xFF;
+		if(options->HasArgument){
+			payload[LOADGEN_CREATE_SIZE + i] = (options->Argument >> (8 * i)) & 0xFF;
+		}
+	}
+}
+
+static void _buildCreateFrame(const LoadGenOptions* options, uint16_t requestId, uint32_t creates, Frame* frame){
+	frame->requestId = requestId;
+	if(options->BatchSize == 1){
+		frame->opcode = FRAME_OPCODE_CREATE;
+		frame->length = _getCreateSize(options);
+		_appendCreate(options, frame->payload);
+		return;
+	}
+
+	frame->opcode = FRAME_OPCODE_BATCH;
+	frame->payload[0] = (uint8_t) creates;
+	frame->length = 1 + creates * _getCreateSize(options);
+	for(uint32_t i=0; i<creates; i++){
+		_appendCreate(options, &frame->payload[1 + i * _getCreateSize(options)]);
+	}
+}
+
+// Every response payload starts with a status byte and the board time at which it was served
+static void _handleResponse(const Frame* response, PendingRequest* pending, LoadGenResults* results){
+	if(!pending->InFlight || pending->RequestId != response->requestId || response->length < FRAME_RESPONSE_HEADER_SIZE){
+		results->Unmatched++;
+		return;
+	}
+	pending->InFlight = false;
+
+	double latency = _getTimeMs() - pending->SentAt;
+	results->Responses++;
+	results->TotalLatencyMs += latency;
+	if(latency < results->MinLatencyMs){
+		results->MinLatencyMs = latency;
+	}
+	if(latency > results->MaxLatencyMs){
+		results->MaxLatencyMs = latency;
+	}
+
+	// Count task IDs returned, where an ID of 0 is a failed creation
+	uint32_t idOffset = (response->opcode == (FRAME_OPCODE_BATCH | FRAME_RESPONSE_FLAG)) ?
+			FRAME_RESPONSE_HEADER_SIZE + 1 : FRAME_RESPONSE_HEADER_SIZE;
+	for(uint32_t i = idOffset; i + 4 <= response->length; i += 4){
+		if(_readUint32(&response->payload[i]) != 0){
+			results->Created++;
+		}
+		else{
+			results->Failed++;
+		}
+	}
+	if(response->payload[0] != FRAME_STATUS_OK && response->length <= idOffset){
+		results->Failed += pending->Creates;
+	}
+}
+
+static void _queryActiveTasks(int fd, FrameDecoderPtr decoder, FlowControl* flow, uint16_t requestId){
+	Frame request = { requestId, FRAME_OPCODE_QUERY, 1, { FRAME_QUERY_ACTIVE } };
+	Frame response;
+
+	// Wait out a pause first; frames arriving meanwhile are late responses to the run. An XON ends a wait early,
+	// so each wait runs to a deadline.
+	double deadline = _getTimeMs() + LOADGEN_RESPONSE_TIMEOUT_MS;
+	while(flow->IsPaused && _getTimeMs() < deadline){
+		_receiveFrame(fd, decoder, flow, &response, (int)(deadline - _getTimeMs()) + 1);
+	}
+
+	bool isAnswered = false;
+	if(!flow->IsPaused && _sendFrame(fd, &request)){
+		deadline = _getTimeMs() + LOADGEN_RESPONSE_TIMEOUT_MS;
+		while(!isAnswered && _getTimeMs() < deadline){
+			isAnswered = _receiveFrame(fd, decoder, flow, &response, (int)(deadline - _getTimeMs()) + 1);
+		}
+	}
+	uint8_t count = (isAnswered && response.length > FRAME_RESPONSE_HEADER_SIZE) ? response.payload[FRAME_RESPONSE_HEADER_SIZE] : 0;
+	if(!isAnswered || response.length != FRAME_RESPONSE_HEADER_SIZE + 1 + count * FRAME_TASK_ENTRY_SIZE){
+		fprintf(stderr, "No response to the active task query.\n");
+		return;
+	}
+
+	// Times are in microseconds since the board booted
+	printf("\nActive tasks at %" PRIu64 " us%s:\n", _readUint64(&response.payload[1]),
+			response.payload[0] == FRAME_STATUS_TRUNCATED ? " (truncated)" : "");
+	for(uint32_t i=0; i<count; i++){
+		const uint8_t* entry = &response.payload[FRAME_RESPONSE_HEADER_SIZE + 1 + i * FRAME_TASK_ENTRY_SIZE];
+		printf("  Task %u deadline %" PRIu64 " us created %" PRIu64 " us\n", _readUint32(entry), _readUint64(&entry[4]),
+				_readUint64(&entry[12]));
+	}
+}
+
+static uint32_t _readUint32(const uint8_t* bytes){
+	return bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+static uint64_t _readUint64(const uint8_t* bytes){
+	return _readUint32(bytes) | ((uint64_t) _readUint32(&bytes[4]) << 32);
+}
+
+/*=============================================================
+                           OUTPUT
+ ==============================================================*/
+
+static void _printResults(const LoadGenResults* results, const FlowControl* flow, uint32_t decodeErrors, double elapsedMs){
+	printf("Requests sent:     %u\n", results->Requests);
+	printf("Responses:         %u\n", results->Responses);
+	printf("Tasks created:     %u\n", results->Created);
+	printf("Creates failed:    %u\n", results->Failed);
+	printf("Unmatched frames:  %u\n", results->Unmatched);
+	printf("Bad frames:        %u\n", decodeErrors);
+	printf("Flow control:      %u pauses, %.1f ms paused\n", flow->PauseCount,
+			flow->PausedMs + (flow->IsPaused ? _getTimeMs() - flow->PausedAt : 0));
+	printf("Elapsed:           %.1f ms\n", elapsedMs);
+	if(results->Responses > 0){
+		printf("Throughput:        %.1f creates/s\n", results->Created * 1000.0 / elapsedMs);
+		printf("Latency (ms):      min %.2f  avg %.2f  max %.2f\n", results->MinLatencyMs,
+				results->TotalLatencyMs / results->Responses, results->MaxLatencyMs);
+	}
+}
@@ -0,0 +1,376 @@
+// Host converter from a DDScheduler task trace dump to the Chrome trace event format.
+//
+// Build (host):  gcc -std=gnu99 -O2 -o ddTraceExport ddTraceExport.c
+// Usage:         ddTraceExport [console log] [output.json]
+//
+// Reads a console capture containing the output of the "x dump" command (other console lines are ignored) and
+// writes JSON that chrome://tracing and ui.perfetto.dev open as a timeline. The trace has three processes:
+//   CPU    one track showing which task the dispatcher was running
+//   Jobs   one track per job with its lifetime, when it ran, priority changes and a marker at its deadline
+//   Tasks  one track per other task, such as the scheduler, interfaces and idle task
+// Reads standard input and writes standard output when files are not given.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+/*=============================================================
+                         CONSTANTS
+ ==============================================================*/
+
+#define TRACE_LINE_SIZE 256
+#define TRACE_NAME_SIZE 32
+#define TRACE_TEMPLATE_MAX 64
+
+#define TRACE_PID_CPU 1
+#define TRACE_PID_JOBS 2
+#define TRACE_PID_TASKS 3
+
+/*=============================================================
+                      LOCAL TYPES
+ ==============================================================*/
+
+typedef struct TraceRecord{
+	uint64_t Cycles;
+	char Type;
+	uint32_t TaskId;
+	uint32_t Argument;
+} TraceRecord;
+
+typedef struct TaskName{
+	uint32_t TaskId;
+	char Name[TRACE_NAME_SIZE];
+} TaskName;
+
+// Defines what is known of one task from the trace
+typedef struct TraceTask{
+	uint32_t TaskId;
+	bool IsJob;
+	int32_t TemplateIndex;
+	double CreatedUs;
+	double DeadlineUs;				// Absolute, or negative if the job's deadline was not traced
+	double EndedUs;					// Negative if the job had not ended when the trace stopped
+	char Outcome;					// 'F' for finished, 'E' for expired, 0 if still running
+} TraceTask;
+
+typedef struct TraceDump{
+	uint32_t CyclesPerSecond;
+	uint32_t DroppedCount;
+	char Templates[TRACE_TEMPLATE_MAX][TRACE_NAME_SIZE];
+	uint32_t TemplateCount;
+	TaskName* Names;
+	uint32_t NameCount;
+	TraceRecord* Records;
+	uint32_t RecordCount;
+	TraceTask* Tasks;
+	uint32_t TaskCount;
+} TraceDump;
+
+/*=============================================================
+                      FUNCTION PROTOTYPES
+ ==============================================================*/
+
+static bool _readDump(FILE* input, TraceDump* dump);
+static void* _append(void* array, uint32_t* count, size_t size);
+static double _getTimeUs(const TraceDump* dump, uint64_t cycles);
+static TraceTask* _findOrAddTask(TraceDump* dump, uint32_t taskId);
+static const TraceTask* _findTask(const TraceDump* dump, uint32_t taskId);
+static void _collectTasks(TraceDump* dump);
+static void _getTaskLabel(const TraceDump* dump, const TraceTask* task, char* label, size_t size);
+static void _writeTrace(FILE* output, const TraceDump* dump);
+static void _writeEventStart(FILE* output, bool* isFirst);
+static void _writeJsonString(FILE* output, const char* text);
+
+/*=============================================================
+                            MAIN
+ ==============================================================*/
+
+int main(int argc, char* argv[]){
+	if(argc > 3){
+		fprintf(stderr, "Usage: %s [console log] [output.json]\n", argv[0]);
+		return 2;
+	}
+
+	FILE* input = (argc > 1) ? fopen(argv[1], "r") : stdin;
+	if(input == NULL){
+		perror("Unable to open the console log");
+		return 2;
+	}
+
+	TraceDump dump;
+	memset(&dump, 0, sizeof(dump));
+	if(!_readDump(input, &dump)){
+		fprintf(stderr, "No complete \"#trace begin\" ... \"#trace end\" dump was found.\n");
+		return 1;
+	}
+	if(input != stdin){
+		fclose(input);
+	}
+
+	FILE* output = (argc > 2) ? fopen(argv[2], "w") : stdout;
+	if(output == NULL){
+		perror("Unable to open the output file");
+		return 2;
+	}
+
+	_collectTasks(&dump);
+	_writeTrace(output, &dump);
+	if(output != stdout){
+		fclose(output);
+	}
+
+	fprintf(stderr, "Converted %u events for %u tasks", dump.RecordCount, dump.TaskCount);
+	if(dump.DroppedCount > 0){
+		fprintf(stderr, "; %u events were dropped after the buffer filled", dump.DroppedCount);
+	}
+	fprintf(stderr, ".\n");
+	return 0;
+}
+
+/*=============================================================
+                            INPUT
+ ==============================================================*/
+
+// Reads the first complete dump in the log. Lines that do not parse are skipped, since other tasks may print
+// to the console while the dump is being written.
+static bool _readDump(FILE* input, TraceDump* dump){
+	char line[TRACE_LINE_SIZE];
+	bool isInDump = false;
+	while(fgets(line, sizeof(line), input) != NULL){
+		line[strcspn(line, "\r\n")] = '\0';
+
+		uint32_t index;
+		uint32_t taskId;
+		char name[TRACE_NAME_SIZE];
+		if(!isInDump){
+			uint32_t count;
+			isInDump = sscanf(line, "#trace begin %u %u %u", &dump->CyclesPerSecond, &count, &dump->DroppedCount) == 3
+					&& dump->CyclesPerSecond != 0;
+		}
+		else if(strcmp(line, "#trace end") == 0){
+			return true;
+		}
+		else if(sscanf(line, "template %u %31[^\n]", &index, name) == 2 && index < TRACE_TEMPLATE_MAX){
+			strcpy(dump->Templates[index], name);
+			if(index >= dump->TemplateCount){
+				dump->TemplateCount = index + 1;
+			}
+		}
+		else if(sscanf(line, "task %u %31[^\n]", &taskId, name) == 2){
+			TaskName* taskName = _append(&dump->Names, &dump->NameCount, sizeof(TaskName));
+			taskName->TaskId = taskId;
+			strcpy(taskName->Name, name);
+		}
+		else{
+			TraceRecord record;
+			if(sscanf(line, "event %" SCNx64 " %c %u %u", &record.Cycles, &record.Type, &record.TaskId, &record.Argument) == 4){
+				*(TraceRecord*) _append(&dump->Records, &dump->RecordCount, sizeof(TraceRecord)) = record;
+			}
+		}
+	}
+	return false;
+}
+
+// Grows the array by one element and returns the new, zeroed element
+static void* _append(void* array, uint32_t* count, size_t size){
+	void** arrayPtr = (void**) array;
+	if((*count & (*count - 1)) == 0){
+		uint32_t capacity = (*count == 0) ? 16 : *count * 2;
+		void* grown = realloc(*arrayPtr, capacity * size);
+		if(grown == NULL){
+			fprintf(stderr, "Out of memory.\n");
+			exit(2);
+		}
+		*arrayPtr = grown;
+	}
+	void* element = (char*) *arrayPtr + (*count)++ * size;
+	memset(element, 0, size);
+	return element;
+}
+
+/*=============================================================
+                           TASKS
+ ==============================================================*/
+
+// Times are in microseconds from the first event
+static double _getTimeUs(const TraceDump* dump, uint64_t cycles){
+	return (double)(cycles - dump->Records[0].Cycles) * 1e6 / dump->CyclesPerSecond;
+}
+
+static TraceTask* _findOrAddTask(TraceDump* dump, uint32_t taskId){
+	TraceTask* task = (TraceTask*) _findTask(dump, taskId);
+	if(task != NULL){
+		return task;
+	}
+
+	task = _append(&dump->Tasks, &dump->TaskCount, sizeof(TraceTask));
+	task->TaskId = taskId;
+	task->TemplateIndex = -1;
+	task->DeadlineUs = -1;
+	task->EndedUs = -1;
+	return task;
+}
+
+static const TraceTask* _findTask(const TraceDump* dump, uint32_t taskId){
+	for(uint32_t i = 0; i < dump->TaskCount; i++){
+		if(dump->Tasks[i].TaskId == taskId){
+			return &dump->Tasks[i];
+		}
+	}
+	return NULL;
+}
+
+// Every task in the trace is known once this returns
+static void _collectTasks(TraceDump* dump){
+	for(uint32_t i = 0; i < dump->RecordCount; i++){
+		TraceRecord* record = &dump->Records[i];
+		TraceTask* task = _findOrAddTask(dump, record->TaskId);
+		double now = _getTimeUs(dump, record->Cycles);
+		switch(record->Type){
+			case 'C':
+				task->IsJob = true;
+				task->TemplateIndex = record->Argument;
+				task->CreatedUs = now;
+				break;
+			case 'D':
+				task->DeadlineUs = task->CreatedUs + record->Argument;
+				break;
+			case 'E':
+			case 'F':
+				task->EndedUs = now;
+				task->Outcome = record->Type;
+				break;
+		}
+	}
+}
+
+static void _getTaskLabel(const TraceDump* dump, const TraceTask* task, char* label, size_t size){
+	if(task->IsJob && task->TemplateIndex >= 0 && (uint32_t) task->TemplateIndex < dump->TemplateCount){
+		snprintf(label, size, "%s %u", dump->Templates[task->TemplateIndex], task->TaskId);
+		return;
+	}
+	for(uint32_t i = 0; i < dump->NameCount; i++){
+		if(dump->Names[i].TaskId == task->TaskId){
+			snprintf(label, size, "%s %u", dump->Names[i].Name, task->TaskId);
+			return;
+		}
+	}
+	snprintf(label, size, "%s %u", task->IsJob ? "Job" : "Task", task->TaskId);
+}
+
+/*=============================================================
+                           OUTPUT
+ ==============================================================*/
+
+static void _writeTrace(FILE* output, const TraceDump* dump){
+	bool isFirst = true;
+	char label[2 * TRACE_NAME_SIZE];
+	fprintf(output, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":%u},\"traceEvents\":[", dump->DroppedCount);
+
+	// Name the processes and tracks. Jobs are sorted by creation and tasks by first appearance.
+	const char* processNames[] = { "CPU", "Jobs", "Tasks" };
+	for(int pid = TRACE_PID_CPU; pid <= TRACE_PID_TASKS; pid++){
+		_writeEventStart(output, &isFirst);
+		fprintf(output, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"%s\"}}", pid, processNames[pid - 1]);
+		_writeEventStart(output, &isFirst);
+		fprintf(output, "{\"ph\":\"M\",\"name\":\"process_sort_index\",\"pid\":%d,\"tid\":0,\"args\":{\"sort_index\":%d}}", pid, pid);
+	}
+	_writeEventStart(output, &isFirst);
+	fprintf(output, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"Running\"}}", TRACE_PID_CPU);
+	for(uint32_t i = 0; i < dump->TaskCount; i++){
+		const TraceTask* task = &dump->Tasks[i];
+		int pid = task->IsJob ? TRACE_PID_JOBS : TRACE_PID_TASKS;
+		_getTaskLabel(dump, task, label, sizeof(label));
+		_writeEventStart(output, &isFirst);
+		fprintf(output, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", pid, task->TaskId);
+		_writeJsonString(output, label);
+		fprintf(output, "}}");
+		_writeEventStart(output, &isFirst);
+		fprintf(output, "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":%d,\"tid\":%u,\"args\":{\"sort_index\":%u}}", pid, task->TaskId, i);
+	}
+
+	double endUs = (dump->RecordCount == 0) ? 0 : _getTimeUs(dump, dump->Records[dump->RecordCount - 1].Cycles);
+
+	// Job lifetimes, from admission to completion or expiry, with a marker at each deadline
+	for(uint32_t i = 0; i < dump->TaskCount; i++){
+		const TraceTask* task = &dump->Tasks[i];
+		if(!task->IsJob){
+			continue;
+		}
+
+		double lifetimeEndUs = (task->EndedUs >= 0) ? task->EndedUs : endUs;
+		const char* outcome = (task->Outcome == 'F') ? "finished" : (task->Outcome == 'E') ? "expired" : "running";
+		_writeEventStart(output, &isFirst);
+		fprintf(output, "{\"ph\":\"X\",\"name\":\"job\",\"cat\":\"job\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+				"\"args\":{\"template\":%d,\"outcome\":\"%s\"}}",
+				TRACE_PID_JOBS, task->TaskId, task->CreatedUs, lifetimeEndUs - task->CreatedUs, task->TemplateIndex, outcome);
+
+		if(task->DeadlineUs >= 0){
+			_writeEventStart(output, &isFirst);
+			fprintf(output, "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"deadline\",\"cat\":\"deadline\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,"
+					"\"args\":{\"relativeUs\":%.3f}}",
+					TRACE_PID_JOBS, task->TaskId, task->DeadlineUs, task->DeadlineUs - task->CreatedUs);
+		}
+		if(task->Outcome == 'E'){
+			_writeEventStart(output, &isFirst);
+			fprintf(output, "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"deadline missed\",\"cat\":\"deadline\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f}",
+					TRACE_PID_JOBS, task->TaskId, task->EndedUs);
+		}
+	}
+
+	// Running slices end at the next switch, or at the last event for the task still running when tracing stopped
+	const TraceRecord* running = NULL;
+	for(uint32_t i = 0; i <= dump->RecordCount; i++){
+		const TraceRecord* record = (i < dump->RecordCount) ? &dump->Records[i] : NULL;
+		if(record != NULL && record->Type == 'P'){
+			const TraceTask* task = _findTask(dump, record->TaskId);
+			_writeEventStart(output, &isFirst);
+			fprintf(output, "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"priority %u\",\"cat\":\"priority\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,"
+					"\"args\":{\"priority\":%u}}",
+					record->Argument, task->IsJob ? TRACE_PID_JOBS : TRACE_PID_TASKS, record->TaskId,
+					_getTimeUs(dump, record->Cycles), record->Argument);
+		}
+		if(record != NULL && record->Type != 'S'){
+			continue;
+		}
+
+		if(running != NULL){
+			const TraceTask* task = _findTask(dump, running->TaskId);
+			double startUs = _getTimeUs(dump, running->Cycles);
+			double durationUs = ((record != NULL) ? _getTimeUs(dump, record->Cycles) : endUs) - startUs;
+			_getTaskLabel(dump, task, label, sizeof(label));
+
+			_writeEventStart(output, &isFirst);
+			fprintf(output, "{\"ph\":\"X\",\"name\":");
+			_writeJsonString(output, label);
+			fprintf(output, ",\"cat\":\"cpu\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}", TRACE_PID_CPU, startUs, durationUs);
+			_writeEventStart(output, &isFirst);
+			fprintf(output, "{\"ph\":\"X\",\"name\":\"running\",\"cat\":\"cpu\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					task->IsJob ? TRACE_PID_JOBS : TRACE_PID_TASKS, task->TaskId, startUs, durationUs);
+		}
+		running = record;
+	}
+
+	fprintf(output, "\n]}\n");
+}
+
+static void _writeEventStart(FILE* output, bool* isFirst){
+	fprintf(output, *isFirst ? "\n" : ",\n");
+	*isFirst = false;
+}
+
+static void _writeJsonString(FILE* output, const char* text){
+	fputc('"', output);
+	for(; *text != '\0'; text++){
+		if(*text == '"' || *text == '\\'){
+			fputc('\\', output);
+		}
+		if((unsigned char) *text >= 0x20){
+			fputc(*text, output);
+		}
+	}
+	fputc('"', output);
+}